@@ -0,0 +1,519 @@
+// microbench.cpp
+//
+// Microbenchmarks for the message hot path
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QHostAddress>
+
+#include "addressfilter.h"
+#include "cmdswitch.h"
+#include "fieldfilter.h"
+#include "message.h"
+#include "microbench.h"
+#include "patternfilter.h"
+#include "profile.h"
+
+//
+// Stand-ins for the daemon's local logging, which Message uses to
+// report malformed input
+//
+bool debug=false;
+bool no_local_syslog=true;
+void LocalSyslog(Message::Severity severity,const char *fmt,...)
+{
+}
+
+//
+// Allocation Counting
+//
+// Every heap allocation made by Qt and by libstdc++ comes through one of
+// these, so wrapping the glibc entry points is enough to count them.
+// The benchmarks are single threaded.
+//
+static uint64_t __microbench_allocations=0;
+
+extern "C" {
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb,size_t size);
+extern void *__libc_realloc(void *ptr,size_t size);
+
+void *malloc(size_t size) __THROW
+{
+  __microbench_allocations++;
+  return __libc_malloc(size);
+}
+
+
+void *calloc(size_t nmemb,size_t size) __THROW
+{
+  __microbench_allocations++;
+  return __libc_calloc(nmemb,size);
+}
+
+
+void *realloc(void *ptr,size_t size) __THROW
+{
+  __microbench_allocations++;
+  return __libc_realloc(ptr,size);
+}
+}
+
+//
+// Inputs, modelled on what Axia xNodes, consoles and engines send in
+// the field: RFC 3164 with the node's IP address or name as the
+// hostname, and RFC 5424 from newer firmware.
+//
+static const char *__microbench_rfc3164[]={
+  "<134>Oct 19 07:37:10 10.216.1.21 Node: Source 1 \"STUDIO A MIC 1\""
+  " stream 21001 started, RTP 239.192.82.9:5004",
+  "<132>Oct 19 07:37:11 10.216.1.21 Clock: clock master changed to"
+  " 10.216.1.3 (priority 5)",
+  "<131>Oct 19 07:37:11 10.216.1.40 Audio: Destination 4 \"PGM AIR\" lost"
+  " stream 21017 (no packets for 500 ms)",
+  "<134>Oct 19 07:37:12 xnode-aes-3 LWRP[412]: GPO 3 CMD \"lLLLL\" from"
+  " 10.216.1.50:93",
+  "<133>Oct 19 07:37:14 element-studio-b Console: Show profile \"MORNING"
+  " DRIVE\" loaded by user 'board-op'",
+  "<134>Oct  9 07:37:15 10.216.2.7 Switch: port Gi1/0/17 IGMP join"
+  " 239.192.82.9 vlan 10",
+  NULL
+};
+static const char *__microbench_rfc5424[]={
+  "<134>1 2026-10-19T07:37:10.231Z xnode-studio-a Node 212 SRC - Source 1"
+  " \"STUDIO A MIC 1\" stream 21001 started",
+  "<132>1 2026-10-19T07:37:11.004-04:00 10.216.1.21 Clock - CLK [meta"
+  " sequenceId=\"8812\"] clock master changed to 10.216.1.3",
+  "<131>1 2026-10-19T07:37:11.517Z qor-engine-1 Audio 88 DST [origin"
+  " ip=\"10.216.1.40\"] Destination 4 \"PGM AIR\" lost stream 21017",
+  "<134>1 2026-10-19T07:37:12.880Z xnode-aes-3 LWRP 412 GPIO - GPO 3 CMD"
+  " \"lLLLL\" from 10.216.1.50:93",
+  "<133>1 2026-10-19T07:37:14.102Z element-studio-b Console 1030 SHOW -"
+  " Show profile \"MORNING DRIVE\" loaded by user 'board-op'",
+  NULL
+};
+static const char *__microbench_sources[]={
+  "10.216.1.21","10.216.1.40","10.216.2.7","192.168.10.5","172.16.4.20",
+  "fd00:216::21","2001:db8::7",NULL
+};
+static const char *__microbench_match_patterns[]={
+  "lost stream","clock master changed","/link (up|down)/i",
+  "/stream [0-9]+ (started|stopped)/",NULL
+};
+static const char *__microbench_exclude_patterns[]={
+  "GPO","heartbeat","/^keepalive/",NULL
+};
+static const char *__microbench_host_patterns[]={
+  "xnode-*","qor-engine-1","*-studio-a","element-studio-[ab]",
+  "10.216.1.2?",NULL
+};
+static const char *__microbench_config=
+  "[Global]\n"
+  "ServiceUser=lwsyslogger\n"
+  "ServiceGroup=lwsyslogger\n"
+  "LogRoot=/var/log/lwsyslogger\n"
+  "\n"
+  "[Receiver]\n"
+  "Id=Default\n"
+  "Type=UDP\n"
+  "Port=514\n"
+  "Processor=Default\n"
+  "Processor=ByHostname\n"
+  "Processor=Alerts\n"
+  "\n"
+  "[Processor]\n"
+  "Id=Default\n"
+  "Type=SimpleFile\n"
+  "BaseFilename=syslog\n"
+  "Template=%t %h %m\n"
+  "Facility=SYSLOG,USER,LOCAL0,LOCAL1\n"
+  "Severity=DEBUG+\n"
+  "UpstreamAddress=10.216.0.0/16\n"
+  "UpstreamAddress=192.168.10.0/24\n"
+  "UpstreamAddress=fd00:216::/32\n"
+  "DeduplicationTimeout=5\n"
+  "LogRotationTime=00:00\n"
+  "LogRotationSize=1000000\n"
+  "LogRotationAge=30\n"
+  "OldLogPurgeAge=60\n"
+  "\n"
+  "[Processor]\n"
+  "Id=ByHostname\n"
+  "Type=FileByHostname\n"
+  "BaseDirname=hosts\n"
+  "Template=%T %h %S %m\n"
+  "Facility=LOCAL0,LOCAL1\n"
+  "Severity=INFO+\n"
+  "UpstreamAddress=10.216.0.0/16\n"
+  "DeduplicationTimeout=5\n"
+  "LogRotationTime=00:00\n"
+  "OldLogPurgeAge=90\n"
+  "\n"
+  "[Processor]\n"
+  "Id=Alerts\n"
+  "Type=Sendmail\n"
+  "Facility=LOCAL0\n"
+  "Severity=ERR+\n"
+  "UpstreamAddress=10.216.1.0/24\n"
+  "EmailFromAddress=lwsyslogger@example.com\n"
+  "EmailToAddress=engineering@example.com\n"
+  "DeduplicationTimeout=300\n";
+
+static QList<QByteArray> __microbench_rfc3164_data;
+static QList<QByteArray> __microbench_rfc5424_data;
+static QList<Message> __microbench_messages;
+static QList<Message> __microbench_duplicates;
+static QList<QHostAddress> __microbench_addresses;
+static AddressFilter *__microbench_filter=NULL;
+static PatternFilter *__microbench_pattern_filter=NULL;
+static FieldFilter *__microbench_field_filter=NULL;
+static QString __microbench_config_filename;
+
+//
+// Results are folded in here so that the compiler cannot discard the
+// work being measured.
+//
+static volatile uint64_t __microbench_sink=0;
+
+
+void MessageParseRfc3164(uint64_t iterations)
+{
+  int n=__microbench_rfc3164_data.size();
+
+  for(uint64_t i=0;i<iterations;i++) {
+    Message msg(__microbench_rfc3164_data.at(i%n));
+    __microbench_sink+=msg.isValid();
+  }
+}
+
+
+void MessageParseRfc5424(uint64_t iterations)
+{
+  int n=__microbench_rfc5424_data.size();
+
+  for(uint64_t i=0;i<iterations;i++) {
+    Message msg(__microbench_rfc5424_data.at(i%n));
+    __microbench_sink+=msg.isValid();
+  }
+}
+
+
+void ResolveWildcardsDefault(uint64_t iterations)
+{
+  int n=__microbench_messages.size();
+  QString fmt="%t %h %m";
+
+  for(uint64_t i=0;i<iterations;i++) {
+    __microbench_sink+=__microbench_messages[i%n].
+      resolveWildcards(fmt,__microbench_addresses.at(i%n)).size();
+  }
+}
+
+
+void ResolveWildcardsFull(uint64_t iterations)
+{
+  int n=__microbench_messages.size();
+  QString fmt="%P %p %f %F %s %S %t %T %r %h %m";
+
+  for(uint64_t i=0;i<iterations;i++) {
+    __microbench_sink+=__microbench_messages[i%n].
+      resolveWildcards(fmt,__microbench_addresses.at(i%n)).size();
+  }
+}
+
+
+void ToByteArrayV0(uint64_t iterations)
+{
+  int n=__microbench_messages.size();
+
+  for(uint64_t i=0;i<iterations;i++) {
+    __microbench_sink+=__microbench_messages[i%n].toByteArray(0).size();
+  }
+}
+
+
+void ToByteArrayV1(uint64_t iterations)
+{
+  int n=__microbench_messages.size();
+
+  for(uint64_t i=0;i<iterations;i++) {
+    __microbench_sink+=__microbench_messages[i%n].toByteArray(1).size();
+  }
+}
+
+
+void IsDuplicateOfMatch(uint64_t iterations)
+{
+  int n=__microbench_messages.size();
+
+  for(uint64_t i=0;i<iterations;i++) {
+    __microbench_sink+=__microbench_messages.at(i%n).
+      isDuplicateOf(__microbench_duplicates.at(i%n));
+  }
+}
+
+
+void IsDuplicateOfDiffer(uint64_t iterations)
+{
+  int n=__microbench_messages.size();
+
+  for(uint64_t i=0;i<iterations;i++) {
+    __microbench_sink+=__microbench_messages.at(i%n).
+      isDuplicateOf(__microbench_messages.at((i+1)%n));
+  }
+}
+
+
+void AddressFilterContains(uint64_t iterations)
+{
+  int n=__microbench_addresses.size();
+
+  for(uint64_t i=0;i<iterations;i++) {
+    __microbench_sink+=
+      __microbench_filter->contains(__microbench_addresses.at(i%n));
+  }
+}
+
+
+void PatternFilterAccepts(uint64_t iterations)
+{
+  int n=__microbench_messages.size();
+
+  for(uint64_t i=0;i<iterations;i++) {
+    __microbench_sink+=__microbench_pattern_filter->
+      accepts(__microbench_messages.at(i%n).msg().toUtf8());
+  }
+}
+
+
+void FieldFilterContains(uint64_t iterations)
+{
+  int n=__microbench_messages.size();
+
+  for(uint64_t i=0;i<iterations;i++) {
+    __microbench_sink+=__microbench_field_filter->
+      contains(__microbench_messages.at(i%n).hostName());
+  }
+}
+
+
+void ProfileLoad(uint64_t iterations)
+{
+  for(uint64_t i=0;i<iterations;i++) {
+    Profile *p=new Profile(true);
+    __microbench_sink+=p->loadFile(__microbench_config_filename);
+    delete p;
+  }
+}
+
+
+Microbench::Microbench(int run_msecs)
+{
+  d_run_msecs=run_msecs;
+}
+
+
+void Microbench::add(const QString &name,Function func)
+{
+  d_names.push_back(name);
+  d_functions.push_back(func);
+}
+
+
+void Microbench::run(const QString &filter) const
+{
+  uint64_t iterations=0;
+  uint64_t allocs=0;
+  int64_t elapsed=0;
+
+  printf("%-28s %12s %12s %12s\n","benchmark","iterations","ns/op",
+	 "allocs/op");
+  for(int i=0;i<d_names.size();i++) {
+    if((!filter.isEmpty())&&(!d_names.at(i).contains(filter))) {
+      continue;
+    }
+
+    //
+    // Double the iteration count until a run takes long enough to time
+    // reliably, then scale it up to fill the requested run time.
+    //
+    iterations=1;
+    while((elapsed=Time(d_functions.at(i),iterations,&allocs))<
+	  MICROBENCH_CALIBRATION_TIME*1000000ll) {
+      iterations*=2;
+    }
+    iterations=(double)iterations*(double)d_run_msecs*1000000.0/
+      (double)elapsed;
+    if(iterations<1) {
+      iterations=1;
+    }
+    elapsed=Time(d_functions.at(i),iterations,&allocs);
+
+    printf("%-28s %12" PRIu64 " %12.1f %12.2f\n",d_names.at(i).toUtf8().constData(),
+	   iterations,(double)elapsed/(double)iterations,
+	   (double)allocs/(double)iterations);
+    fflush(stdout);
+  }
+}
+
+
+uint64_t Microbench::allocations()
+{
+  return __microbench_allocations;
+}
+
+
+int64_t Microbench::monotonicNsec()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+
+  return (int64_t)ts.tv_sec*1000000000+ts.tv_nsec;
+}
+
+
+int64_t Microbench::Time(Function func,uint64_t iterations,
+			 uint64_t *allocs) const
+{
+  uint64_t start_allocs=Microbench::allocations();
+  int64_t start=Microbench::monotonicNsec();
+  func(iterations);
+  int64_t ret=Microbench::monotonicNsec()-start;
+  *allocs=Microbench::allocations()-start_allocs;
+
+  return ret;
+}
+
+
+int main(int argc,char *argv[])
+{
+  QCoreApplication a(argc,argv);
+  QString filter;
+  QString err_msg;
+  int run_msecs=MICROBENCH_DEFAULT_TIME;
+  bool ok=false;
+
+  CmdSwitch *cmd=new CmdSwitch("microbench",VERSION,MICROBENCH_USAGE);
+  for(int i=0;i<cmd->keys();i++) {
+    if(cmd->key(i)=="--filter") {
+      filter=cmd->value(i);
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--time") {
+      run_msecs=cmd->value(i).toInt(&ok);
+      if((!ok)||(run_msecs<MICROBENCH_CALIBRATION_TIME)) {
+	fprintf(stderr,"microbench: invalid --time value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+    if(!cmd->processed(i)) {
+      fprintf(stderr,"microbench: unrecognized switch \"%s\"\n",
+	      cmd->key(i).toUtf8().constData());
+      exit(1);
+    }
+  }
+
+  //
+  // Prepare Inputs
+  //
+  for(int i=0;__microbench_rfc3164[i]!=NULL;i++) {
+    __microbench_rfc3164_data.push_back(QByteArray(__microbench_rfc3164[i]));
+    __microbench_messages.
+      push_back(Message(__microbench_rfc3164_data.last()));
+    __microbench_duplicates.
+      push_back(Message(__microbench_rfc3164_data.last()));
+  }
+  for(int i=0;__microbench_rfc5424[i]!=NULL;i++) {
+    __microbench_rfc5424_data.push_back(QByteArray(__microbench_rfc5424[i]));
+    __microbench_messages.
+      push_back(Message(__microbench_rfc5424_data.last()));
+    __microbench_duplicates.
+      push_back(Message(__microbench_rfc5424_data.last()));
+  }
+  for(int i=0;i<__microbench_messages.size();i++) {
+    int n=sizeof(__microbench_sources)/sizeof(const char *)-1;
+    __microbench_addresses.
+      push_back(QHostAddress(__microbench_sources[i%n]));
+  }
+  __microbench_filter=new AddressFilter();
+  __microbench_filter->addSubnet(QHostAddress("10.216.0.0"),16);
+  __microbench_filter->addSubnet(QHostAddress("192.168.10.0"),24);
+  __microbench_filter->addSubnet(QHostAddress("fd00:216::"),32);
+  __microbench_filter->addSubnet(QHostAddress("127.0.0.1"),32);
+  __microbench_pattern_filter=new PatternFilter();
+  for(int i=0;__microbench_match_patterns[i]!=NULL;i++) {
+    __microbench_pattern_filter->
+      addPattern(PatternFilter::KindMatch,__microbench_match_patterns[i],
+		 &err_msg);
+  }
+  for(int i=0;__microbench_exclude_patterns[i]!=NULL;i++) {
+    __microbench_pattern_filter->
+      addPattern(PatternFilter::KindExclude,__microbench_exclude_patterns[i],
+		 &err_msg);
+  }
+  if(!__microbench_pattern_filter->compile(&err_msg)) {
+    fprintf(stderr,"microbench: unable to compile patterns [%s]\n",
+	    err_msg.toUtf8().constData());
+    exit(1);
+  }
+  __microbench_field_filter=new FieldFilter(true);
+  for(int i=0;__microbench_host_patterns[i]!=NULL;i++) {
+    __microbench_field_filter->
+      addPattern(__microbench_host_patterns[i],&err_msg);
+  }
+  __microbench_field_filter->compile();
+  __microbench_config_filename=QDir::tempPath()+
+    QString::asprintf("/microbench-%d.conf",getpid());
+  QFile file(__microbench_config_filename);
+  if(!file.open(QIODevice::WriteOnly)) {
+    fprintf(stderr,"microbench: unable to write \"%s\"\n",
+	    __microbench_config_filename.toUtf8().constData());
+    exit(1);
+  }
+  file.write(__microbench_config);
+  file.close();
+
+  Microbench *bench=new Microbench(run_msecs);
+  bench->add("message_parse_rfc3164",MessageParseRfc3164);
+  bench->add("message_parse_rfc5424",MessageParseRfc5424);
+  bench->add("resolve_wildcards_default",ResolveWildcardsDefault);
+  bench->add("resolve_wildcards_full",ResolveWildcardsFull);
+  bench->add("to_bytearray_v0",ToByteArrayV0);
+  bench->add("to_bytearray_v1",ToByteArrayV1);
+  bench->add("is_duplicate_of_match",IsDuplicateOfMatch);
+  bench->add("is_duplicate_of_differ",IsDuplicateOfDiffer);
+  bench->add("address_filter_contains",AddressFilterContains);
+  bench->add("pattern_filter_accepts",PatternFilterAccepts);
+  bench->add("field_filter_contains",FieldFilterContains);
+  bench->add("profile_load",ProfileLoad);
+  bench->run(filter);
+
+  QFile::remove(__microbench_config_filename);
+
+  return 0;
+}
@@ -0,0 +1,58 @@
+// microbench.h
+//
+// Microbenchmarks for the message hot path
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef MICROBENCH_H
+#define MICROBENCH_H
+
+#include <stdint.h>
+
+#include <QList>
+#include <QString>
+
+//
+// Global Definitions
+//
+#define MICROBENCH_USAGE "[--filter=<string>] [--time=<msecs>]\n\n"
+
+//
+// Defaults
+//
+#define MICROBENCH_DEFAULT_TIME 500
+#define MICROBENCH_CALIBRATION_TIME 20
+
+class Microbench
+{
+ public:
+  typedef void (*Function)(uint64_t iterations);
+  Microbench(int run_msecs);
+  void add(const QString &name,Function func);
+  void run(const QString &filter) const;
+  static uint64_t allocations();
+  static int64_t monotonicNsec();
+
+ private:
+  int64_t Time(Function func,uint64_t iterations,uint64_t *allocs) const;
+  int d_run_msecs;
+  QList<QString> d_names;
+  QList<Function> d_functions;
+};
+
+
+#endif  // MICROBENCH_H
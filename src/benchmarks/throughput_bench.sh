@@ -0,0 +1,308 @@
+#!/bin/sh
+
+# throughput_bench.sh
+#
+#  End-to-end throughput and loss benchmark for lwsyslogger(8).
+#
+#   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+#
+#   This program is free software; you can redistribute it and/or modify
+#   it under the terms of the GNU General Public License version 2 as
+#   published by the Free Software Foundation.
+#
+#   This program is distributed in the hope that it will be useful,
+#   but WITHOUT ANY WARRANTY; without even the implied warranty of
+#   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#   GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public
+#   License along with this program; if not, write to the Free Software
+#   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+#
+# Usage: throughput_bench.sh <lwsyslogger-binary> <lwsyslog-bench-binary>
+#
+# Runs lwsyslogger against a temporary LogRoot once for each offered
+# rate, drives it over loopback with lwsyslog-bench and then checks
+# the sequence numbers that arrived in the SimpleFile and FileByHostname
+# outputs. The following environment variables adjust the run:
+#
+#   BENCH_RATES       Offered rates, in msgs/sec
+#                     [10000 20000 50000 100000 200000 400000]
+#   BENCH_DURATION    Seconds of load per rate [10]
+#   BENCH_HOSTNAMES   Number of synthetic hostnames [50]
+#   BENCH_PAYLOAD     Payload size range, in bytes [64-512]
+#   BENCH_FORMAT      3164 or 5424 [3164]
+#   BENCH_PORT        UDP port to use on loopback [15514]
+#   BENCH_RCVBUF      ReceiveBufferSize for the receiver [8388608]
+#   BENCH_FLUSH       FlushInterval for the SimpleFile processor [0]
+#   BENCH_USER        ServiceUser when run as root [nobody]
+#   BENCH_RESULTS     Machine-readable results file
+#                     [benchmark-results.json]
+#
+
+LWSYSLOGGER=$1
+LWSYSLOG_BENCH=$2
+if test -z "$LWSYSLOGGER" -o -z "$LWSYSLOG_BENCH" ; then
+    echo "usage: throughput_bench.sh <lwsyslogger> <lwsyslog-bench>" 1>&2
+    exit 1
+fi
+
+RATES=${BENCH_RATES:-"10000 20000 50000 100000 200000 400000"}
+DURATION=${BENCH_DURATION:-10}
+HOSTNAMES=${BENCH_HOSTNAMES:-50}
+PAYLOAD=${BENCH_PAYLOAD:-64-512}
+FORMAT=${BENCH_FORMAT:-3164}
+PORT=${BENCH_PORT:-15514}
+RCVBUF=${BENCH_RCVBUF:-8388608}
+FLUSH=${BENCH_FLUSH:-0}
+RESULTS=${BENCH_RESULTS:-benchmark-results.json}
+CLK_TCK=`getconf CLK_TCK`
+
+#
+# lwsyslogger refuses to run as root, and insists that the LogRoot
+# belong to its ServiceUser.
+#
+if test `id -u` -eq 0 ; then
+    SERVICE_USER=${BENCH_USER:-nobody}
+else
+    SERVICE_USER=`id -un`
+fi
+SERVICE_GROUP=`id -gn $SERVICE_USER`
+
+WORKDIR=`mktemp -d ${TMPDIR:-/tmp}/lwsyslogger-bench.XXXXXX` || exit 1
+chmod 755 $WORKDIR
+LWSYSLOGGER_PID=""
+
+cleanup() {
+    if test -n "$LWSYSLOGGER_PID" ; then
+	kill $LWSYSLOGGER_PID 2> /dev/null
+	wait $LWSYSLOGGER_PID 2> /dev/null
+    fi
+    rm -rf $WORKDIR
+}
+trap cleanup EXIT
+trap "exit 1" HUP INT TERM
+
+#
+# Sum of user and system CPU ticks used so far by a process
+#
+cpu_ticks() {
+    awk '{ print $14+$15 }' /proc/$1/stat 2> /dev/null || echo 0
+}
+
+#
+# Combined size of everything written under the LogRoot
+#
+output_size() {
+    du -sb $WORKDIR/logroot 2> /dev/null | awk '{ print $1 }'
+}
+
+#
+# Count sequence numbers in the given files. Prints the number of
+# distinct in-range values, repeated values and out-of-range values.
+#
+check_sequence() {
+    max_seq=$1
+    shift
+    cat "$@" 2> /dev/null | awk -v max=$max_seq '
+	match($0,/seq=[0-9]+/) {
+	    s=substr($0,RSTART+4,RLENGTH-4)+0
+	    if((s<1)||(s>max)) { bad++ }
+	    else { if(seen[s]++) { dup++ } else { uniq++ } }
+	}
+	END { printf "%d %d %d\n",uniq,dup,bad }'
+}
+
+#
+# p99 for one of a processor's latency histograms, from the SIGUSR1
+# statistics dump
+#
+p99_usec() {
+    awk -v key="stats: processor $1: $2" '
+	index($0,key)>0 {
+	    for(i=1;i<=NF;i++) {
+		if(substr($i,1,4)=="p99=") { v=substr($i,5); sub(/us$/,"",v) }
+	    }
+	}
+	END { print (v=="")?0:v }' $WORKDIR/lwsyslogger.log
+}
+
+echo "lwsyslogger throughput benchmark"
+echo "duration: ${DURATION}s per rate, hostnames: $HOSTNAMES, payload: $PAYLOAD bytes, format: RFC $FORMAT"
+echo
+printf "%10s %10s %10s %9s %9s %10s %10s %10s\n" \
+       "offered" "achieved" "received" "loss%" "bad" "cpu-us/msg" \
+       "p99-disp" "p99-write"
+
+ZERO_LOSS_RATE=0
+RUNS=""
+STATUS=0
+for RATE in $RATES ; do
+    #
+    # Fresh LogRoot and daemon for each step
+    #
+    rm -rf $WORKDIR/logroot
+    mkdir -p $WORKDIR/logroot/hosts
+    if test `id -u` -eq 0 ; then
+	chown -R $SERVICE_USER:$SERVICE_GROUP $WORKDIR/logroot
+    fi
+    cat > $WORKDIR/lwsyslogger.conf <<EOC
+[Global]
+ServiceUser=$SERVICE_USER
+ServiceGroup=$SERVICE_GROUP
+LogRoot=$WORKDIR/logroot
+
+[Receiver]
+Id=Bench
+Type=UDP
+Port=$PORT
+ReceiveBufferSize=$RCVBUF
+Processor=SimpleFile
+Processor=ByHostname
+
+[Processor]
+Id=SimpleFile
+Type=SimpleFile
+BaseFilename=syslog
+FlushInterval=$FLUSH
+Facility=USER
+Severity=DEBUG+
+UpstreamAddress=0.0.0.0/0
+UpstreamAddress=::/0
+DeduplicationTimeout=0
+
+[Processor]
+Id=ByHostname
+Type=FileByHostname
+BaseDirname=hosts
+Facility=USER
+Severity=DEBUG+
+UpstreamAddress=0.0.0.0/0
+UpstreamAddress=::/0
+DeduplicationTimeout=0
+EOC
+    $LWSYSLOGGER --config=$WORKDIR/lwsyslogger.conf -d \
+		 2> $WORKDIR/lwsyslogger.log &
+    LWSYSLOGGER_PID=$!
+    for i in 1 2 3 4 5 6 7 8 9 10 ; do
+	if grep -q "lwsyslogger v.* started" $WORKDIR/lwsyslogger.log ; then
+	    break
+	fi
+	sleep 1
+    done
+    if ! grep -q "lwsyslogger v.* started" $WORKDIR/lwsyslogger.log ; then
+	echo "lwsyslogger failed to start:" 1>&2
+	cat $WORKDIR/lwsyslogger.log 1>&2
+	exit 1
+    fi
+    CPU_START=`cpu_ticks $LWSYSLOGGER_PID`
+
+    #
+    # Offer the load
+    #
+    $LWSYSLOG_BENCH --address=127.0.0.1 --port=$PORT --format=$FORMAT \
+		    --rate=$RATE --duration=$DURATION \
+		    --hostnames=$HOSTNAMES --payload-size=$PAYLOAD \
+		    > $WORKDIR/bench.out || exit 1
+    SENT=`awk '/^sent /{ print $2 }' $WORKDIR/bench.out`
+    ACHIEVED=`awk '/^achieved rate:/{ print $3 }' $WORKDIR/bench.out`
+    SEND_ERRORS=`awk '/^duplicates:/{ print $5 }' $WORKDIR/bench.out`
+
+    #
+    # Wait for the output to settle, then collect statistics and stop
+    # the daemon so that everything still buffered is written out.
+    #
+    LAST_SIZE=-1
+    for i in `seq 1 60` ; do
+	SIZE=`output_size`
+	if test "$SIZE" = "$LAST_SIZE" ; then
+	    break
+	fi
+	LAST_SIZE=$SIZE
+	sleep 0.5
+    done
+    CPU_END=`cpu_ticks $LWSYSLOGGER_PID`
+    kill -USR1 $LWSYSLOGGER_PID
+    sleep 0.5
+    kill -TERM $LWSYSLOGGER_PID
+    wait $LWSYSLOGGER_PID
+    LWSYSLOGGER_PID=""
+
+    #
+    # Account for every sequence number
+    #
+    MAX_SEQ=$((SENT+SEND_ERRORS))
+    set -- `check_sequence $MAX_SEQ $WORKDIR/logroot/syslog`
+    SF_RECEIVED=$1 SF_DUP=$2 SF_BAD=$3
+    set -- `check_sequence $MAX_SEQ $WORKDIR/logroot/hosts/*`
+    FH_RECEIVED=$1 FH_DUP=$2 FH_BAD=$3
+    P99_DISPATCH=`p99_usec SimpleFile dispatch_latency_seconds`
+    P99_WRITE=`p99_usec SimpleFile write_latency_seconds`
+
+    set -- `awk -v sent=$SENT -v sf=$SF_RECEIVED -v fh=$FH_RECEIVED \
+		-v ticks=$((CPU_END-CPU_START)) -v hz=$CLK_TCK '
+	BEGIN {
+	    rcvd=(sf<fh)?sf:fh
+	    loss=(sent>0)?100.0*(sent-rcvd)/sent:0
+	    cpu=(sf>0)?1000000.0*ticks/hz/sf:0
+	    printf "%d %.3f %.2f\n",rcvd,loss,cpu
+	}'`
+    RECEIVED=$1 LOSS=$2 CPU_PER_MSG=$3
+    BAD=$((SF_DUP+SF_BAD+FH_DUP+FH_BAD))
+    if test $BAD -ne 0 ; then
+	STATUS=1
+    fi
+    if test $RECEIVED -eq $SENT -a $BAD -eq 0 ; then
+	ZERO_LOSS_RATE=`echo $ZERO_LOSS_RATE $ACHIEVED | \
+			awk '{ print ($2>$1)?$2:$1 }'`
+    fi
+    printf "%10s %10s %10s %9s %9s %10s %9sus %9sus\n" \
+	   $RATE $ACHIEVED $RECEIVED $LOSS $BAD $CPU_PER_MSG \
+	   $P99_DISPATCH $P99_WRITE
+
+    if test -n "$RUNS" ; then
+	RUNS="$RUNS,"
+    fi
+    RUNS="$RUNS
+    {
+      \"offered_rate\": $RATE,
+      \"achieved_rate\": $ACHIEVED,
+      \"sent\": $SENT,
+      \"send_errors\": $SEND_ERRORS,
+      \"simplefile_received\": $SF_RECEIVED,
+      \"simplefile_duplicated\": $SF_DUP,
+      \"simplefile_corrupt\": $SF_BAD,
+      \"filebyhostname_received\": $FH_RECEIVED,
+      \"filebyhostname_duplicated\": $FH_DUP,
+      \"filebyhostname_corrupt\": $FH_BAD,
+      \"loss_percent\": $LOSS,
+      \"cpu_usec_per_msg\": $CPU_PER_MSG,
+      \"p99_dispatch_latency_usec\": $P99_DISPATCH,
+      \"p99_write_latency_usec\": $P99_WRITE
+    }"
+done
+
+cat > $RESULTS <<EOR
+{
+  "version": "`$LWSYSLOGGER --version | awk '{ sub(/^v/,"",$2); print $2 }'`",
+  "date": "`date -u +%Y-%m-%dT%H:%M:%SZ`",
+  "host": "`uname -n`",
+  "duration": $DURATION,
+  "hostnames": $HOSTNAMES,
+  "payload_size": "$PAYLOAD",
+  "format": "$FORMAT",
+  "flush_interval": $FLUSH,
+  "zero_loss_rate": $ZERO_LOSS_RATE,
+  "runs": [$RUNS
+  ]
+}
+EOR
+
+echo
+echo "sustained rate at zero loss: $ZERO_LOSS_RATE msgs/sec"
+echo "results written to $RESULTS"
+if test $STATUS -ne 0 ; then
+    echo "WARNING: duplicated or corrupt sequence numbers were found" 1>&2
+fi
+
+exit $STATUS
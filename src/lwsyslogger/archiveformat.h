@@ -0,0 +1,112 @@
+// archiveformat.h
+//
+// On-disk format of columnar logfile archives.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef ARCHIVEFORMAT_H
+#define ARCHIVEFORMAT_H
+
+#include <stdint.h>
+
+//
+// An archive holds the lines of a rotated text logfile in blocks of up
+// to ARCHIVE_BLOCK_RECORDS records, each block storing its fields
+// column by column:
+//
+//   ArchiveBlockHeader
+//   Timestamps   (zigzag varint uSec deltas, from 'base_timestamp')
+//   Styles       (one byte per record, ARCHIVE_STYLE_*)
+//   Offsets      (zigzag varint deltas of the UTC offset, in seconds)
+//   Hosts        (varint dictionary ids)
+//   Apps         (varint dictionary ids, 0 for none)
+//   Messages     (varint length-prefixed, compressed with 'codec')
+//
+// so that a reader can fetch just the columns it needs. The file is
+// an ArchiveFileHeader, the blocks, the dictionary (varint length-
+// prefixed names, for ids 1 to 'names'), a directory of
+// ArchiveDirectoryEntry records, and finally an ArchiveFooter.
+// All in host byte order.
+//
+// A record's wall-clock time is its timestamp plus its UTC offset, so
+// lines are reproduced exactly whatever the reader's timezone, and
+// across DST changes.
+//
+#define ARCHIVE_MAGIC "LWARCHV"
+#define ARCHIVE_VERSION 2
+#define ARCHIVE_SUFFIX ".lwa"
+#define ARCHIVE_BLOCK_RECORDS 65536
+#define ARCHIVE_BLOCK_BYTES 4194304
+
+#define ARCHIVE_CODEC_NONE 0
+#define ARCHIVE_CODEC_ZLIB 1
+#define ARCHIVE_CODEC_ZSTD 2
+
+//
+// How a record is turned back into a line of text. Lines that cannot be
+// reproduced byte-for-byte from their fields are stored whole, as RAW.
+//
+#define ARCHIVE_STYLE_RAW 0
+#define ARCHIVE_STYLE_BSD 1        // "MMM dd hh:mm:ss <host> <app><msg>"
+#define ARCHIVE_STYLE_ISO 2        // "yyyy-MM-ddThh:mm:ss <host> <app><msg>"
+
+#define ARCHIVE_COLUMN_TIMESTAMP 0
+#define ARCHIVE_COLUMN_STYLE 1
+#define ARCHIVE_COLUMN_OFFSET 2
+#define ARCHIVE_COLUMN_HOST 3
+#define ARCHIVE_COLUMN_APP 4
+#define ARCHIVE_COLUMN_MESSAGE 5
+#define ARCHIVE_COLUMNS 6
+
+struct ArchiveFileHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  int64_t created;           // uSecs since the epoch
+};
+
+struct ArchiveBlockHeader
+{
+  uint32_t records;
+  uint16_t codec;            // Of the message column
+  uint16_t reserved;
+  int64_t base_timestamp;    // uSecs since the epoch
+  uint32_t sizes[ARCHIVE_COLUMNS];
+  uint32_t message_size;     // Of the message column, uncompressed
+};
+
+struct ArchiveDirectoryEntry
+{
+  uint64_t offset;           // Of the ArchiveBlockHeader
+  uint32_t records;
+  uint32_t reserved;
+  int64_t min_timestamp;
+  int64_t max_timestamp;
+};
+
+struct ArchiveFooter
+{
+  uint64_t dictionary_offset;
+  uint64_t directory_offset;
+  uint32_t names;
+  uint32_t blocks;
+  char magic[8];
+};
+
+
+#endif  // ARCHIVEFORMAT_H
@@ -0,0 +1,375 @@
+// archivereader.cpp
+//
+// Read columnar logfile archives.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif  // HAVE_ZSTD
+
+#include "archivereader.h"
+
+static const char *__archivereader_month_names[]=
+  {"Jan","Feb","Mar","Apr","May","Jun","Jul","Aug","Sep","Oct","Nov","Dec"};
+
+static bool __archivereader_get_varint(const QByteArray &data,int *pos,
+				       uint64_t *value)
+{
+  *value=0;
+  for(int shift=0;shift<64;shift+=7) {
+    if(*pos>=data.size()) {
+      return false;
+    }
+    uint8_t c=data.at((*pos)++);
+    *value|=(uint64_t)(c&0x7F)<<shift;
+    if((c&0x80)==0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+ArchiveReader::ArchiveReader(const QString &pathname)
+{
+  d_pathname=pathname;
+  d_file=NULL;
+  d_records=0;
+}
+
+
+ArchiveReader::~ArchiveReader()
+{
+  close();
+}
+
+
+QString ArchiveReader::pathname() const
+{
+  return d_pathname;
+}
+
+
+bool ArchiveReader::open(QString *err_msg)
+{
+  ArchiveFileHeader hdr;
+  ArchiveFooter footer;
+
+  close();
+  d_file=new QFile(d_pathname);
+  if(!d_file->open(QIODevice::ReadOnly)) {
+    *err_msg=d_file->errorString();
+    close();
+    return false;
+  }
+  if((d_file->read((char *)&hdr,sizeof(hdr))!=sizeof(hdr))||
+     (strncmp(hdr.magic,ARCHIVE_MAGIC,sizeof(hdr.magic))!=0)) {
+    *err_msg="not an archive file";
+    close();
+    return false;
+  }
+  if(hdr.version!=ARCHIVE_VERSION) {
+    *err_msg=QString::asprintf("unsupported archive version %u",hdr.version);
+    close();
+    return false;
+  }
+  if((!d_file->seek(d_file->size()-sizeof(footer)))||
+     (d_file->read((char *)&footer,sizeof(footer))!=sizeof(footer))||
+     (strncmp(footer.magic,ARCHIVE_MAGIC,sizeof(footer.magic))!=0)||
+     (footer.dictionary_offset>footer.directory_offset)||
+     ((footer.directory_offset+footer.blocks*sizeof(ArchiveDirectoryEntry))>
+      (uint64_t)(d_file->size()-sizeof(footer)))) {
+    *err_msg="truncated or corrupt archive file";
+    close();
+    return false;
+  }
+
+  //
+  // Dictionary
+  //
+  d_file->seek(footer.dictionary_offset);
+  QByteArray data=
+    d_file->read(footer.directory_offset-footer.dictionary_offset);
+  int pos=0;
+  uint64_t len;
+  for(uint32_t i=0;i<footer.names;i++) {
+    if((!__archivereader_get_varint(data,&pos,&len))||
+       ((pos+len)>(uint64_t)data.size())) {
+      *err_msg="corrupt archive dictionary";
+      close();
+      return false;
+    }
+    d_names.push_back(data.mid(pos,len));
+    d_name_ids[d_names.back()]=d_names.size();
+    pos+=len;
+  }
+
+  //
+  // Directory
+  //
+  d_directory.resize(footer.blocks);
+  qint64 size=footer.blocks*sizeof(ArchiveDirectoryEntry);
+  if(d_file->read((char *)d_directory.data(),size)!=size) {
+    *err_msg="truncated archive directory";
+    close();
+    return false;
+  }
+  for(int i=0;i<d_directory.size();i++) {
+    d_records+=d_directory.at(i).records;
+  }
+
+  return true;
+}
+
+
+void ArchiveReader::close()
+{
+  if(d_file!=NULL) {
+    d_file->close();
+    delete d_file;
+    d_file=NULL;
+  }
+  d_names.clear();
+  d_name_ids.clear();
+  d_directory.clear();
+  d_records=0;
+}
+
+
+int64_t ArchiveReader::records() const
+{
+  return d_records;
+}
+
+
+int ArchiveReader::blocks() const
+{
+  return d_directory.size();
+}
+
+
+ArchiveDirectoryEntry ArchiveReader::blockEntry(int n) const
+{
+  return d_directory.at(n);
+}
+
+
+QByteArray ArchiveReader::name(uint32_t id) const
+{
+  if((id==0)||(id>(uint32_t)d_names.size())) {
+    return QByteArray();
+  }
+  return d_names.at(id-1);
+}
+
+
+uint32_t ArchiveReader::nameId(const QByteArray &name) const
+{
+  return d_name_ids.value(name,0);
+}
+
+
+bool ArchiveReader::readBlock(int n,uint32_t columns,ArchiveBlock *block,
+			      QString *err_msg)
+{
+  ArchiveBlockHeader hdr;
+  uint64_t value;
+  int pos;
+
+  block->timestamps.clear();
+  block->styles.clear();
+  block->utc_offsets.clear();
+  block->hosts.clear();
+  block->apps.clear();
+  block->messages.clear();
+  if((!d_file->seek(d_directory.at(n).offset))||
+     (d_file->read((char *)&hdr,sizeof(hdr))!=sizeof(hdr))) {
+    *err_msg=QString::asprintf("truncated archive block %d",n);
+    return false;
+  }
+
+  //
+  // Seek past the columns that weren't asked for, so that e.g. a count
+  // by host never reads or decompresses the messages.
+  //
+  qint64 offset=d_directory.at(n).offset+sizeof(hdr);
+  for(int col=0;col<ARCHIVE_COLUMNS;col++) {
+    if((columns&ARCHIVE_COLUMN_MASK(col))==0) {
+      offset+=hdr.sizes[col];
+      continue;
+    }
+    QByteArray data;
+    if((!d_file->seek(offset))||
+       ((data=d_file->read(hdr.sizes[col])).size()!=(int)hdr.sizes[col])) {
+      *err_msg=QString::asprintf("truncated archive block %d",n);
+      return false;
+    }
+    offset+=hdr.sizes[col];
+    pos=0;
+    switch(col) {
+    case ARCHIVE_COLUMN_TIMESTAMP:
+      value=hdr.base_timestamp;
+      block->timestamps.resize(hdr.records);
+      for(uint32_t i=0;i<hdr.records;i++) {
+	uint64_t delta;
+	if(!__archivereader_get_varint(data,&pos,&delta)) {
+	  *err_msg=QString::asprintf("corrupt archive block %d",n);
+	  return false;
+	}
+	value+=(int64_t)(delta>>1)^-(int64_t)(delta&1);
+	block->timestamps[i]=value;
+      }
+      break;
+
+    case ARCHIVE_COLUMN_STYLE:
+      if(data.size()!=(int)hdr.records) {
+	*err_msg=QString::asprintf("corrupt archive block %d",n);
+	return false;
+      }
+      block->styles.resize(hdr.records);
+      memcpy(block->styles.data(),data.constData(),hdr.records);
+      break;
+
+    case ARCHIVE_COLUMN_OFFSET:
+      value=0;
+      block->utc_offsets.resize(hdr.records);
+      for(uint32_t i=0;i<hdr.records;i++) {
+	uint64_t delta;
+	if(!__archivereader_get_varint(data,&pos,&delta)) {
+	  *err_msg=QString::asprintf("corrupt archive block %d",n);
+	  return false;
+	}
+	value+=(int64_t)(delta>>1)^-(int64_t)(delta&1);
+	block->utc_offsets[i]=(int32_t)value;
+      }
+      break;
+
+    case ARCHIVE_COLUMN_HOST:
+    case ARCHIVE_COLUMN_APP:
+      {
+	QVector<uint32_t> *ids=
+	  (col==ARCHIVE_COLUMN_HOST)?&block->hosts:&block->apps;
+	ids->resize(hdr.records);
+	for(uint32_t i=0;i<hdr.records;i++) {
+	  if((!__archivereader_get_varint(data,&pos,&value))||
+	     (value>(uint64_t)d_names.size())) {
+	    *err_msg=QString::asprintf("corrupt archive block %d",n);
+	    return false;
+	  }
+	  (*ids)[i]=value;
+	}
+      }
+      break;
+
+    case ARCHIVE_COLUMN_MESSAGE:
+      switch(hdr.codec) {
+      case ARCHIVE_CODEC_NONE:
+	break;
+
+      case ARCHIVE_CODEC_ZLIB:
+	data=qUncompress(data);
+	break;
+
+      case ARCHIVE_CODEC_ZSTD:
+#ifdef HAVE_ZSTD
+	{
+	  QByteArray raw(hdr.message_size,0);
+	  size_t len=ZSTD_decompress(raw.data(),raw.size(),
+				     data.constData(),data.size());
+	  if(ZSTD_isError(len)) {
+	    raw.clear();
+	  }
+	  data=raw;
+	}
+	break;
+#else
+	*err_msg="archive is zstd compressed, but zstd support is not available";
+	return false;
+#endif  // HAVE_ZSTD
+
+      default:
+	*err_msg=QString::asprintf("unknown codec %u in archive block %d",
+				   hdr.codec,n);
+	return false;
+      }
+      if(data.size()!=(int)hdr.message_size) {
+	*err_msg=QString::asprintf("corrupt archive block %d",n);
+	return false;
+      }
+      for(uint32_t i=0;i<hdr.records;i++) {
+	if((!__archivereader_get_varint(data,&pos,&value))||
+	   ((pos+value)>(uint64_t)data.size())) {
+	  *err_msg=QString::asprintf("corrupt archive block %d",n);
+	  return false;
+	}
+	block->messages.push_back(data.mid(pos,value));
+	pos+=value;
+      }
+      break;
+    }
+  }
+
+  return true;
+}
+
+
+ArchiveRecord ArchiveReader::record(const ArchiveBlock &block,int n) const
+{
+  ArchiveRecord rec;
+
+  rec.timestamp=block.timestamps.value(n,0);
+  rec.style=block.styles.value(n,ARCHIVE_STYLE_RAW);
+  rec.utc_offset=block.utc_offsets.value(n,0);
+  rec.host=name(block.hosts.value(n,0));
+  rec.app=name(block.apps.value(n,0));
+  rec.msg=block.messages.value(n);
+
+  return rec;
+}
+
+
+QByteArray ArchiveReader::textLine(const ArchiveRecord &rec)
+{
+  struct tm tm;
+  char str[64];
+
+  time_t t=rec.timestamp/1000000+rec.utc_offset;
+  gmtime_r(&t,&tm);
+  switch(rec.style) {
+  case ARCHIVE_STYLE_BSD:
+    snprintf(str,sizeof(str),"%s %02d %02d:%02d:%02d ",
+	     __archivereader_month_names[tm.tm_mon],tm.tm_mday,
+	     tm.tm_hour,tm.tm_min,tm.tm_sec);
+    break;
+
+  case ARCHIVE_STYLE_ISO:
+    snprintf(str,sizeof(str),"%04d-%02d-%02dT%02d:%02d:%02d ",
+	     1900+tm.tm_year,1+tm.tm_mon,tm.tm_mday,
+	     tm.tm_hour,tm.tm_min,tm.tm_sec);
+    break;
+
+  default:
+    return rec.msg;
+  }
+
+  return QByteArray(str)+rec.host+" "+rec.app+rec.msg;
+}
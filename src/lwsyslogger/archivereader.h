@@ -0,0 +1,90 @@
+// archivereader.h
+//
+// Read columnar logfile archives.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef ARCHIVEREADER_H
+#define ARCHIVEREADER_H
+
+#include <stdint.h>
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+#include "archiveformat.h"
+
+#define ARCHIVE_COLUMN_MASK(col) (1u<<(col))
+#define ARCHIVE_ALL_COLUMNS ((1u<<ARCHIVE_COLUMNS)-1)
+
+struct ArchiveRecord
+{
+  int64_t timestamp;         // uSecs since the epoch
+  uint8_t style;
+  int32_t utc_offset;        // Seconds east of UTC
+  QByteArray host;
+  QByteArray app;
+  QByteArray msg;
+};
+
+//
+// The decoded columns of one block. Only those requested from
+// ArchiveReader::readBlock() are filled in.
+//
+struct ArchiveBlock
+{
+  QVector<int64_t> timestamps;
+  QVector<uint8_t> styles;
+  QVector<int32_t> utc_offsets;
+  QVector<uint32_t> hosts;
+  QVector<uint32_t> apps;
+  QList<QByteArray> messages;
+};
+
+class ArchiveReader
+{
+ public:
+  ArchiveReader(const QString &pathname);
+  ~ArchiveReader();
+  QString pathname() const;
+  bool open(QString *err_msg);
+  void close();
+  int64_t records() const;
+  int blocks() const;
+  ArchiveDirectoryEntry blockEntry(int n) const;
+  QByteArray name(uint32_t id) const;
+  uint32_t nameId(const QByteArray &name) const;
+  bool readBlock(int n,uint32_t columns,ArchiveBlock *block,
+		 QString *err_msg);
+  ArchiveRecord record(const ArchiveBlock &block,int n) const;
+  static QByteArray textLine(const ArchiveRecord &rec);
+
+ private:
+  QString d_pathname;
+  QFile *d_file;
+  QList<QByteArray> d_names;
+  QHash<QByteArray,uint32_t> d_name_ids;
+  QVector<ArchiveDirectoryEntry> d_directory;
+  int64_t d_records;
+};
+
+
+#endif  // ARCHIVEREADER_H
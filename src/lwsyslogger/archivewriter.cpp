@@ -0,0 +1,470 @@
+// archivewriter.cpp
+//
+// Write columnar logfile archives.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <ctype.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif  // HAVE_ZSTD
+
+#include "archivewriter.h"
+
+static const char *__archivewriter_month_names[]=
+  {"Jan","Feb","Mar","Apr","May","Jun","Jul","Aug","Sep","Oct","Nov","Dec"};
+
+static void __archivewriter_put_varint(QByteArray *data,uint64_t value)
+{
+  while(value>=0x80) {
+    data->append((char)((value&0x7F)|0x80));
+    value>>=7;
+  }
+  data->append((char)value);
+}
+
+
+static bool __archivewriter_digits(const char *data,int len,int *value)
+{
+  *value=0;
+  for(int i=0;i<len;i++) {
+    if(!isdigit(data[i])) {
+      return false;
+    }
+    *value=10*(*value)+data[i]-'0';
+  }
+  return true;
+}
+
+
+ArchiveWriter::ArchiveWriter(const QString &pathname,int level)
+{
+  d_pathname=pathname;
+  d_level=level;
+  d_file=NULL;
+  d_block_records=0;
+  d_base_timestamp=0;
+  d_prev_timestamp=0;
+  d_prev_utc_offset=0;
+  d_min_timestamp=0;
+  d_max_timestamp=0;
+  d_records=0;
+}
+
+
+ArchiveWriter::~ArchiveWriter()
+{
+  if(d_file!=NULL) {
+    d_file->close();
+    delete d_file;
+  }
+}
+
+
+QString ArchiveWriter::pathname() const
+{
+  return d_pathname;
+}
+
+
+bool ArchiveWriter::open(QString *err_msg)
+{
+  ArchiveFileHeader hdr;
+  struct timeval tv;
+
+  d_file=new QFile(d_pathname);
+  if(!d_file->open(QIODevice::WriteOnly|QIODevice::Truncate)) {
+    *err_msg=d_file->errorString();
+    delete d_file;
+    d_file=NULL;
+    return false;
+  }
+  memset(&hdr,0,sizeof(hdr));
+  strncpy(hdr.magic,ARCHIVE_MAGIC,sizeof(hdr.magic));
+  hdr.version=ARCHIVE_VERSION;
+  gettimeofday(&tv,NULL);
+  hdr.created=1000000*(int64_t)tv.tv_sec+tv.tv_usec;
+  if(d_file->write((const char *)&hdr,sizeof(hdr))!=sizeof(hdr)) {
+    *err_msg=d_file->errorString();
+    return false;
+  }
+
+  return true;
+}
+
+
+bool ArchiveWriter::write(const ArchiveRecord &rec,QString *err_msg)
+{
+  if(d_block_records==0) {
+    d_base_timestamp=rec.timestamp;
+    d_prev_timestamp=rec.timestamp;
+    d_prev_utc_offset=0;
+    d_min_timestamp=rec.timestamp;
+    d_max_timestamp=rec.timestamp;
+  }
+  int64_t delta=rec.timestamp-d_prev_timestamp;
+  __archivewriter_put_varint(&d_columns[ARCHIVE_COLUMN_TIMESTAMP],
+			     ((uint64_t)delta<<1)^(uint64_t)(delta>>63));
+  d_prev_timestamp=rec.timestamp;
+  if(rec.timestamp<d_min_timestamp) {
+    d_min_timestamp=rec.timestamp;
+  }
+  if(rec.timestamp>d_max_timestamp) {
+    d_max_timestamp=rec.timestamp;
+  }
+  d_columns[ARCHIVE_COLUMN_STYLE].append((char)rec.style);
+  delta=rec.utc_offset-d_prev_utc_offset;
+  __archivewriter_put_varint(&d_columns[ARCHIVE_COLUMN_OFFSET],
+			     ((uint64_t)delta<<1)^(uint64_t)(delta>>63));
+  d_prev_utc_offset=rec.utc_offset;
+  __archivewriter_put_varint(&d_columns[ARCHIVE_COLUMN_HOST],NameId(rec.host));
+  __archivewriter_put_varint(&d_columns[ARCHIVE_COLUMN_APP],NameId(rec.app));
+  __archivewriter_put_varint(&d_columns[ARCHIVE_COLUMN_MESSAGE],
+			     rec.msg.size());
+  d_columns[ARCHIVE_COLUMN_MESSAGE].append(rec.msg);
+  d_block_records++;
+  d_records++;
+
+  if((d_block_records>=ARCHIVE_BLOCK_RECORDS)||
+     (d_columns[ARCHIVE_COLUMN_MESSAGE].size()>=ARCHIVE_BLOCK_BYTES)) {
+    return WriteBlock(err_msg);
+  }
+
+  return true;
+}
+
+
+bool ArchiveWriter::close(QString *err_msg)
+{
+  ArchiveFooter footer;
+  QByteArray data;
+
+  if(d_file==NULL) {
+    return true;
+  }
+  if((d_block_records>0)&&(!WriteBlock(err_msg))) {
+    return false;
+  }
+
+  //
+  // Dictionary
+  //
+  memset(&footer,0,sizeof(footer));
+  footer.dictionary_offset=d_file->pos();
+  for(int i=0;i<d_names.size();i++) {
+    __archivewriter_put_varint(&data,d_names.at(i).size());
+    data.append(d_names.at(i));
+  }
+  if(d_file->write(data)!=data.size()) {
+    *err_msg=d_file->errorString();
+    return false;
+  }
+
+  //
+  // Directory
+  //
+  footer.directory_offset=d_file->pos();
+  qint64 len=d_directory.size()*sizeof(ArchiveDirectoryEntry);
+  if(d_file->write((const char *)d_directory.constData(),len)!=len) {
+    *err_msg=d_file->errorString();
+    return false;
+  }
+
+  footer.names=d_names.size();
+  footer.blocks=d_directory.size();
+  strncpy(footer.magic,ARCHIVE_MAGIC,sizeof(footer.magic));
+  if(d_file->write((const char *)&footer,sizeof(footer))!=sizeof(footer)) {
+    *err_msg=d_file->errorString();
+    return false;
+  }
+  if(!d_file->flush()) {
+    *err_msg=d_file->errorString();
+    return false;
+  }
+  d_file->close();
+  delete d_file;
+  d_file=NULL;
+
+  return true;
+}
+
+
+int64_t ArchiveWriter::records() const
+{
+  return d_records;
+}
+
+
+bool ArchiveWriter::parseLine(const QByteArray &line,int year,int month,
+			      ArchiveRecord *rec)
+{
+  const char *data=line.constData();
+  int len=line.size();
+  struct tm tm;
+  int pos=0;
+
+  //
+  // Split a line written by the "%t" (BSD) or "%T" (RFC-5424) template
+  // wildcards into its fields. BSD timestamps carry no year, so take it
+  // from the file's modification time. Returns false if the line cannot
+  // be reproduced byte-for-byte from the fields, in which case it must
+  // be stored as ARCHIVE_STYLE_RAW.
+  //
+  rec->host.clear();
+  rec->app.clear();
+  rec->msg.clear();
+  memset(&tm,0,sizeof(tm));
+  if((len>=20)&&(data[4]=='-')&&(data[7]=='-')&&(data[10]=='T')&&
+     (data[13]==':')&&(data[16]==':')&&(data[19]==' ')) {
+    if((!__archivewriter_digits(data,4,&tm.tm_year))||
+       (!__archivewriter_digits(data+5,2,&tm.tm_mon))||
+       (!__archivewriter_digits(data+8,2,&tm.tm_mday))||
+       (!__archivewriter_digits(data+11,2,&tm.tm_hour))||
+       (!__archivewriter_digits(data+14,2,&tm.tm_min))||
+       (!__archivewriter_digits(data+17,2,&tm.tm_sec))) {
+      return false;
+    }
+    tm.tm_year-=1900;
+    tm.tm_mon-=1;
+    rec->style=ARCHIVE_STYLE_ISO;
+    pos=20;
+  }
+  else {
+    if((len<16)||(data[3]!=' ')||(data[6]!=' ')||(data[9]!=':')||
+       (data[12]!=':')||(data[15]!=' ')) {
+      return false;
+    }
+    tm.tm_mon=-1;
+    for(int i=0;i<12;i++) {
+      if(strncmp(data,__archivewriter_month_names[i],3)==0) {
+	tm.tm_mon=i;
+	break;
+      }
+    }
+    if((tm.tm_mon<0)||
+       (!__archivewriter_digits(data+4,2,&tm.tm_mday))||
+       (!__archivewriter_digits(data+7,2,&tm.tm_hour))||
+       (!__archivewriter_digits(data+10,2,&tm.tm_min))||
+       (!__archivewriter_digits(data+13,2,&tm.tm_sec))) {
+      return false;
+    }
+    tm.tm_year=year-1900;
+    if((tm.tm_mon+1)>month) {
+      tm.tm_year--;  // From before the new year
+    }
+    rec->style=ARCHIVE_STYLE_BSD;
+    pos=16;
+  }
+
+  //
+  // Keep the offset from UTC alongside the timestamp, taking it as the
+  // difference between the fields read as UTC and as local time. Adding
+  // it back gives the fields exactly, even for times inside a DST gap or
+  // fold.
+  //
+  struct tm utc=tm;
+  time_t w=timegm(&utc);
+  tm.tm_isdst=-1;
+  time_t t=mktime(&tm);
+  if((t==(time_t)-1)||(w==(time_t)-1)) {
+    return false;
+  }
+  rec->timestamp=1000000*(int64_t)t;
+  rec->utc_offset=w-t;
+
+  //
+  // Hostname
+  //
+  int end=line.indexOf(' ',pos);
+  if(end<=pos) {
+    return false;
+  }
+  rec->host=line.mid(pos,end-pos);
+  pos=end+1;
+
+  //
+  // Application name, as the tag before a "[pid]:" or ":"
+  //
+  end=pos;
+  while((end<len)&&(end-pos<48)&&
+	(isalnum(data[end])||(data[end]=='_')||(data[end]=='-')||
+	 (data[end]=='.')||(data[end]=='/'))) {
+    end++;
+  }
+  if((end>pos)&&(end<len)&&((data[end]=='[')||(data[end]==':'))) {
+    rec->app=line.mid(pos,end-pos);
+    pos=end;
+  }
+  rec->msg=line.mid(pos);
+
+  return ArchiveReader::textLine(*rec)==line;
+}
+
+
+bool ArchiveWriter::convertTextFile(const QString &src_pathname,
+				    const QString &dst_pathname,int level,
+				    QString *err_msg)
+{
+  struct stat st;
+  struct tm tm;
+  ArchiveRecord rec;
+  int64_t prev_timestamp=0;
+  int32_t prev_utc_offset=0;
+
+  if(stat(src_pathname.toUtf8(),&st)!=0) {
+    *err_msg=strerror(errno);
+    return false;
+  }
+  localtime_r(&st.st_mtime,&tm);
+  QFile *src=new QFile(src_pathname);
+  if(!src->open(QIODevice::ReadOnly)) {
+    *err_msg=src->errorString();
+    delete src;
+    return false;
+  }
+
+  //
+  // Every record is turned back into a line with a trailing newline, so
+  // a file ending with a partial line can't be reproduced exactly.
+  //
+  if(src->size()>0) {
+    char c=0;
+    if((!src->seek(src->size()-1))||(!src->getChar(&c))||(c!='\n')||
+       (!src->seek(0))) {
+      *err_msg="file does not end with a complete line";
+      delete src;
+      return false;
+    }
+  }
+
+  ArchiveWriter *writer=new ArchiveWriter(dst_pathname,level);
+  bool ret=writer->open(err_msg);
+  while(ret&&(!src->atEnd())) {
+    QByteArray line=src->readLine();
+    if(line.isEmpty()) {
+      *err_msg=src->errorString();
+      ret=false;
+      break;
+    }
+    line.chop(1);
+    if(ArchiveWriter::parseLine(line,1900+tm.tm_year,1+tm.tm_mon,&rec)) {
+      prev_timestamp=rec.timestamp;
+      prev_utc_offset=rec.utc_offset;
+    }
+    else {
+      rec.timestamp=prev_timestamp;
+      rec.style=ARCHIVE_STYLE_RAW;
+      rec.utc_offset=prev_utc_offset;
+      rec.host.clear();
+      rec.app.clear();
+      rec.msg=line;
+    }
+    ret=writer->write(rec,err_msg);
+  }
+  ret=ret&&writer->close(err_msg);
+  delete writer;
+  delete src;
+  if(!ret) {
+    unlink(dst_pathname.toUtf8());
+  }
+
+  return ret;
+}
+
+
+bool ArchiveWriter::WriteBlock(QString *err_msg)
+{
+  ArchiveBlockHeader hdr;
+  ArchiveDirectoryEntry entry;
+  QByteArray msgs=d_columns[ARCHIVE_COLUMN_MESSAGE];
+
+  memset(&hdr,0,sizeof(hdr));
+  hdr.records=d_block_records;
+  hdr.codec=ARCHIVE_CODEC_NONE;
+  hdr.base_timestamp=d_base_timestamp;
+  hdr.message_size=msgs.size();
+
+  //
+  // Only the message column is worth compressing; the others are
+  // already small varints and single bytes.
+  //
+#ifdef HAVE_ZSTD
+  QByteArray buffer(ZSTD_compressBound(msgs.size()),0);
+  size_t n=ZSTD_compress(buffer.data(),buffer.size(),msgs.constData(),
+			 msgs.size(),d_level>=0?d_level:ZSTD_CLEVEL_DEFAULT);
+  if((!ZSTD_isError(n))&&(n<(size_t)msgs.size())) {
+    buffer.truncate(n);
+    msgs=buffer;
+    hdr.codec=ARCHIVE_CODEC_ZSTD;
+  }
+#else
+  QByteArray buffer=qCompress(msgs,d_level>=0?qMin(d_level,9):-1);
+  if(buffer.size()<msgs.size()) {
+    msgs=buffer;
+    hdr.codec=ARCHIVE_CODEC_ZLIB;
+  }
+#endif  // HAVE_ZSTD
+  for(int i=0;i<ARCHIVE_COLUMNS;i++) {
+    hdr.sizes[i]=d_columns[i].size();
+  }
+  hdr.sizes[ARCHIVE_COLUMN_MESSAGE]=msgs.size();
+
+  memset(&entry,0,sizeof(entry));
+  entry.offset=d_file->pos();
+  entry.records=d_block_records;
+  entry.min_timestamp=d_min_timestamp;
+  entry.max_timestamp=d_max_timestamp;
+
+  bool ok=d_file->write((const char *)&hdr,sizeof(hdr))==sizeof(hdr);
+  for(int i=0;i<ARCHIVE_COLUMN_MESSAGE;i++) {
+    ok=ok&&(d_file->write(d_columns[i])==d_columns[i].size());
+    d_columns[i].clear();
+  }
+  ok=ok&&(d_file->write(msgs)==msgs.size());
+  d_columns[ARCHIVE_COLUMN_MESSAGE].clear();
+  d_block_records=0;
+  if(!ok) {
+    *err_msg=d_file->errorString();
+    return false;
+  }
+  d_directory.push_back(entry);
+
+  return true;
+}
+
+
+uint32_t ArchiveWriter::NameId(const QByteArray &name)
+{
+  if(name.isEmpty()) {
+    return 0;
+  }
+  QHash<QByteArray,uint32_t>::const_iterator it=d_name_ids.find(name);
+  if(it!=d_name_ids.end()) {
+    return it.value();
+  }
+  d_names.push_back(name);
+  d_name_ids[name]=d_names.size();
+
+  return d_names.size();
+}
@@ -0,0 +1,72 @@
+// archivewriter.h
+//
+// Write columnar logfile archives.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef ARCHIVEWRITER_H
+#define ARCHIVEWRITER_H
+
+#include <stdint.h>
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+#include "archiveformat.h"
+#include "archivereader.h"
+
+class ArchiveWriter
+{
+ public:
+  ArchiveWriter(const QString &pathname,int level=-1);
+  ~ArchiveWriter();
+  QString pathname() const;
+  bool open(QString *err_msg);
+  bool write(const ArchiveRecord &rec,QString *err_msg);
+  bool close(QString *err_msg);
+  int64_t records() const;
+  static bool parseLine(const QByteArray &line,int year,int month,
+			ArchiveRecord *rec);
+  static bool convertTextFile(const QString &src_pathname,
+			      const QString &dst_pathname,int level,
+			      QString *err_msg);
+
+ private:
+  bool WriteBlock(QString *err_msg);
+  uint32_t NameId(const QByteArray &name);
+  QString d_pathname;
+  int d_level;
+  QFile *d_file;
+  QByteArray d_columns[ARCHIVE_COLUMNS];
+  uint32_t d_block_records;
+  int64_t d_base_timestamp;
+  int64_t d_prev_timestamp;
+  int32_t d_prev_utc_offset;
+  int64_t d_min_timestamp;
+  int64_t d_max_timestamp;
+  QHash<QByteArray,uint32_t> d_name_ids;
+  QList<QByteArray> d_names;
+  QVector<ArchiveDirectoryEntry> d_directory;
+  int64_t d_records;
+};
+
+
+#endif  // ARCHIVEWRITER_H
@@ -0,0 +1,265 @@
+// bloomfilter.cpp
+//
+// Bloom filter for recording which keys occur in a logfile.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <QFile>
+
+#include "bloomfilter.h"
+
+BloomFilter::BloomFilter(uint64_t bits,uint32_t hashes)
+{
+  if(bits<8) {
+    bits=BLOOMFILTER_DEFAULT_BITS;
+  }
+  if(hashes<1) {
+    hashes=BLOOMFILTER_DEFAULT_HASHES;
+  }
+  d_nbits=bits&~(uint64_t)7;
+  d_hashes=hashes;
+  d_insertions=0;
+  d_has_tokens=false;
+  d_bits.fill(0,d_nbits/8);
+}
+
+
+uint64_t BloomFilter::bits() const
+{
+  return d_nbits;
+}
+
+
+uint64_t BloomFilter::insertions() const
+{
+  return d_insertions;
+}
+
+
+bool BloomFilter::isEmpty() const
+{
+  return d_insertions==0;
+}
+
+
+bool BloomFilter::hasTokens() const
+{
+  return d_has_tokens;
+}
+
+
+void BloomFilter::setHasTokens(bool state)
+{
+  d_has_tokens=state;
+}
+
+
+double BloomFilter::falsePositiveRate() const
+{
+  //
+  // Estimated from the fraction of bits set
+  //
+  const unsigned char *bits=(const unsigned char *)d_bits.constData();
+  uint64_t set=0;
+  for(int i=0;i<d_bits.size();i++) {
+    set+=__builtin_popcount(bits[i]);
+  }
+
+  return pow((double)set/(double)d_nbits,(double)d_hashes);
+}
+
+
+void BloomFilter::insert(const QByteArray &key)
+{
+  uint64_t h1;
+  uint64_t h2;
+  char *bits=d_bits.data();
+
+  Hash(key,&h1,&h2);
+  for(uint32_t i=0;i<d_hashes;i++) {
+    uint64_t bit=(h1+i*h2)%d_nbits;
+    bits[bit/8]|=1<<(bit%8);
+  }
+  d_insertions++;
+}
+
+
+bool BloomFilter::mayContain(const QByteArray &key) const
+{
+  uint64_t h1;
+  uint64_t h2;
+  const char *bits=d_bits.constData();
+
+  Hash(key,&h1,&h2);
+  for(uint32_t i=0;i<d_hashes;i++) {
+    uint64_t bit=(h1+i*h2)%d_nbits;
+    if((bits[bit/8]&(1<<(bit%8)))==0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+void BloomFilter::clear()
+{
+  d_bits.fill(0);
+  d_insertions=0;
+}
+
+
+bool BloomFilter::save(const QString &pathname,QString *err_msg) const
+{
+  BloomFilterHeader hdr;
+  QString tmp_pathname=pathname+".tmp";
+
+  //
+  // Write to a temporary file first, so that a reader never sees
+  // a partial filter (which would give false negatives).
+  //
+  memset(&hdr,0,sizeof(hdr));
+  memcpy(hdr.magic,BLOOMFILTER_MAGIC,sizeof(hdr.magic));
+  hdr.version=BLOOMFILTER_VERSION;
+  hdr.hashes=d_hashes;
+  hdr.bits=d_nbits;
+  hdr.insertions=d_insertions;
+  if(d_has_tokens) {
+    hdr.flags|=BLOOMFILTER_FLAG_TOKENS;
+  }
+  QFile file(tmp_pathname);
+  if(!file.open(QIODevice::WriteOnly|QIODevice::Truncate)) {
+    *err_msg=file.errorString();
+    return false;
+  }
+  if((file.write((const char *)(&hdr),sizeof(hdr))!=sizeof(hdr))||
+     (file.write(d_bits)!=d_bits.size())) {
+    *err_msg=file.errorString();
+    file.close();
+    QFile::remove(tmp_pathname);
+    return false;
+  }
+  file.close();
+  if(rename(tmp_pathname.toUtf8(),pathname.toUtf8())!=0) {
+    *err_msg=strerror(errno);
+    QFile::remove(tmp_pathname);
+    return false;
+  }
+
+  return true;
+}
+
+
+bool BloomFilter::load(const QString &pathname,QString *err_msg)
+{
+  BloomFilterHeader hdr;
+
+  QFile file(pathname);
+  if(!file.open(QIODevice::ReadOnly)) {
+    *err_msg=file.errorString();
+    return false;
+  }
+  if((file.read((char *)(&hdr),sizeof(hdr))!=sizeof(hdr))||
+     (strncmp(hdr.magic,BLOOMFILTER_MAGIC,sizeof(hdr.magic))!=0)||
+     (hdr.version!=BLOOMFILTER_VERSION)||(hdr.hashes<1)||(hdr.bits<8)||
+     ((hdr.bits%8)!=0)) {
+    *err_msg="unrecognized filter format";
+    return false;
+  }
+  QByteArray bits=file.read(hdr.bits/8);
+  if((uint64_t)bits.size()!=(hdr.bits/8)) {
+    *err_msg="truncated filter";
+    return false;
+  }
+  d_bits=bits;
+  d_nbits=hdr.bits;
+  d_hashes=hdr.hashes;
+  d_insertions=hdr.insertions;
+  d_has_tokens=(hdr.flags&BLOOMFILTER_FLAG_TOKENS)!=0;
+
+  return true;
+}
+
+
+QByteArray BloomFilter::hostKey(const QByteArray &hostname)
+{
+  return "h:"+hostname;
+}
+
+
+QByteArray BloomFilter::appKey(const QByteArray &app_name)
+{
+  return "a:"+app_name;
+}
+
+
+QByteArray BloomFilter::tokenKey(const QByteArray &token)
+{
+  return "t:"+token.toLower();
+}
+
+
+QString BloomFilter::sidecarPathname(const QString &pathname)
+{
+  const char *suffixes[]={".gz",".xz",".zst",".lwa",NULL};
+  QString ret=pathname;
+
+  for(int i=0;suffixes[i]!=NULL;i++) {
+    if(ret.endsWith(suffixes[i])) {
+      ret=ret.left(ret.length()-strlen(suffixes[i]));
+      break;
+    }
+  }
+  return ret+BLOOMFILTER_SUFFIX;
+}
+
+
+void BloomFilter::Hash(const QByteArray &key,uint64_t *h1,uint64_t *h2) const
+{
+  //
+  // FNV-1a, then a splitmix64 finalizer to derive the second hash for
+  // double hashing (Kirsch-Mitzenmacher).
+  //
+  uint64_t h=0xcbf29ce484222325ull;
+  for(int i=0;i<key.size();i++) {
+    h^=(uint8_t)key.at(i);
+    h*=0x100000001b3ull;
+  }
+  *h1=h;
+  h+=0x9e3779b97f4a7c15ull;
+  h=(h^(h>>30))*0xbf58476d1ce4e5b9ull;
+  h=(h^(h>>27))*0x94d049bb133111ebull;
+  *h2=(h^(h>>31))|1;
+}
+
+
+uint64_t BloomFilter::bitsForItems(uint64_t items)
+{
+  uint64_t bits=items*BLOOMFILTER_BITS_PER_ITEM;
+
+  if(bits<BLOOMFILTER_DEFAULT_BITS) {
+    return BLOOMFILTER_DEFAULT_BITS;
+  }
+  if(bits>BLOOMFILTER_MAX_BITS) {
+    return BLOOMFILTER_MAX_BITS;
+  }
+  return bits;
+}
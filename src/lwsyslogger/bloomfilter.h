@@ -0,0 +1,96 @@
+// bloomfilter.h
+//
+// Bloom filter for recording which keys occur in a logfile.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef BLOOMFILTER_H
+#define BLOOMFILTER_H
+
+#include <stdint.h>
+
+#include <QByteArray>
+#include <QString>
+
+//
+// A filter is saved as a BloomFilterHeader followed by 'bits'/8 bytes of
+// bit array, in host byte order. Sidecar files are named after the
+// rotated logfile (before any compression suffix) with BLOOMFILTER_SUFFIX
+// appended. Filters recording message tokens have BLOOMFILTER_FLAG_TOKENS
+// set, so that a reader knows whether a missing token rules a file out.
+//
+#define BLOOMFILTER_MAGIC "LWBLOOM"
+#define BLOOMFILTER_VERSION 2
+#define BLOOMFILTER_SUFFIX ".bloom"
+#define BLOOMFILTER_FLAG_TOKENS 1
+
+//
+// Defaults
+//
+#define BLOOMFILTER_DEFAULT_BITS 65536
+#define BLOOMFILTER_DEFAULT_HASHES 7
+#define BLOOMFILTER_MIN_TOKEN_LENGTH 3
+#define BLOOMFILTER_BITS_PER_ITEM 10
+#define BLOOMFILTER_MAX_BITS 67108864
+#define BLOOMFILTER_DEFAULT_TOKEN_ITEMS 209715
+#define BLOOMFILTER_BYTES_PER_TOKEN 16
+#define BLOOMFILTER_MAX_FALSE_POSITIVES 0.1
+
+struct BloomFilterHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t hashes;
+  uint64_t bits;
+  uint64_t insertions;
+  uint32_t flags;
+  uint32_t reserved;
+};
+
+class BloomFilter
+{
+ public:
+  BloomFilter(uint64_t bits=BLOOMFILTER_DEFAULT_BITS,
+	      uint32_t hashes=BLOOMFILTER_DEFAULT_HASHES);
+  uint64_t bits() const;
+  uint64_t insertions() const;
+  bool isEmpty() const;
+  bool hasTokens() const;
+  void setHasTokens(bool state);
+  double falsePositiveRate() const;
+  void insert(const QByteArray &key);
+  bool mayContain(const QByteArray &key) const;
+  void clear();
+  bool save(const QString &pathname,QString *err_msg) const;
+  bool load(const QString &pathname,QString *err_msg);
+  static QByteArray hostKey(const QByteArray &hostname);
+  static QByteArray appKey(const QByteArray &app_name);
+  static QByteArray tokenKey(const QByteArray &token);
+  static QString sidecarPathname(const QString &pathname);
+  static uint64_t bitsForItems(uint64_t items);
+
+ private:
+  void Hash(const QByteArray &key,uint64_t *h1,uint64_t *h2) const;
+  QByteArray d_bits;
+  uint64_t d_nbits;
+  uint32_t d_hashes;
+  uint64_t d_insertions;
+  bool d_has_tokens;
+};
+
+
+#endif  // BLOOMFILTER_H
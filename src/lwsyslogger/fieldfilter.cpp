@@ -0,0 +1,243 @@
+// fieldfilter.cpp
+//
+// Match a message header field against exact, prefix and glob patterns.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <fnmatch.h>
+#include <string.h>
+
+#include "fieldfilter.h"
+
+//
+// Trie roots
+//
+#define FIELDFILTER_PREFIX_ROOT 0
+#define FIELDFILTER_SUFFIX_ROOT 1
+
+FieldFilter::FieldFilter(bool fold_case)
+{
+  d_fold_case=fold_case;
+  memset(d_class_map,0,sizeof(d_class_map));
+  d_classes=0;
+}
+
+
+bool FieldFilter::isEmpty() const
+{
+  return d_patterns.isEmpty();
+}
+
+
+bool FieldFilter::addPattern(const QString &pattern,QString *err_msg)
+{
+  QByteArray raw=(d_fold_case?pattern.toLower():pattern).toUtf8();
+  int meta=-1;
+  int stars=0;
+
+  if(raw.isEmpty()) {
+    *err_msg="empty pattern";
+    return false;
+  }
+  for(int i=0;i<raw.size();i++) {
+    switch(raw.at(i)) {
+    case '*':
+      stars++;
+      // Fall through
+
+    case '?':
+      if(meta<0) {
+	meta=i;
+      }
+      break;
+
+    case '\\':
+      //
+      // fnmatch(3) takes the escaped character literally, so it must
+      // not be counted as a wildcard, nor the pattern looked up as is.
+      //
+      if(meta<0) {
+	meta=i;
+      }
+      i++;
+      break;
+
+    case '[':
+      if(meta<0) {
+	meta=i;
+      }
+      //
+      // fnmatch(3) would quietly take an unterminated bracket as a
+      // literal; almost certainly not what was meant here.
+      //
+      i++;
+      if((i<raw.size())&&(raw.at(i)=='!')) {
+	i++;
+      }
+      if((i<raw.size())&&(raw.at(i)==']')) {
+	i++;
+      }
+      while((i<raw.size())&&(raw.at(i)!=']')) {
+	i++;
+      }
+      if(i==raw.size()) {
+	*err_msg=QString::asprintf("unterminated \"[\" in pattern \"%s\"",
+				   pattern.toUtf8().constData());
+	return false;
+      }
+      break;
+    }
+  }
+
+  if(meta<0) {
+    d_exact.insert(raw);
+  }
+  else {
+    if((stars==1)&&(meta==(raw.size()-1))) {
+      d_prefixes.push_back(raw.left(meta));
+    }
+    else {
+      if((stars==1)&&(meta==0)&&
+	 (strpbrk(raw.constData()+1,"*?[\\")==NULL)) {
+	d_suffixes.push_back(raw.mid(1));
+      }
+      else {
+	Glob glob;
+	glob.prefix=raw.left(meta);
+	glob.tail=raw.mid(meta);
+	glob.next=-1;
+	d_globs.push_back(glob);
+      }
+    }
+  }
+  d_patterns.push_back(pattern);
+
+  return true;
+}
+
+
+void FieldFilter::compile()
+{
+  //
+  // Bytes that never appear in a trie key all share class 0, which has
+  // no transitions.
+  //
+  QVector<QByteArray> keys=d_prefixes;
+  keys+=d_suffixes;
+  for(int i=0;i<d_globs.size();i++) {
+    keys.push_back(d_globs.at(i).prefix);
+  }
+  memset(d_class_map,0,sizeof(d_class_map));
+  d_classes=1;
+  for(int i=0;i<keys.size();i++) {
+    for(int j=0;j<keys.at(i).size();j++) {
+      uint8_t c=keys.at(i).at(j);
+      if(d_class_map[c]==0) {
+	d_class_map[c]=d_classes++;
+      }
+    }
+  }
+
+  d_table.fill(0,2*d_classes);
+  d_accept.fill(0,2);
+  d_first_glob.fill(-1,2);
+  for(int i=0;i<d_prefixes.size();i++) {
+    d_accept[Insert(FIELDFILTER_PREFIX_ROOT,d_prefixes.at(i),false)]=1;
+  }
+  for(int i=0;i<d_suffixes.size();i++) {
+    d_accept[Insert(FIELDFILTER_SUFFIX_ROOT,d_suffixes.at(i),true)]=1;
+  }
+  for(int i=0;i<d_globs.size();i++) {
+    int node=Insert(FIELDFILTER_PREFIX_ROOT,d_globs.at(i).prefix,false);
+    d_globs[i].next=d_first_glob.at(node);
+    d_first_glob[node]=i;
+  }
+}
+
+
+bool FieldFilter::contains(const QString &value) const
+{
+  if(d_patterns.isEmpty()) {
+    return true;
+  }
+  QByteArray key=(d_fold_case?value.toLower():value).toUtf8();
+
+  return d_exact.contains(key)||
+    Walk(FIELDFILTER_PREFIX_ROOT,key,false)||
+    Walk(FIELDFILTER_SUFFIX_ROOT,key,true);
+}
+
+
+int FieldFilter::trieNodes() const
+{
+  return d_accept.size();
+}
+
+
+QString FieldFilter::patterns() const
+{
+  return d_patterns.join(",");
+}
+
+
+int FieldFilter::Insert(int root,const QByteArray &key,bool reverse)
+{
+  int node=root;
+
+  for(int i=0;i<key.size();i++) {
+    uint8_t c=key.at(reverse?(key.size()-1-i):i);
+    int slot=node*d_classes+d_class_map[c];
+    if(d_table.at(slot)==0) {
+      int next=d_accept.size();
+      d_table.resize(d_table.size()+d_classes);
+      d_accept.push_back(0);
+      d_first_glob.push_back(-1);
+      d_table[slot]=next;
+    }
+    node=d_table.at(slot);
+  }
+
+  return node;
+}
+
+
+bool FieldFilter::Walk(int root,const QByteArray &key,bool reverse) const
+{
+  int node=root;
+  int i=0;
+
+  while(true) {
+    if(d_accept.at(node)!=0) {
+      return true;
+    }
+    for(int j=d_first_glob.at(node);j>=0;j=d_globs.at(j).next) {
+      if(fnmatch(d_globs.at(j).tail.constData(),key.constData()+i,0)==0) {
+	return true;
+      }
+    }
+    if(i==key.size()) {
+      return false;
+    }
+    uint8_t c=key.at(reverse?(key.size()-1-i):i);
+    if((node=d_table.at(node*d_classes+d_class_map[c]))==0) {
+      return false;
+    }
+    i++;
+  }
+
+  return false;
+}
@@ -0,0 +1,75 @@
+// fieldfilter.h
+//
+// Match a message header field against exact, prefix and glob patterns.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef FIELDFILTER_H
+#define FIELDFILTER_H
+
+#include <stdint.h>
+
+#include <QByteArray>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class FieldFilter
+{
+ public:
+  FieldFilter(bool fold_case=false);
+  bool isEmpty() const;
+  bool addPattern(const QString &pattern,QString *err_msg);
+  void compile();
+  bool contains(const QString &value) const;
+  int trieNodes() const;
+  QString patterns() const;
+
+ private:
+  struct Glob {
+    QByteArray prefix;
+    QByteArray tail;
+    int next;
+  };
+  int Insert(int root,const QByteArray &key,bool reverse);
+  bool Walk(int root,const QByteArray &key,bool reverse) const;
+  bool d_fold_case;
+  QStringList d_patterns;
+
+  //
+  // Exact values
+  //
+  QSet<QByteArray> d_exact;
+
+  //
+  // "prefix*" and "*suffix" values, as a pair of tries sharing one
+  // transition table. Globs hang off the prefix trie node for their
+  // leading literal, so only those whose literal matches get tried.
+  //
+  QVector<QByteArray> d_prefixes;
+  QVector<QByteArray> d_suffixes;
+  QVector<Glob> d_globs;
+  uint8_t d_class_map[256];
+  int d_classes;
+  QVector<int32_t> d_table;
+  QVector<uint8_t> d_accept;
+  QVector<int32_t> d_first_glob;
+};
+
+
+#endif  // FIELDFILTER_H
@@ -0,0 +1,309 @@
+// handoff.cpp
+//
+// Pass bound receiver sockets to a new lwsyslogger instance.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include "handoff.h"
+#include "listensockets.h"
+#include "local_syslog.h"
+
+HandoffServer::HandoffServer(const QMap<QString,Receiver *> *recvs,
+			     QObject *parent)
+  : QObject(parent)
+{
+  d_receivers=recvs;
+  d_listen_fd=-1;
+  d_listen_notifier=NULL;
+  d_conn_fd=-1;
+  d_conn_notifier=NULL;
+}
+
+
+HandoffServer::~HandoffServer()
+{
+  CloseConnection();
+  if(d_listen_notifier!=NULL) {
+    delete d_listen_notifier;
+  }
+  if(d_listen_fd>=0) {
+    close(d_listen_fd);
+  }
+}
+
+
+bool HandoffServer::listen(const QString &pathname,QString *err_msg)
+{
+  struct sockaddr_un sa;
+
+  if((size_t)pathname.toUtf8().size()>=sizeof(sa.sun_path)) {
+    *err_msg="socket path is too long";
+    return false;
+  }
+  if((d_listen_fd=socket(AF_UNIX,SOCK_STREAM|SOCK_NONBLOCK|SOCK_CLOEXEC,
+			 0))<0) {
+    *err_msg=strerror(errno);
+    return false;
+  }
+  memset(&sa,0,sizeof(sa));
+  sa.sun_family=AF_UNIX;
+  strncpy(sa.sun_path,pathname.toUtf8(),sizeof(sa.sun_path)-1);
+
+  //
+  // A socket left over from a previous instance (including one that
+  // has just handed off to us) is simply replaced.
+  //
+  unlink(sa.sun_path);
+  mode_t mask=umask(0077);
+  if(bind(d_listen_fd,(struct sockaddr *)&sa,sizeof(sa))!=0) {
+    *err_msg=strerror(errno);
+    umask(mask);
+    close(d_listen_fd);
+    d_listen_fd=-1;
+    return false;
+  }
+  umask(mask);
+  if(::listen(d_listen_fd,1)!=0) {
+    *err_msg=strerror(errno);
+    close(d_listen_fd);
+    d_listen_fd=-1;
+    return false;
+  }
+  d_listen_notifier=
+    new QSocketNotifier(d_listen_fd,QSocketNotifier::Read,this);
+  connect(d_listen_notifier,SIGNAL(activated(int)),
+	  this,SLOT(connectionData(int)));
+
+  return true;
+}
+
+
+int HandoffServer::takeover(const QString &pathname,QString *err_msg)
+{
+  struct sockaddr_un sa;
+  struct msghdr msg;
+  struct iovec iov;
+  char buffer[256];
+  char control[CMSG_SPACE(sizeof(int)*HANDOFF_MAX_SOCKETS)];
+  struct timeval tv;
+  QList<int> fds;
+  int fd=-1;
+  int n;
+
+  if((size_t)pathname.toUtf8().size()>=sizeof(sa.sun_path)) {
+    *err_msg="socket path is too long";
+    return -1;
+  }
+  if((fd=socket(AF_UNIX,SOCK_STREAM|SOCK_CLOEXEC,0))<0) {
+    *err_msg=strerror(errno);
+    return -1;
+  }
+
+  //
+  // Don't hang at startup if the old instance is wedged
+  //
+  tv.tv_sec=HANDOFF_TIMEOUT/1000;
+  tv.tv_usec=1000*(HANDOFF_TIMEOUT%1000);
+  if((setsockopt(fd,SOL_SOCKET,SO_RCVTIMEO,&tv,sizeof(tv))!=0)||
+     (setsockopt(fd,SOL_SOCKET,SO_SNDTIMEO,&tv,sizeof(tv))!=0)) {
+    *err_msg=strerror(errno);
+    close(fd);
+    return -1;
+  }
+  memset(&sa,0,sizeof(sa));
+  sa.sun_family=AF_UNIX;
+  strncpy(sa.sun_path,pathname.toUtf8(),sizeof(sa.sun_path)-1);
+  if(::connect(fd,(struct sockaddr *)&sa,sizeof(sa))!=0) {
+    *err_msg=(errno==EAGAIN)?QString("timed out"):QString(strerror(errno));
+    close(fd);
+    return -1;
+  }
+
+  memset(&msg,0,sizeof(msg));
+  iov.iov_base=buffer;
+  iov.iov_len=sizeof(buffer);
+  msg.msg_iov=&iov;
+  msg.msg_iovlen=1;
+  msg.msg_control=control;
+  msg.msg_controllen=sizeof(control);
+  if((n=recvmsg(fd,&msg,MSG_CMSG_CLOEXEC))<=0) {
+    if(n==0) {
+      *err_msg="connection closed";
+    }
+    else {
+      if((errno==EAGAIN)||(errno==EWOULDBLOCK)) {
+	*err_msg="timed out";
+      }
+      else {
+	*err_msg=strerror(errno);
+      }
+    }
+    close(fd);
+    return -1;
+  }
+  for(struct cmsghdr *cmsg=CMSG_FIRSTHDR(&msg);cmsg!=NULL;
+      cmsg=CMSG_NXTHDR(&msg,cmsg)) {
+    if((cmsg->cmsg_level==SOL_SOCKET)&&(cmsg->cmsg_type==SCM_RIGHTS)) {
+      int count=(cmsg->cmsg_len-CMSG_LEN(0))/sizeof(int);
+      for(int i=0;i<count;i++) {
+	int recv_fd;
+	memcpy(&recv_fd,CMSG_DATA(cmsg)+i*sizeof(int),sizeof(int));
+	fds.push_back(recv_fd);
+      }
+    }
+  }
+
+  //
+  // If the control data was cut short then some sockets are missing, so
+  // don't take over only part of the set.
+  //
+  if((msg.msg_flags&MSG_CTRUNC)!=0) {
+    for(int i=0;i<fds.size();i++) {
+      close(fds.at(i));
+    }
+    *err_msg="socket list was truncated";
+    close(fd);
+    return -1;
+  }
+  for(int i=0;i<fds.size();i++) {
+    ListenSockets::add(fds.at(i));
+  }
+
+  return fd;
+}
+
+
+void HandoffServer::acknowledge(int fd)
+{
+  char ack=HANDOFF_ACK;
+
+  if(write(fd,&ack,1)!=1) {
+    LocalSyslog(Message::SeverityWarning,"failed to acknowledge handoff [%s]",
+		strerror(errno));
+  }
+  close(fd);
+}
+
+
+void HandoffServer::connectionData(int fd)
+{
+  struct msghdr msg;
+  struct iovec iov;
+  char control[CMSG_SPACE(sizeof(int)*HANDOFF_MAX_SOCKETS)];
+  QList<int> fds;
+
+  int conn_fd=accept4(fd,NULL,NULL,SOCK_CLOEXEC);
+  if(conn_fd<0) {
+    return;
+  }
+  if(d_conn_fd>=0) {
+    LocalSyslog(Message::SeverityWarning,
+		"refusing handoff request, another is already in progress");
+    close(conn_fd);
+    return;
+  }
+  for(QMap<QString,Receiver *>::const_iterator it=d_receivers->begin();
+      it!=d_receivers->end();it++) {
+    fds+=it.value()->socketDescriptors();
+  }
+  if(fds.size()>HANDOFF_MAX_SOCKETS) {
+    LocalSyslog(Message::SeverityWarning,
+		"refusing handoff request, too many sockets (%d)",fds.size());
+    close(conn_fd);
+    return;
+  }
+
+  //
+  // The listing is informational only; the receiving instance identifies
+  // each socket by querying it directly.
+  //
+  QByteArray data=QString::asprintf("%d\n",fds.size()).toUtf8();
+  memset(&msg,0,sizeof(msg));
+  memset(control,0,sizeof(control));
+  iov.iov_base=data.data();
+  iov.iov_len=data.size();
+  msg.msg_iov=&iov;
+  msg.msg_iovlen=1;
+  if(fds.size()>0) {
+    msg.msg_control=control;
+    msg.msg_controllen=CMSG_SPACE(sizeof(int)*fds.size());
+    struct cmsghdr *cmsg=CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level=SOL_SOCKET;
+    cmsg->cmsg_type=SCM_RIGHTS;
+    cmsg->cmsg_len=CMSG_LEN(sizeof(int)*fds.size());
+    for(int i=0;i<fds.size();i++) {
+      ((int *)CMSG_DATA(cmsg))[i]=fds.at(i);
+    }
+  }
+  if(sendmsg(conn_fd,&msg,MSG_NOSIGNAL)<0) {
+    LocalSyslog(Message::SeverityWarning,"failed to send handoff [%s]",
+		strerror(errno));
+    close(conn_fd);
+    return;
+  }
+  LocalSyslog(Message::SeverityNotice,
+	      "handed off %d socket(s), waiting for new instance to start",
+	      fds.size());
+
+  //
+  // Keep receiving until the new instance confirms that it is up. If it
+  // goes away instead, we simply carry on.
+  //
+  d_conn_fd=conn_fd;
+  d_conn_notifier=new QSocketNotifier(d_conn_fd,QSocketNotifier::Read,this);
+  connect(d_conn_notifier,SIGNAL(activated(int)),
+	  this,SLOT(acknowledgeData(int)));
+}
+
+
+void HandoffServer::acknowledgeData(int fd)
+{
+  char ack=0;
+
+  int n=read(fd,&ack,1);
+  CloseConnection();
+  if((n==1)&&(ack==HANDOFF_ACK)) {
+    emit handoffCompleted();
+  }
+  else {
+    LocalSyslog(Message::SeverityWarning,
+		"handoff aborted by new instance, continuing");
+  }
+}
+
+
+void HandoffServer::CloseConnection()
+{
+  if(d_conn_notifier!=NULL) {
+    d_conn_notifier->setEnabled(false);
+    d_conn_notifier->deleteLater();
+    d_conn_notifier=NULL;
+  }
+  if(d_conn_fd>=0) {
+    close(d_conn_fd);
+    d_conn_fd=-1;
+  }
+}
@@ -0,0 +1,65 @@
+// handoff.h
+//
+// Pass bound receiver sockets to a new lwsyslogger instance.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef HANDOFF_H
+#define HANDOFF_H
+
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QSocketNotifier>
+
+#include "receiver.h"
+
+//
+// Protocol Values
+//
+#define HANDOFF_MAX_SOCKETS 64
+#define HANDOFF_ACK 'K'
+#define HANDOFF_TIMEOUT 5000
+
+class HandoffServer : public QObject
+{
+  Q_OBJECT
+ public:
+  HandoffServer(const QMap<QString,Receiver *> *recvs,QObject *parent=0);
+  ~HandoffServer();
+  bool listen(const QString &pathname,QString *err_msg);
+  static int takeover(const QString &pathname,QString *err_msg);
+  static void acknowledge(int fd);
+
+ signals:
+  void handoffCompleted();
+
+ private slots:
+  void connectionData(int fd);
+  void acknowledgeData(int fd);
+
+ private:
+  void CloseConnection();
+  const QMap<QString,Receiver *> *d_receivers;
+  int d_listen_fd;
+  QSocketNotifier *d_listen_notifier;
+  int d_conn_fd;
+  QSocketNotifier *d_conn_notifier;
+};
+
+
+#endif  // HANDOFF_H
@@ -0,0 +1,139 @@
+// listensockets.cpp
+//
+// Registry of pre-bound sockets inherited from systemd or a previous
+// instance.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "local_syslog.h"
+#include "listensockets.h"
+
+static QList<int> __listen_sockets_fds;
+
+int ListenSockets::loadFromEnvironment(QString *err_msg)
+{
+  bool ok=false;
+
+  //
+  // See sd_listen_fds(3)
+  //
+  QString pid_str=getenv("LISTEN_PID");
+  QString fds_str=getenv("LISTEN_FDS");
+  unsetenv("LISTEN_PID");
+  unsetenv("LISTEN_FDS");
+  unsetenv("LISTEN_FDNAMES");
+  if(pid_str.isEmpty()||fds_str.isEmpty()) {
+    return 0;
+  }
+  pid_t pid=pid_str.toInt(&ok);
+  if((!ok)||(pid!=getpid())) {
+    return 0;
+  }
+  int n=fds_str.toInt(&ok);
+  if((!ok)||(n<0)) {
+    *err_msg=QString::asprintf("invalid LISTEN_FDS value \"%s\"",
+			       fds_str.toUtf8().constData());
+    return -1;
+  }
+  for(int i=0;i<n;i++) {
+    int fd=LISTENSOCKETS_SD_LISTEN_FDS_START+i;
+    fcntl(fd,F_SETFD,FD_CLOEXEC);
+    ListenSockets::add(fd);
+  }
+
+  return n;
+}
+
+
+void ListenSockets::add(int fd)
+{
+  __listen_sockets_fds.push_back(fd);
+}
+
+
+int ListenSockets::take(int type,uint16_t port)
+{
+  //
+  // Receivers bind to the wildcard address, so only the socket type and
+  // port need to match.
+  //
+  for(int i=0;i<__listen_sockets_fds.size();i++) {
+    int fd=__listen_sockets_fds.at(i);
+    int sock_type=0;
+    socklen_t len=sizeof(sock_type);
+    struct sockaddr_storage sa;
+    socklen_t sa_len=sizeof(sa);
+
+    if(getsockopt(fd,SOL_SOCKET,SO_TYPE,&sock_type,&len)!=0) {
+      continue;
+    }
+    if(sock_type!=type) {
+      continue;
+    }
+    memset(&sa,0,sizeof(sa));
+    if(getsockname(fd,(struct sockaddr *)&sa,&sa_len)!=0) {
+      continue;
+    }
+    uint16_t sock_port=0;
+    if(sa.ss_family==AF_INET) {
+      sock_port=ntohs(((struct sockaddr_in *)&sa)->sin_port);
+    }
+    if(sa.ss_family==AF_INET6) {
+      sock_port=ntohs(((struct sockaddr_in6 *)&sa)->sin6_port);
+    }
+    if(sock_port==port) {
+      __listen_sockets_fds.removeAt(i);
+      return fd;
+    }
+  }
+
+  return -1;
+}
+
+
+void ListenSockets::discard(int fd)
+{
+  if(__listen_sockets_fds.removeAll(fd)>0) {
+    close(fd);
+  }
+}
+
+
+int ListenSockets::size()
+{
+  return __listen_sockets_fds.size();
+}
+
+
+void ListenSockets::closeUnused()
+{
+  for(int i=0;i<__listen_sockets_fds.size();i++) {
+    LocalSyslog(Message::SeverityWarning,
+		"closing unused inherited socket (fd %d)",
+		__listen_sockets_fds.at(i));
+    close(__listen_sockets_fds.at(i));
+  }
+  __listen_sockets_fds.clear();
+}
@@ -0,0 +1,47 @@
+// listensockets.h
+//
+// Registry of pre-bound sockets inherited from systemd or a previous
+// instance.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef LISTENSOCKETS_H
+#define LISTENSOCKETS_H
+
+#include <stdint.h>
+
+#include <QList>
+#include <QString>
+
+//
+// First descriptor passed by systemd(1) socket activation
+//
+#define LISTENSOCKETS_SD_LISTEN_FDS_START 3
+
+class ListenSockets
+{
+ public:
+  static int loadFromEnvironment(QString *err_msg);
+  static void add(int fd);
+  static int take(int type,uint16_t port);
+  static void discard(int fd);
+  static int size();
+  static void closeUnused();
+};
+
+
+#endif  // LISTENSOCKETS_H
@@ -0,0 +1,63 @@
+// livetail.cpp
+//
+// Feed received messages to live tail subscribers.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include "livetail.h"
+
+LiveTail::LiveTail(const QString &id,int slots,const QString &tmpl,
+		   QObject *parent)
+  : QObject(parent)
+{
+  d_template=tmpl;
+  d_ring=new LiveTailRing(slots);
+  d_server=new LiveTailServer(id,d_ring);
+}
+
+
+LiveTail::~LiveTail()
+{
+  delete d_server;
+  delete d_ring;
+}
+
+
+bool LiveTail::start(const QString &socket_path,const QHostAddress &addr,
+		     uint16_t port,QString *err_msg)
+{
+  return d_server->start(socket_path,addr,port,err_msg);
+}
+
+
+void LiveTail::stop()
+{
+  d_server->stop();
+}
+
+
+void LiveTail::process(Message *msg,const QHostAddress &from_addr)
+{
+  //
+  // Don't spend time formatting lines that no one will read
+  //
+  if(!d_server->hasSubscribers()) {
+    return;
+  }
+  d_ring->push(msg->facility(),msg->severity(),msg->hostName().toUtf8(),
+	       msg->resolveWildcards(d_template,from_addr).toUtf8());
+}
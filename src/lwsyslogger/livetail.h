@@ -0,0 +1,59 @@
+// livetail.h
+//
+// Feed received messages to live tail subscribers.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef LIVETAIL_H
+#define LIVETAIL_H
+
+#include <stdint.h>
+
+#include <QHostAddress>
+#include <QObject>
+
+#include "livetailring.h"
+#include "livetailserver.h"
+#include "message.h"
+
+//
+// Defaults
+//
+#define LIVETAIL_DEFAULT_TEMPLATE "%t %h %m"
+
+class LiveTail : public QObject
+{
+  Q_OBJECT
+ public:
+  LiveTail(const QString &id,int slots,const QString &tmpl,
+	   QObject *parent=0);
+  ~LiveTail();
+  bool start(const QString &socket_path,const QHostAddress &addr,
+	     uint16_t port,QString *err_msg);
+  void stop();
+
+ public slots:
+  void process(Message *msg,const QHostAddress &from_addr);
+
+ private:
+  QString d_template;
+  LiveTailRing *d_ring;
+  LiveTailServer *d_server;
+};
+
+
+#endif  // LIVETAIL_H
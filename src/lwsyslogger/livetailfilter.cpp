@@ -0,0 +1,128 @@
+// livetailfilter.cpp
+//
+// Subscription filter for live tail clients.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <fnmatch.h>
+
+#include <QStringList>
+
+#include "livetailfilter.h"
+#include "processor.h"
+
+LiveTailFilter::LiveTailFilter()
+{
+  d_facility_mask=0xFFFFFFFF;
+  d_severity_mask=0xFFFFFFFF;
+}
+
+
+bool LiveTailFilter::parse(const QString &expr,QString *err_msg)
+{
+  QStringList terms;
+  QString term;
+  bool quoted=false;
+  bool ok=false;
+
+  //
+  // The expression is a list of whitespace separated <key>=<value> terms,
+  // any of which may be omitted. Values can be double-quoted so as to
+  // contain whitespace. Facility and severity lists take the same form as
+  // the 'Facility=' and 'Severity=' processor parameters.
+  //
+  for(int i=0;i<expr.length();i++) {
+    QChar c=expr.at(i);
+    if(c=='"') {
+      quoted=!quoted;
+    }
+    else {
+      if(c.isSpace()&&(!quoted)) {
+	if(!term.isEmpty()) {
+	  terms.push_back(term);
+	  term.clear();
+	}
+      }
+      else {
+	term+=c;
+      }
+    }
+  }
+  if(quoted) {
+    *err_msg="unterminated quote";
+    return false;
+  }
+  if(!term.isEmpty()) {
+    terms.push_back(term);
+  }
+
+  for(int i=0;i<terms.size();i++) {
+    int eq=terms.at(i).indexOf("=");
+    if(eq<1) {
+      *err_msg="malformed term \""+terms.at(i)+"\"";
+      return false;
+    }
+    QString key=terms.at(i).left(eq).toLower();
+    QString value=terms.at(i).mid(eq+1);
+    if(key=="facility") {
+      d_facility_mask=Processor::makeFacilityMask(value,&ok,err_msg);
+      if(!ok) {
+	return false;
+      }
+    }
+    else if(key=="severity") {
+      d_severity_mask=Processor::makeSeverityMask(value,&ok,err_msg);
+      if(!ok) {
+	return false;
+      }
+    }
+    else if(key=="host") {
+      d_host_glob=value.toUtf8();
+    }
+    else if(key=="match") {
+      d_substring=value.toUtf8();
+    }
+    else {
+      *err_msg="unknown key \""+key+"\"";
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+bool LiveTailFilter::matches(const LiveTailEntry &entry) const
+{
+  //
+  // Cheapest tests first
+  //
+  if(((d_facility_mask&(1u<<entry.facility))==0)||
+     ((d_severity_mask&(1u<<entry.severity))==0)) {
+    return false;
+  }
+  if((!d_host_glob.isEmpty())&&
+     (fnmatch(d_host_glob.constData(),entry.host.constData(),
+	      FNM_CASEFOLD)!=0)) {
+    return false;
+  }
+  if((!d_substring.isEmpty())&&(!entry.line.contains(d_substring))) {
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,46 @@
+// livetailfilter.h
+//
+// Subscription filter for live tail clients.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef LIVETAILFILTER_H
+#define LIVETAILFILTER_H
+
+#include <stdint.h>
+
+#include <QByteArray>
+#include <QString>
+
+#include "livetailring.h"
+
+class LiveTailFilter
+{
+ public:
+  LiveTailFilter();
+  bool parse(const QString &expr,QString *err_msg);
+  bool matches(const LiveTailEntry &entry) const;
+
+ private:
+  uint32_t d_facility_mask;
+  uint32_t d_severity_mask;
+  QByteArray d_host_glob;
+  QByteArray d_substring;
+};
+
+
+#endif  // LIVETAILFILTER_H
@@ -0,0 +1,126 @@
+// livetailring.cpp
+//
+// Lock-free ring of recent messages for live tail subscribers.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <string.h>
+
+#include "livetailring.h"
+
+LiveTailRing::LiveTailRing(int slots)
+{
+  d_slots=1;
+  while(d_slots<slots) {
+    d_slots*=2;
+  }
+  d_mask=d_slots-1;
+  d_sequences=new std::atomic<uint64_t>[d_slots];
+  for(int i=0;i<d_slots;i++) {
+    d_sequences[i].store(0,std::memory_order_relaxed);
+  }
+  d_data=new char[(size_t)d_slots*LIVETAILRING_SLOT_SIZE];
+  d_head.store(0,std::memory_order_relaxed);
+}
+
+
+LiveTailRing::~LiveTailRing()
+{
+  delete[] d_data;
+  delete[] d_sequences;
+}
+
+
+int LiveTailRing::slots() const
+{
+  return d_slots;
+}
+
+
+uint64_t LiveTailRing::head() const
+{
+  return d_head.load(std::memory_order_acquire);
+}
+
+
+void LiveTailRing::push(uint8_t facility,uint8_t severity,
+			const QByteArray &host,const QByteArray &line)
+{
+  SlotHeader hdr;
+
+  //
+  // Single writer. Each slot carries a sequence lock: odd while the slot
+  // is being written, and 2*(seq+1) once record 'seq' is complete, so
+  // that readers can detect records overwritten under them. Lines too
+  // long for a slot are truncated.
+  //
+  uint64_t seq=d_head.load(std::memory_order_relaxed);
+  std::atomic<uint64_t> *lock=d_sequences+(seq&d_mask);
+  char *data=d_data+(seq&d_mask)*LIVETAILRING_SLOT_SIZE;
+
+  hdr.facility=facility;
+  hdr.severity=severity;
+  hdr.host_length=
+    qMin(host.size(),(int)(LIVETAILRING_SLOT_SIZE-sizeof(hdr))/2);
+  hdr.line_length=
+    qMin(line.size(),(int)(LIVETAILRING_SLOT_SIZE-sizeof(hdr))-
+	 hdr.host_length);
+  lock->store(2*seq+1,std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  memcpy(data,&hdr,sizeof(hdr));
+  memcpy(data+sizeof(hdr),host.constData(),hdr.host_length);
+  memcpy(data+sizeof(hdr)+hdr.host_length,line.constData(),hdr.line_length);
+  lock->store(2*seq+2,std::memory_order_release);
+  d_head.store(seq+1,std::memory_order_release);
+}
+
+
+LiveTailRing::Result LiveTailRing::read(uint64_t seq,
+					LiveTailEntry *entry) const
+{
+  SlotHeader hdr;
+  char data[LIVETAILRING_SLOT_SIZE];
+
+  uint64_t head=d_head.load(std::memory_order_acquire);
+  if(seq>=head) {
+    return LiveTailRing::ResultEmpty;
+  }
+  if((head-seq)>(uint64_t)d_slots) {
+    return LiveTailRing::ResultOverrun;
+  }
+  const std::atomic<uint64_t> *lock=d_sequences+(seq&d_mask);
+  uint64_t before=lock->load(std::memory_order_acquire);
+  if(before!=(2*seq+2)) {
+    return LiveTailRing::ResultOverrun;
+  }
+  memcpy(data,d_data+(seq&d_mask)*LIVETAILRING_SLOT_SIZE,sizeof(data));
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if(lock->load(std::memory_order_relaxed)!=before) {
+    return LiveTailRing::ResultOverrun;
+  }
+
+  //
+  // The copy is now known to be consistent
+  //
+  memcpy(&hdr,data,sizeof(hdr));
+  entry->facility=hdr.facility;
+  entry->severity=hdr.severity;
+  entry->host=QByteArray(data+sizeof(hdr),hdr.host_length);
+  entry->line=QByteArray(data+sizeof(hdr)+hdr.host_length,hdr.line_length);
+
+  return LiveTailRing::ResultOk;
+}
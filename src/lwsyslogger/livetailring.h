@@ -0,0 +1,72 @@
+// livetailring.h
+//
+// Lock-free ring of recent messages for live tail subscribers.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef LIVETAILRING_H
+#define LIVETAILRING_H
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include <QByteArray>
+
+//
+// Defaults
+//
+#define LIVETAILRING_DEFAULT_SLOTS 4096
+#define LIVETAILRING_SLOT_SIZE 2048
+
+struct LiveTailEntry
+{
+  uint8_t facility;
+  uint8_t severity;
+  QByteArray host;
+  QByteArray line;
+};
+
+
+class LiveTailRing
+{
+ public:
+  enum Result {ResultOk=0,ResultEmpty=1,ResultOverrun=2};
+  LiveTailRing(int slots=LIVETAILRING_DEFAULT_SLOTS);
+  ~LiveTailRing();
+  int slots() const;
+  uint64_t head() const;
+  void push(uint8_t facility,uint8_t severity,const QByteArray &host,
+	    const QByteArray &line);
+  Result read(uint64_t seq,LiveTailEntry *entry) const;
+
+ private:
+  struct SlotHeader {
+    uint8_t facility;
+    uint8_t severity;
+    uint16_t host_length;
+    uint16_t line_length;
+  };
+  int d_slots;
+  uint64_t d_mask;
+  std::atomic<uint64_t> *d_sequences;
+  char *d_data;
+  std::atomic<uint64_t> d_head;
+};
+
+
+#endif  // LIVETAILRING_H
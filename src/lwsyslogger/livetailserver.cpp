@@ -0,0 +1,303 @@
+// livetailserver.cpp
+//
+// Serve live tail subscriptions over local and TCP sockets.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <QLocalSocket>
+#include <QTcpSocket>
+
+#include "livetailserver.h"
+
+LiveTailServer::LiveTailServer(const QString &id,LiveTailRing *ring)
+  : QObject()
+{
+  d_ring=ring;
+  d_local_server=NULL;
+  d_tcp_server=NULL;
+  d_port=0;
+  d_socket_inode=0;
+  d_poll_timer=NULL;
+  d_active_subscribers.store(0);
+  d_subscribers_gauge=Metrics::gauge("livetail",id,"subscribers",
+				     "Connected live tail subscribers");
+  d_sent_counter=Metrics::counter("livetail",id,"lines_sent",
+				  "Lines sent to live tail subscribers");
+  d_lagged_counter=Metrics::counter("livetail",id,"lines_lagged",
+		       "Lines missed by live tail subscribers that fell behind");
+
+  //
+  // Subscribers are served from a thread of their own, so that a slow
+  // one can never hold up message processing, which only ever writes
+  // into the ring.
+  //
+  d_thread=new QThread();
+  d_thread->setObjectName("LiveTailServer");
+  moveToThread(d_thread);
+  d_thread->start(QThread::LowPriority);
+}
+
+
+LiveTailServer::~LiveTailServer()
+{
+  stop();
+  delete d_thread;
+}
+
+
+bool LiveTailServer::start(const QString &socket_path,const QHostAddress &addr,
+			   uint16_t port,QString *err_msg)
+{
+  bool ret=false;
+
+  d_socket_path=socket_path;
+  d_address=addr;
+  d_port=port;
+  QMetaObject::invokeMethod(this,"listen",Qt::BlockingQueuedConnection,
+			    Q_RETURN_ARG(bool,ret));
+  if(!ret) {
+    *err_msg=d_error_string;
+  }
+
+  return ret;
+}
+
+
+void LiveTailServer::stop()
+{
+  if(d_thread->isRunning()) {
+    d_thread->quit();
+    d_thread->wait();
+    //
+    // After a takeover, the path may already belong to the new instance.
+    //
+    struct stat st;
+    if((!d_socket_path.isEmpty())&&
+       (stat(d_socket_path.toUtf8(),&st)==0)&&(st.st_ino==d_socket_inode)) {
+      unlink(d_socket_path.toUtf8());
+    }
+  }
+}
+
+
+bool LiveTailServer::hasSubscribers() const
+{
+  return d_active_subscribers.load(std::memory_order_relaxed)>0;
+}
+
+
+bool LiveTailServer::listen()
+{
+  d_poll_timer=new QTimer(this);
+  d_poll_timer->setTimerType(Qt::CoarseTimer);
+  connect(d_poll_timer,SIGNAL(timeout()),this,SLOT(pollData()));
+
+  if(!d_socket_path.isEmpty()) {
+    d_local_server=new QLocalServer(this);
+    d_local_server->
+      setSocketOptions(QLocalServer::UserAccessOption|
+		       QLocalServer::GroupAccessOption);
+    connect(d_local_server,SIGNAL(newConnection()),
+	    this,SLOT(localConnectionData()));
+    QLocalServer::removeServer(d_socket_path);
+    if(!d_local_server->listen(d_socket_path)) {
+      d_error_string=d_local_server->errorString();
+      return false;
+    }
+    struct stat st;
+    if(stat(d_socket_path.toUtf8(),&st)==0) {
+      d_socket_inode=st.st_ino;
+    }
+  }
+  if(d_port>0) {
+    d_tcp_server=new QTcpServer(this);
+    connect(d_tcp_server,SIGNAL(newConnection()),
+	    this,SLOT(tcpConnectionData()));
+    if(!d_tcp_server->listen(d_address,d_port)) {
+      d_error_string=d_tcp_server->errorString();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+void LiveTailServer::localConnectionData()
+{
+  QLocalSocket *sock=NULL;
+
+  while((sock=d_local_server->nextPendingConnection())!=NULL) {
+    AddSubscriber(sock);
+  }
+}
+
+
+void LiveTailServer::tcpConnectionData()
+{
+  QTcpSocket *sock=NULL;
+
+  while((sock=d_tcp_server->nextPendingConnection())!=NULL) {
+    AddSubscriber(sock);
+  }
+}
+
+
+void LiveTailServer::readyReadData()
+{
+  QIODevice *sock=(QIODevice *)sender();
+  Subscriber *sub=d_subscribers.value(sock);
+  QString err_msg;
+
+  if(sub==NULL) {
+    return;
+  }
+  if(sub->subscribed) {
+    sock->readAll();  // Nothing more is expected
+    return;
+  }
+  sub->request+=sock->readAll();
+  int nl=sub->request.indexOf('\n');
+  if(nl<0) {
+    if(sub->request.size()>LIVETAILSERVER_MAX_REQUEST_SIZE) {
+      sock->write(LIVETAILSERVER_ERROR " request too long\n");
+      sock->close();
+    }
+    return;
+  }
+  if(!sub->filter.parse(QString::fromUtf8(sub->request.left(nl)).trimmed(),
+			&err_msg)) {
+    sock->write(QByteArray(LIVETAILSERVER_ERROR)+" "+err_msg.toUtf8()+"\n");
+    sock->close();
+    return;
+  }
+  sub->request.clear();
+  sub->subscribed=true;
+  sub->seq=d_ring->head();  // Only messages from now on
+  sock->write(LIVETAILSERVER_OK "\n");
+  d_active_subscribers++;
+  if(!d_poll_timer->isActive()) {
+    d_poll_timer->start(LIVETAILSERVER_POLL_INTERVAL);
+  }
+}
+
+
+void LiveTailServer::disconnectedData()
+{
+  QIODevice *sock=(QIODevice *)sender();
+  Subscriber *sub=d_subscribers.value(sock);
+
+  if(sub!=NULL) {
+    if(sub->subscribed) {
+      d_active_subscribers--;
+    }
+    d_subscribers.remove(sock);
+    d_subscribers_gauge->add(-1);
+    delete sub;
+  }
+  if(d_active_subscribers.load()==0) {
+    d_poll_timer->stop();
+  }
+  sock->deleteLater();
+}
+
+
+void LiveTailServer::requestTimeoutData()
+{
+  QIODevice *sock=(QIODevice *)sender()->parent();
+  Subscriber *sub=d_subscribers.value(sock);
+
+  if((sub!=NULL)&&(!sub->subscribed)) {
+    sock->write(LIVETAILSERVER_ERROR " timed out waiting for filter\n");
+    sock->close();
+  }
+}
+
+
+void LiveTailServer::pollData()
+{
+  for(QMap<QIODevice *,Subscriber *>::const_iterator it=
+	d_subscribers.begin();it!=d_subscribers.end();it++) {
+    if(it.value()->subscribed) {
+      Drain(it.key(),it.value());
+    }
+  }
+}
+
+
+void LiveTailServer::AddSubscriber(QIODevice *sock)
+{
+  Subscriber *sub=new Subscriber();
+  sub->subscribed=false;
+  sub->seq=0;
+  d_subscribers[sock]=sub;
+  d_subscribers_gauge->add(1);
+  connect(sock,SIGNAL(readyRead()),this,SLOT(readyReadData()));
+  connect(sock,SIGNAL(disconnected()),this,SLOT(disconnectedData()));
+
+  QTimer *timer=new QTimer(sock);
+  timer->setSingleShot(true);
+  connect(timer,SIGNAL(timeout()),this,SLOT(requestTimeoutData()));
+  timer->start(LIVETAILSERVER_REQUEST_TIMEOUT);
+}
+
+
+void LiveTailServer::Drain(QIODevice *sock,Subscriber *sub)
+{
+  LiveTailEntry entry;
+  QByteArray data;
+  int count=0;
+  int scanned=0;
+
+  //
+  // A subscriber whose socket is backed up is simply not read for; if it
+  // stays that way the ring will lap it and it will be told so.
+  //
+  if(sock->bytesToWrite()>=LIVETAILSERVER_MAX_PENDING) {
+    return;
+  }
+  while((count<LIVETAILSERVER_MAX_BATCH)&&(scanned++<d_ring->slots())) {
+    LiveTailRing::Result result=d_ring->read(sub->seq,&entry);
+    if(result==LiveTailRing::ResultEmpty) {
+      break;
+    }
+    if(result==LiveTailRing::ResultOverrun) {
+      //
+      // Skip ahead to halfway through the ring, to leave some slack
+      // before being lapped again
+      //
+      uint64_t seq=d_ring->head()-d_ring->slots()/2;
+      d_lagged_counter->increment(seq-sub->seq);
+      data+=QByteArray(LIVETAILSERVER_LAGGED)+" "+
+	QByteArray::number((qulonglong)(seq-sub->seq))+"\n";
+      sub->seq=seq;
+      continue;
+    }
+    if(sub->filter.matches(entry)) {
+      data+=entry.line+"\n";
+      count++;
+    }
+    sub->seq++;
+  }
+  if(!data.isEmpty()) {
+    sock->write(data);
+    d_sent_counter->increment(count);
+  }
+}
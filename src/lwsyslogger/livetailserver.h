@@ -0,0 +1,115 @@
+// livetailserver.h
+//
+// Serve live tail subscriptions over local and TCP sockets.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef LIVETAILSERVER_H
+#define LIVETAILSERVER_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <atomic>
+
+#include <QHostAddress>
+#include <QIODevice>
+#include <QLocalServer>
+#include <QMap>
+#include <QObject>
+#include <QTcpServer>
+#include <QThread>
+#include <QTimer>
+
+#include "livetailfilter.h"
+#include "livetailring.h"
+#include "metrics.h"
+
+//
+// Protocol Values
+//
+// A client sends a single line containing its filter expression, and
+// gets back LIVETAILSERVER_OK or LIVETAILSERVER_ERROR followed by the
+// reason. Clients that don't send one within
+// LIVETAILSERVER_REQUEST_TIMEOUT milliseconds are disconnected. Matching lines follow. A subscriber that falls more than a
+// ring's worth behind is moved up to the current messages and sent
+// LIVETAILSERVER_LAGGED with the number of messages it missed.
+//
+#define LIVETAILSERVER_OK "#OK"
+#define LIVETAILSERVER_ERROR "#ERROR"
+#define LIVETAILSERVER_LAGGED "#LAGGED"
+#define LIVETAILSERVER_MAX_REQUEST_SIZE 4096
+#define LIVETAILSERVER_REQUEST_TIMEOUT 10000
+
+//
+// Defaults
+//
+#define LIVETAILSERVER_DEFAULT_ADDRESS "127.0.0.1"
+#define LIVETAILSERVER_POLL_INTERVAL 50
+#define LIVETAILSERVER_MAX_PENDING 1048576
+#define LIVETAILSERVER_MAX_BATCH 8192
+
+class LiveTailServer : public QObject
+{
+  Q_OBJECT
+ public:
+  LiveTailServer(const QString &id,LiveTailRing *ring);
+  ~LiveTailServer();
+  bool start(const QString &socket_path,const QHostAddress &addr,
+	     uint16_t port,QString *err_msg);
+  void stop();
+  bool hasSubscribers() const;
+
+ public slots:
+  bool listen();
+
+ private slots:
+  void localConnectionData();
+  void tcpConnectionData();
+  void readyReadData();
+  void disconnectedData();
+  void requestTimeoutData();
+  void pollData();
+
+ private:
+  struct Subscriber {
+    bool subscribed;
+    QByteArray request;
+    LiveTailFilter filter;
+    uint64_t seq;
+  };
+  void AddSubscriber(QIODevice *sock);
+  void Drain(QIODevice *sock,Subscriber *sub);
+  QThread *d_thread;
+  LiveTailRing *d_ring;
+  QLocalServer *d_local_server;
+  QTcpServer *d_tcp_server;
+  QString d_socket_path;
+  ino_t d_socket_inode;
+  QHostAddress d_address;
+  uint16_t d_port;
+  QString d_error_string;
+  QTimer *d_poll_timer;
+  QMap<QIODevice *,Subscriber *> d_subscribers;
+  std::atomic<int> d_active_subscribers;
+  MetricsGauge *d_subscribers_gauge;
+  MetricsCounter *d_sent_counter;
+  MetricsCounter *d_lagged_counter;
+};
+
+
+#endif  // LIVETAILSERVER_H
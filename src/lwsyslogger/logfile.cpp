@@ -0,0 +1,256 @@
+// logfile.cpp
+//
+// Output logfile that keeps track of its own size.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <errno.h>
+#include <stdio_ext.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif  // HAVE_ZSTD
+
+#include "logfile.h"
+
+LogFile::LogFile(const QString &pathname,bool truncate)
+{
+  d_pathname=pathname;
+  d_truncate=truncate;
+  d_file=NULL;
+  d_size=0;
+  d_buffered=false;
+  d_batch_size=LOGFILE_DEFAULT_BATCH_SIZE;
+  d_zstd_level=0;
+}
+
+
+LogFile::~LogFile()
+{
+  close();
+}
+
+
+QString LogFile::pathname() const
+{
+  return d_pathname;
+}
+
+
+bool LogFile::isOpen() const
+{
+  return d_file!=NULL;
+}
+
+
+int64_t LogFile::size() const
+{
+  return d_size;
+}
+
+
+bool LogFile::isBuffered() const
+{
+  return d_buffered;
+}
+
+
+bool LogFile::hasPendingData() const
+{
+  return !d_batch.isEmpty();
+}
+
+
+void LogFile::setBuffered(bool state,int batch_size)
+{
+  if(!state) {
+    flush();
+  }
+  d_buffered=state;
+  d_batch_size=batch_size;
+}
+
+
+int LogFile::zstdLevel() const
+{
+  return d_zstd_level;
+}
+
+
+bool LogFile::setZstdLevel(int level)
+{
+  //
+  // Each batch is written as a single, independently decompressible
+  // zstd frame. A level of 0 disables compression.
+  //
+  if((level!=0)&&(!LogFile::zstdSupported())) {
+    return false;
+  }
+  flush();
+  d_zstd_level=level;
+
+  return true;
+}
+
+
+bool LogFile::open(QString *err_msg)
+{
+  if(d_file!=NULL) {
+    return true;
+  }
+  if((d_file=fopen(d_pathname.toUtf8(),d_truncate?"w":"a"))==NULL) {
+    if(err_msg!=NULL) {
+      *err_msg=strerror(errno);
+    }
+    return false;
+  }
+
+  //
+  // Take the starting size from the stream offset, so that we never need
+  // to stat() the file afterward.
+  //
+  d_size=0;
+  if(fseek(d_file,0,SEEK_END)==0) {
+    d_size=ftell(d_file);
+  }
+
+  return true;
+}
+
+
+bool LogFile::reopen(QString *err_msg)
+{
+  close();
+  return open(err_msg);
+}
+
+
+void LogFile::close()
+{
+  flush();
+  if(d_file!=NULL) {
+    fclose(d_file);
+    d_file=NULL;
+  }
+  d_size=0;
+}
+
+
+bool LogFile::write(const QByteArray &data)
+{
+  if(d_buffered) {
+    d_batch+=data;
+    if(d_batch.size()>=d_batch_size) {
+      return flush();
+    }
+    return true;
+  }
+
+  return WriteBatch(data);
+}
+
+
+bool LogFile::flush()
+{
+  bool ret=true;
+
+  if(!d_batch.isEmpty()) {
+    ret=WriteBatch(d_batch);
+    d_batch.clear();
+  }
+
+  return ret;
+}
+
+
+bool LogFile::truncate(int64_t size)
+{
+  d_batch.clear();
+  if(d_file==NULL) {
+    return false;
+  }
+
+  return Rollback(size);
+}
+
+
+bool LogFile::zstdSupported()
+{
+#ifdef HAVE_ZSTD
+  return true;
+#else
+  return false;
+#endif  // HAVE_ZSTD
+}
+
+
+bool LogFile::WriteBatch(const QByteArray &data)
+{
+  const char *buf=data.constData();
+  size_t len=data.size();
+
+  if((d_file==NULL)&&(!open(NULL))) {
+    return false;
+  }
+#ifdef HAVE_ZSTD
+  if(d_zstd_level!=0) {
+    size_t bound=ZSTD_compressBound(data.size());
+    if((size_t)d_zstd_buffer.size()<bound) {
+      d_zstd_buffer.resize(bound);
+    }
+    size_t n=ZSTD_compress(d_zstd_buffer.data(),d_zstd_buffer.size(),
+			   data.constData(),data.size(),d_zstd_level);
+    if(ZSTD_isError(n)) {
+      return false;
+    }
+    buf=d_zstd_buffer.constData();
+    len=n;
+  }
+#endif  // HAVE_ZSTD
+  if((fwrite(buf,1,len,d_file)!=len)||(fflush(d_file)!=0)) {
+    //
+    // Back out whatever part of the batch made it to disk (a torn line
+    // or zstd frame would spoil everything after it) and clear the
+    // error, so that later writes can succeed once space is freed.
+    //
+    Rollback(d_size);
+    return false;
+  }
+  d_size+=len;
+
+  return true;
+}
+
+
+bool LogFile::Rollback(int64_t size)
+{
+  //
+  // Throw away whatever stdio still holds from a failed write, so that
+  // it can't land after the truncation point later.
+  //
+  __fpurge(d_file);
+  clearerr(d_file);
+  if((ftruncate(fileno(d_file),size)!=0)||
+     (fseeko(d_file,size,SEEK_SET)!=0)) {
+    return false;
+  }
+  d_size=size;
+
+  return true;
+}
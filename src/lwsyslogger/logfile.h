@@ -0,0 +1,71 @@
+// logfile.h
+//
+// Output logfile that keeps track of its own size.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef LOGFILE_H
+#define LOGFILE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <QByteArray>
+#include <QString>
+
+//
+// Defaults
+//
+#define LOGFILE_DEFAULT_BATCH_SIZE 65536
+
+class LogFile
+{
+ public:
+  LogFile(const QString &pathname,bool truncate=false);
+  ~LogFile();
+  QString pathname() const;
+  bool isOpen() const;
+  int64_t size() const;
+  bool isBuffered() const;
+  bool hasPendingData() const;
+  void setBuffered(bool state,int batch_size=LOGFILE_DEFAULT_BATCH_SIZE);
+  int zstdLevel() const;
+  bool setZstdLevel(int level);
+  bool open(QString *err_msg);
+  bool reopen(QString *err_msg);
+  void close();
+  bool write(const QByteArray &data);
+  bool flush();
+  bool truncate(int64_t size);
+  static bool zstdSupported();
+
+ private:
+  bool WriteBatch(const QByteArray &data);
+  bool Rollback(int64_t size);
+  QString d_pathname;
+  bool d_truncate;
+  FILE *d_file;
+  int64_t d_size;
+  bool d_buffered;
+  int d_batch_size;
+  QByteArray d_batch;
+  int d_zstd_level;
+  QByteArray d_zstd_buffer;
+};
+
+
+#endif  // LOGFILE_H
@@ -0,0 +1,91 @@
+// logmaintainer.cpp
+//
+// Run log rotation and purging for a processor in a background thread.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include "logmaintainer.h"
+#include "processor.h"
+
+//
+// One thread is shared by all processors, so that rotation and purge
+// scans never compete with each other for the disk.
+//
+static QThread *__logmaintainer_thread=NULL;
+
+LogMaintainer::LogMaintainer(Processor *proc)
+  : QObject()
+{
+  d_processor=proc;
+  d_queue_gauge=Metrics::gauge("processor",proc->id(),
+			       "maintenance_queue_depth",
+			  "Rotation and compression jobs awaiting completion");
+  moveToThread(LogMaintainer::maintenanceThread());
+}
+
+
+QThread *LogMaintainer::maintenanceThread()
+{
+  if(__logmaintainer_thread==NULL) {
+    __logmaintainer_thread=new QThread();
+    __logmaintainer_thread->setObjectName("LogMaintainer");
+    __logmaintainer_thread->start(QThread::LowPriority);
+  }
+  return __logmaintainer_thread;
+}
+
+
+void LogMaintainer::shutdown()
+{
+  if(__logmaintainer_thread!=NULL) {
+    __logmaintainer_thread->quit();
+    __logmaintainer_thread->wait();
+    delete __logmaintainer_thread;
+    __logmaintainer_thread=NULL;
+  }
+}
+
+
+void LogMaintainer::rotate(const QDateTime &now)
+{
+  d_processor->rotateLogs(now);
+  d_queue_gauge->add(-1);
+}
+
+
+void LogMaintainer::compress(const QString &pathname)
+{
+  d_processor->compressLogFile(pathname);
+  d_queue_gauge->add(-1);
+}
+
+
+void LogMaintainer::sync()
+{
+  //
+  // Does nothing; used to wait for previously queued jobs to complete
+  //
+}
+
+
+void LogMaintainer::drain()
+{
+  //
+  // As sync(), but for callers that can't afford to block
+  //
+  emit drained();
+}
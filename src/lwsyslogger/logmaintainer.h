@@ -0,0 +1,55 @@
+// logmaintainer.h
+//
+// Run log rotation and purging for a processor in a background thread.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef LOGMAINTAINER_H
+#define LOGMAINTAINER_H
+
+#include <QDateTime>
+#include <QObject>
+#include <QThread>
+
+#include "metrics.h"
+
+class Processor;
+
+class LogMaintainer : public QObject
+{
+  Q_OBJECT
+ public:
+  LogMaintainer(Processor *proc);
+  static QThread *maintenanceThread();
+  static void shutdown();
+
+ public slots:
+  void rotate(const QDateTime &now);
+  void compress(const QString &pathname);
+  void sync();
+  void drain();
+
+ signals:
+  void drained();
+
+ private:
+  Processor *d_processor;
+  MetricsGauge *d_queue_gauge;
+};
+
+
+#endif  // LOGMAINTAINER_H
@@ -19,39 +19,40 @@
 //
 
 #include <errno.h>
+#include <fcntl.h>
 #include <grp.h>
 #include <pwd.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <sys/signalfd.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
 #include <QCoreApplication>
+#include <QTimer>
 
+#include "childprocess.h"
 #include "cmdswitch.h"
+#include "handoff.h"
+#include "listensockets.h"
+#include "livetail.h"
+#include "logmaintainer.h"
+#include "metricsserver.h"
 #include "lwsyslogger.h"
 #include "proc_factory.h"
+#include "recentserver.h"
 #include "recv_factory.h"
+#include "trigramindexer.h"
 
 //
 // Globals
 //
 bool no_local_syslog=false;
-bool global_exiting=false;
 QMap<QString,Processor *> *syslog_processors=NULL;
 
-void SigHandler(int signo)
-{
-  switch(signo) {
-  case SIGINT:
-  case SIGTERM:
-    global_exiting=true;
-    break;
-  }
-}
-
 bool debug=false;
 void LocalSyslog(Message::Severity severity,const char *fmt,...)
 {
@@ -103,7 +104,12 @@ MainObject::MainObject(QObject *parent)
   QDateTime rotate_logfiles_datetime=QDateTime::currentDateTime();
   bool rotate_logfiles=false;
   bool dry_run=false;
+  d_dry_run=false;
+  bool check_config=false;
   bool dump_config=false;
+  bool takeover=false;
+  int takeover_fd=-1;
+  d_config_cache_filename="";
   QString err_msg;
   QStringList err_msgs;
   
@@ -116,6 +122,14 @@ MainObject::MainObject(QObject *parent)
       config_filename=cmd->value(i);
       cmd->setProcessed(i,true);
     }
+    if(cmd->key(i)=="--check-config") {
+      check_config=true;
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--config-cache") {
+      d_config_cache_filename=cmd->value(i);
+      cmd->setProcessed(i,true);
+    }
     if(cmd->key(i)=="-d") {
       debug=true;
       cmd->setProcessed(i,true);
@@ -132,6 +146,10 @@ MainObject::MainObject(QObject *parent)
       no_local_syslog=true;
       cmd->setProcessed(i,true);
     }
+    if(cmd->key(i)=="--takeover") {
+      takeover=true;
+      cmd->setProcessed(i,true);
+    }
     if(cmd->key(i)=="--rotate-logfiles") {
       rotate_logfiles=true;
       if(!cmd->value(i).isEmpty()) {
@@ -155,28 +173,15 @@ MainObject::MainObject(QObject *parent)
   //
   // Create Configuration Context
   //
-  d_profile=new Profile(true);
-  if(d_profile->load(config_filename,&err_msgs)<=0) {
-    fprintf(stderr,"lwsyslogger: cannot open configuration file \"%s\" [%s]\n",
-	    config_filename.toUtf8().constData(),err_msg.toUtf8().constData());
-    exit(1);
-  }
-  QStringList config_dirs=
-    d_profile->stringValues("Global","Default","IncludeConfig");
-  for(int i=0;i<config_dirs.size();i++) {
-    int num=d_profile->load(config_dirs.at(i),&err_msgs);
-    if(num<0) {
-      fprintf(stderr,
-	 "lwsyslogger: failed attempting to read configuration from \"%s\":\n",
-	      config_dirs.at(i).toUtf8().constData());
-      for(int j=0;j<err_msgs.size();j++) {
-	fprintf(stderr,"    error[%d]: %s\n",1+j,
-		err_msgs.at(i).toUtf8().constData());
-      }
-      exit(1);
+  d_config_filename=config_filename;
+  d_dry_run=dry_run;
+  if((d_profile=LoadProfile(&err_msg,&err_msgs))==NULL) {
+    fprintf(stderr,"lwsyslogger: %s\n",err_msg.toUtf8().constData());
+    for(int i=0;i<err_msgs.size();i++) {
+      fprintf(stderr,"    error[%d]: %s\n",1+i,
+	      err_msgs.at(i).toUtf8().constData());
     }
-    LocalSyslog(Message::SeverityDebug,"loaded %d configurations from \"%s\"",
-		num,config_dirs.at(i).toUtf8().constData());
+    exit(1);
   }
   if(dump_config) {
     for(int i=0;i<err_msgs.size();i++) {
@@ -185,6 +190,32 @@ MainObject::MainObject(QObject *parent)
     printf("%s\n",d_profile->dump().toUtf8().constData());
     exit(0);
   }
+
+  //
+  // Check Processor Configuration
+  //
+  // Processors exit() on bad configuration, so a configuration reload is
+  // vetted by running a fresh instance of ourself with this first.
+  //
+  if(check_config) {
+    QStringList ids=d_profile->sectionIds("Processor");
+    for(int i=0;i<ids.size();i++) {
+      QStringList values=d_profile->stringValues("Processor",ids.at(i),"Type");
+      if(values.isEmpty()||
+	 (Processor::typeFromString(values.last())==Processor::TypeLast)) {
+	fprintf(stderr,"lwsyslogger: invalid processor type for \"%s\"\n",
+		ids.at(i).toUtf8().constData());
+	exit(1);
+      }
+      if(ProcessorFactory(Processor::typeFromString(values.last()),ids.at(i),
+			  d_profile,this)==NULL) {
+	fprintf(stderr,"lwsyslogger: failed to initialize processor \"%s\"\n",
+		ids.at(i).toUtf8().constData());
+	exit(1);
+      }
+    }
+    exit(0);
+  }
   
   //
   // Verify that the LogRoot is configured correctly
@@ -194,6 +225,34 @@ MainObject::MainObject(QObject *parent)
     exit(1);
   }
 
+  //
+  // Signal Handling
+  //
+  // This must be done before any threads are started, so that they
+  // inherit the signal mask and signals are delivered only via the
+  // signalfd(2).
+  //
+  sigset_t sigs;
+  sigemptyset(&sigs);
+  sigaddset(&sigs,SIGINT);
+  sigaddset(&sigs,SIGTERM);
+  sigaddset(&sigs,SIGHUP);
+  sigaddset(&sigs,SIGUSR1);
+  if(sigprocmask(SIG_BLOCK,&sigs,NULL)!=0) {
+    fprintf(stderr,"lwsyslogger: failed to set signal mask [%s]\n",
+	    strerror(errno));
+    exit(1);
+  }
+  if((d_signal_fd=signalfd(-1,&sigs,SFD_NONBLOCK|SFD_CLOEXEC))<0) {
+    fprintf(stderr,"lwsyslogger: failed to create signalfd [%s]\n",
+	    strerror(errno));
+    exit(1);
+  }
+  d_signal_notifier=
+    new QSocketNotifier(d_signal_fd,QSocketNotifier::Read,this);
+  connect(d_signal_notifier,SIGNAL(activated(int)),
+	  this,SLOT(signalData(int)));
+
   //
   // Start Processors
   //
@@ -202,6 +261,161 @@ MainObject::MainObject(QObject *parent)
     exit(1);
   }
 
+  //
+  // Inherited Sockets
+  //
+  if(ListenSockets::loadFromEnvironment(&err_msg)<0) {
+    fprintf(stderr,"lwsyslogger: %s\n",err_msg.toUtf8().constData());
+    exit(1);
+  }
+  QString handoff_path;
+  QStringList handoff_values=
+    d_profile->stringValues("Global","Default","HandoffSocket");
+  if(!handoff_values.isEmpty()) {
+    handoff_path=handoff_values.last();
+  }
+  if(takeover&&(!rotate_logfiles)) {
+    if(handoff_path.isEmpty()) {
+      fprintf(stderr,"lwsyslogger: --takeover requires HandoffSocket\n");
+      exit(1);
+    }
+    if((takeover_fd=HandoffServer::takeover(handoff_path,&err_msg))<0) {
+      LocalSyslog(Message::SeverityWarning,
+		  "unable to take over sockets from \"%s\" [%s], binding anew",
+		  handoff_path.toUtf8().constData(),
+		  err_msg.toUtf8().constData());
+    }
+  }
+
+  //
+  // Live Tail Server
+  //
+  // Started ahead of the receivers, so that they get connected to it.
+  //
+  d_live_tail=NULL;
+  QStringList tail_ids=d_profile->sectionIds("LiveTail");
+  if((!tail_ids.isEmpty())&&(!rotate_logfiles)) {
+    const ProfileSection *sect=d_profile->section("LiveTail",tail_ids.last());
+    QString tail_path;
+    QStringList values=sect->stringValues("SocketPath");
+    if(!values.isEmpty()) {
+      tail_path=values.last();
+    }
+    QHostAddress tail_addr(LIVETAILSERVER_DEFAULT_ADDRESS);
+    QList<QHostAddress> addrs=sect->addressValues("Address");
+    if(!addrs.isEmpty()) {
+      tail_addr=addrs.last();
+    }
+    if(tail_addr.isNull()||(!tail_addr.isLoopback())) {
+      fprintf(stderr,"lwsyslogger: Address in [LiveTail] section must be a "
+	      "loopback address\n");
+      exit(1);
+    }
+    unsigned tail_port=0;
+    QList<int> ports=sect->intValues("Port");
+    if(!ports.isEmpty()) {
+      tail_port=ports.last();
+    }
+    if(tail_port>0xFFFF) {
+      fprintf(stderr,"lwsyslogger: invalid Port in [LiveTail] section\n");
+      exit(1);
+    }
+    if(tail_path.isEmpty()&&(tail_port==0)) {
+      fprintf(stderr,"lwsyslogger: [LiveTail] section requires SocketPath "
+	      "or Port\n");
+      exit(1);
+    }
+    int tail_slots=LIVETAILRING_DEFAULT_SLOTS;
+    QList<int> ivalues=sect->intValues("RingSize");
+    if(!ivalues.isEmpty()) {
+      tail_slots=ivalues.last();
+    }
+    if(tail_slots<1) {
+      fprintf(stderr,"lwsyslogger: invalid RingSize in [LiveTail] section\n");
+      exit(1);
+    }
+    QString tail_template=LIVETAIL_DEFAULT_TEMPLATE;
+    values=sect->stringValues("Template");
+    if(!values.isEmpty()) {
+      tail_template=values.last();
+    }
+    d_live_tail=new LiveTail(tail_ids.last(),tail_slots,tail_template,this);
+    if(!d_live_tail->start(tail_path,tail_addr,tail_port,&err_msg)) {
+      fprintf(stderr,"lwsyslogger: unable to start live tail server [%s]\n",
+	      err_msg.toUtf8().constData());
+      exit(1);
+    }
+    if((!tail_path.isEmpty())&&
+       (chown(tail_path.toUtf8(),d_uid,d_gid)!=0)) {
+      fprintf(stderr,"lwsyslogger: unable to set ownership of \"%s\" [%s]\n",
+	      tail_path.toUtf8().constData(),strerror(errno));
+      exit(1);
+    }
+    LocalSyslog(Message::SeverityDebug,"serving live tail on \"%s\" port %u",
+		tail_path.toUtf8().constData(),tail_port);
+  }
+
+  //
+  // Recent Messages Server
+  //
+  // Likewise started ahead of the receivers.
+  //
+  d_recent_server=NULL;
+  QStringList recent_ids=d_profile->sectionIds("RecentMessages");
+  if((!recent_ids.isEmpty())&&(!rotate_logfiles)) {
+    const ProfileSection *sect=
+      d_profile->section("RecentMessages",recent_ids.last());
+    QString recent_path;
+    QStringList values=sect->stringValues("SocketPath");
+    if(!values.isEmpty()) {
+      recent_path=values.last();
+    }
+    if(recent_path.isEmpty()) {
+      fprintf(stderr,"lwsyslogger: [RecentMessages] section requires "
+	      "SocketPath\n");
+      exit(1);
+    }
+    int recent_lines=RECENTSTORE_DEFAULT_LINES_PER_HOST;
+    QList<int> ivalues=sect->intValues("LinesPerHost");
+    if(!ivalues.isEmpty()) {
+      recent_lines=ivalues.last();
+    }
+    if(recent_lines<1) {
+      fprintf(stderr,"lwsyslogger: invalid LinesPerHost in [RecentMessages] "
+	      "section\n");
+      exit(1);
+    }
+    int64_t recent_memory=RECENTSTORE_DEFAULT_MAX_MEMORY;
+    ivalues=sect->intValues("MaxMemory");
+    if(!ivalues.isEmpty()) {
+      recent_memory=ivalues.last();
+    }
+    if(recent_memory<1) {
+      fprintf(stderr,"lwsyslogger: invalid MaxMemory in [RecentMessages] "
+	      "section\n");
+      exit(1);
+    }
+    QString recent_template=RECENTSERVER_DEFAULT_TEMPLATE;
+    values=sect->stringValues("Template");
+    if(!values.isEmpty()) {
+      recent_template=values.last();
+    }
+    d_recent_server=new RecentServer(recent_ids.last(),recent_lines,
+				     recent_memory,recent_template,this);
+    if(!d_recent_server->listen(recent_path,&err_msg)) {
+      fprintf(stderr,"lwsyslogger: unable to listen at \"%s\" [%s]\n",
+	      recent_path.toUtf8().constData(),err_msg.toUtf8().constData());
+      exit(1);
+    }
+    if(chown(recent_path.toUtf8(),d_uid,d_gid)!=0) {
+      fprintf(stderr,"lwsyslogger: unable to set ownership of \"%s\" [%s]\n",
+	      recent_path.toUtf8().constData(),strerror(errno));
+      exit(1);
+    }
+    LocalSyslog(Message::SeverityDebug,"serving recent messages on \"%s\"",
+		recent_path.toUtf8().constData());
+  }
+
   //
   // Start Receivers
   //
@@ -209,6 +423,64 @@ MainObject::MainObject(QObject *parent)
     fprintf(stderr,"lwsyslogger: %s\n",err_msg.toUtf8().constData());
     exit(1);
   }
+  ListenSockets::closeUnused();
+  if(takeover_fd>=0) {
+    HandoffServer::acknowledge(takeover_fd);
+    LocalSyslog(Message::SeverityNotice,"took over sockets from \"%s\"",
+		handoff_path.toUtf8().constData());
+  }
+
+  //
+  // Handoff Server
+  //
+  d_handoff_server=new HandoffServer(&d_receivers,this);
+  connect(d_handoff_server,SIGNAL(handoffCompleted()),
+	  this,SLOT(handoffData()));
+  if((!handoff_path.isEmpty())&&(!rotate_logfiles)) {
+    if(!d_handoff_server->listen(handoff_path,&err_msg)) {
+      fprintf(stderr,"lwsyslogger: unable to listen at \"%s\" [%s]\n",
+	      handoff_path.toUtf8().constData(),err_msg.toUtf8().constData());
+      exit(1);
+    }
+  }
+
+  //
+  // Metrics Server
+  //
+  d_metrics_server=NULL;
+  QStringList metrics_ids=d_profile->sectionIds("Metrics");
+  if((!metrics_ids.isEmpty())&&(!rotate_logfiles)) {
+    const ProfileSection *sect=
+      d_profile->section("Metrics",metrics_ids.last());
+    QHostAddress metrics_addr(METRICSSERVER_DEFAULT_ADDRESS);
+    QList<QHostAddress> addrs=sect->addressValues("Address");
+    if(!addrs.isEmpty()) {
+      metrics_addr=addrs.last();
+    }
+    if(metrics_addr.isNull()) {
+      fprintf(stderr,"lwsyslogger: invalid Address in [Metrics] section\n");
+      exit(1);
+    }
+    unsigned metrics_port=METRICSSERVER_DEFAULT_PORT;
+    QList<int> ports=sect->intValues("Port");
+    if(!ports.isEmpty()) {
+      metrics_port=ports.last();
+    }
+    if((metrics_port<1)||(metrics_port>0xFFFF)) {
+      fprintf(stderr,"lwsyslogger: invalid Port in [Metrics] section\n");
+      exit(1);
+    }
+    d_metrics_server=new MetricsServer();
+    if(!d_metrics_server->start(metrics_addr,metrics_port,&err_msg)) {
+      fprintf(stderr,
+	      "lwsyslogger: unable to start metrics server on %s:%u [%s]\n",
+	      metrics_addr.toString().toUtf8().constData(),metrics_port,
+	      err_msg.toUtf8().constData());
+      exit(1);
+    }
+    LocalSyslog(Message::SeverityDebug,"serving metrics on %s:%u",
+		metrics_addr.toString().toUtf8().constData(),metrics_port);
+  }
 
   //
   // Drop Root Permissions
@@ -224,16 +496,6 @@ MainObject::MainObject(QObject *parent)
     exit(1);
   }
 
-  //
-  // Exit Timer
-  //
-  d_exit_timer=new QTimer(this);
-  d_exit_timer->setSingleShot(false);
-  connect(d_exit_timer,SIGNAL(timeout()),this,SLOT(exitData()));
-  d_exit_timer->start(500);
-  signal(SIGINT,SigHandler);
-  signal(SIGTERM,SigHandler);
-
   LocalSyslog(Message::SeverityNotice,"lwsyslogger v%s started",VERSION);
 
   //
@@ -242,18 +504,480 @@ MainObject::MainObject(QObject *parent)
   if(rotate_logfiles) {
     for(QMap<QString,Processor *>::const_iterator it=d_processors.begin();
 	it!=d_processors.end();it++) {
-      it.value()->rotateLogs(rotate_logfiles_datetime);
+      it.value()->forceLogRotation(rotate_logfiles_datetime);
     }
-    global_exiting=true;
+    QTimer::singleShot(0,this,SLOT(shutdownData()));
   }
 }
 
 
-void MainObject::exitData()
+void MainObject::signalData(int fd)
 {
-  if(global_exiting) {
-    LocalSyslog(Message::SeverityNotice,"lwsyslogger v%s exiting",VERSION);
-    exit(0);
+  struct signalfd_siginfo info;
+
+  while(read(fd,&info,sizeof(info))==sizeof(info)) {
+    switch(info.ssi_signo) {
+    case SIGINT:
+    case SIGTERM:
+      Shutdown();
+      break;
+
+    case SIGHUP:
+      ReloadConfiguration();
+      break;
+
+    case SIGUSR1:
+      DumpStats();
+      break;
+    }
+  }
+}
+
+
+void MainObject::handoffData()
+{
+  LocalSyslog(Message::SeverityNotice,"sockets handed off to new instance");
+  Shutdown();
+}
+
+
+void MainObject::shutdownData()
+{
+  Shutdown();
+}
+
+
+void MainObject::processorRetiredData()
+{
+  Processor *proc=qobject_cast<Processor *>(sender());
+
+  if(proc!=NULL) {
+    d_retiring_processors.removeAll(proc);
+    LocalSyslog(Message::SeverityDebug,"stopped processor \"%s\"",
+		proc->id().toUtf8().constData());
+    delete proc;
+    PurgeProfiles();
+  }
+}
+
+
+void MainObject::DumpStats() const
+{
+  QStringList stats=Metrics::dump();
+
+  for(int i=0;i<stats.size();i++) {
+    LocalSyslog(Message::SeverityInfo,"stats: %s",
+		stats.at(i).toUtf8().constData());
+  }
+}
+
+
+void MainObject::Shutdown()
+{
+  LocalSyslog(Message::SeverityNotice,"lwsyslogger v%s exiting",VERSION);
+
+  //
+  // Stop accepting new messages
+  //
+  for(QMap<QString,Receiver *>::const_iterator it=d_receivers.begin();
+      it!=d_receivers.end();it++) {
+    delete it.value();
+  }
+  d_receivers.clear();
+
+  //
+  // Drain the processors. Stopping a processor writes out any pending
+  // deduplication count and waits for outstanding rotation and
+  // compression jobs; deleting it flushes any buffered output.
+  //
+  for(QMap<QString,Processor *>::const_iterator it=d_processors.begin();
+      it!=d_processors.end();it++) {
+    it.value()->stop();
+  }
+  for(int i=0;i<d_retiring_processors.size();i++) {
+    d_retiring_processors.at(i)->stop();
+    delete d_retiring_processors.at(i);
+  }
+  d_retiring_processors.clear();
+  syslog_processors=NULL;
+  for(QMap<QString,Processor *>::const_iterator it=d_processors.begin();
+      it!=d_processors.end();it++) {
+    delete it.value();
+  }
+  d_processors.clear();
+  LogMaintainer::shutdown();
+  TrigramIndexer::shutdown();
+  if(d_metrics_server!=NULL) {
+    d_metrics_server->stop();
+  }
+  if(d_live_tail!=NULL) {
+    d_live_tail->stop();
+  }
+  if(d_recent_server!=NULL) {
+    d_recent_server->stop();
+  }
+
+  exit(0);
+}
+
+
+void MainObject::ReloadConfiguration()
+{
+  QString err_msg;
+  QStringList added_ids;
+  QStringList changed_ids;
+  QStringList removed_ids;
+
+  LocalSyslog(Message::SeverityNotice,"reloading configuration");
+
+  Profile *profile=LoadProfile(&err_msg,NULL);
+  if(profile==NULL) {
+    LocalSyslog(Message::SeverityWarning,"configuration reload failed [%s]",
+		err_msg.toUtf8().constData());
+    return;
+  }
+  bool restart_needed=(profile->sectionValues("Global","Default")!=
+		       d_profile->sectionValues("Global","Default"));
+  QStringList server_sections;
+  server_sections.push_back("Metrics");
+  server_sections.push_back("LiveTail");
+  server_sections.push_back("RecentMessages");
+  for(int i=0;i<server_sections.size();i++) {
+    QStringList server_ids=profile->sectionIds(server_sections.at(i));
+    if(server_ids!=d_profile->sectionIds(server_sections.at(i))) {
+      restart_needed=true;
+    }
+    for(int j=0;j<server_ids.size();j++) {
+      if(profile->sectionValues(server_sections.at(i),server_ids.at(j))!=
+	 d_profile->sectionValues(server_sections.at(i),server_ids.at(j))) {
+	restart_needed=true;
+      }
+    }
+  }
+  if(restart_needed) {
+    LocalSyslog(Message::SeverityWarning,
+		"configuration reload failed, as changes to the Global, Metrics, "
+		"LiveTail or RecentMessages sections require a restart");
+    delete profile;
+    return;
+  }
+
+  //
+  // Find Processor Changes
+  //
+  QStringList ids=profile->sectionIds("Processor");
+  for(int i=0;i<ids.size();i++) {
+    if(!d_processors.contains(ids.at(i))) {
+      added_ids.push_back(ids.at(i));
+    }
+    else {
+      if(profile->sectionValues("Processor",ids.at(i))!=
+	 d_profile->sectionValues("Processor",ids.at(i))) {
+	changed_ids.push_back(ids.at(i));
+      }
+    }
+  }
+  for(QMap<QString,Processor *>::const_iterator it=d_processors.begin();
+      it!=d_processors.end();it++) {
+    if(!ids.contains(it.key())) {
+      removed_ids.push_back(it.key());
+    }
+  }
+  if((!(added_ids+changed_ids).isEmpty())&&(!ValidateProcessors(&err_msg))) {
+    LocalSyslog(Message::SeverityWarning,"configuration reload failed [%s]",
+		err_msg.toUtf8().constData());
+    delete profile;
+    return;
+  }
+
+  //
+  // Find Receiver Changes
+  //
+  // The 'Processor=' values only affect how the receiver is wired up, so
+  // a receiver keeps its socket if nothing else has changed. Compare
+  // against the profile the receiver was actually started from, as a
+  // failed restart leaves it running on an older one.
+  //
+  QStringList recv_ids=profile->sectionIds("Receiver");
+  QStringList recv_changed_ids;
+  QStringList recv_removed_ids;
+  for(int i=0;i<recv_ids.size();i++) {
+    Receiver *recv=d_receivers.value(recv_ids.at(i));
+    QMap<QString,QStringList> new_values=
+      profile->sectionValues("Receiver",recv_ids.at(i));
+    QMap<QString,QStringList> old_values;
+    if(recv!=NULL) {
+      old_values=recv->profile()->sectionValues("Receiver",recv_ids.at(i));
+    }
+    new_values.remove("Processor");
+    old_values.remove("Processor");
+    if((recv==NULL)||(new_values!=old_values)) {
+      recv_changed_ids.push_back(recv_ids.at(i));
+    }
+  }
+  for(QMap<QString,Receiver *>::const_iterator it=d_receivers.begin();
+      it!=d_receivers.end();it++) {
+    if(!recv_ids.contains(it.key())) {
+      recv_removed_ids.push_back(it.key());
+    }
+  }
+
+  //
+  // Start Replacement Processors
+  //
+  // This is done before anything is torn down, so that a failure leaves
+  // the running configuration untouched.
+  //
+  QMap<QString,Processor *> new_processors;
+  for(int i=0;i<(added_ids.size()+changed_ids.size());i++) {
+    QString id=(i<added_ids.size())?added_ids.at(i):
+      changed_ids.at(i-added_ids.size());
+    Processor *proc=StartProcessor(id,profile,&err_msg);
+    if(proc==NULL) {
+      for(QMap<QString,Processor *>::const_iterator it=new_processors.begin();
+	  it!=new_processors.end();it++) {
+	delete it.value();
+      }
+      LocalSyslog(Message::SeverityWarning,"configuration reload failed [%s]",
+		  err_msg.toUtf8().constData());
+      delete profile;
+      return;
+    }
+    new_processors[id]=proc;
+  }
+
+  //
+  // Swap In Processors
+  //
+  // The processors being replaced are retired once the receivers have
+  // been rewired, below.
+  //
+  QList<Processor *> old_processors;
+  for(int i=0;i<(removed_ids.size()+changed_ids.size());i++) {
+    QString id=(i<removed_ids.size())?removed_ids.at(i):
+      changed_ids.at(i-removed_ids.size());
+    old_processors.push_back(d_processors.take(id));
+  }
+  for(QMap<QString,Processor *>::const_iterator it=new_processors.begin();
+      it!=new_processors.end();it++) {
+    d_processors[it.key()]=it.value();
+    LocalSyslog(Message::SeverityDebug,"started processor \"%s\"",
+		it.key().toUtf8().constData());
+  }
+
+  //
+  // Apply Receiver Changes
+  //
+  // Privileges are gone by now, so a replacement receiver may well be
+  // unable to bind its port again. Offer it a duplicate of the old
+  // receiver's socket (taken if the port is unchanged) and keep the old
+  // receiver running if it still fails to start.
+  //
+  for(int i=0;i<recv_removed_ids.size();i++) {
+    Receiver *recv=d_receivers.take(recv_removed_ids.at(i));
+    delete recv;
+    LocalSyslog(Message::SeverityDebug,"stopped receiver \"%s\"",
+		recv_removed_ids.at(i).toUtf8().constData());
+  }
+  int recv_restarted=0;
+  for(int i=0;i<recv_changed_ids.size();i++) {
+    QString id=recv_changed_ids.at(i);
+    Receiver *old_recv=d_receivers.value(id);
+    QList<int> fds;
+    if(old_recv!=NULL) {
+      QList<int> old_fds=old_recv->socketDescriptors();
+      for(int j=0;j<old_fds.size();j++) {
+	int fd=fcntl(old_fds.at(j),F_DUPFD_CLOEXEC,0);
+	if(fd>=0) {
+	  ListenSockets::add(fd);
+	  fds.push_back(fd);
+	}
+      }
+    }
+    Receiver *recv=StartReceiver(id,profile,&err_msg);
+    for(int j=0;j<fds.size();j++) {
+      ListenSockets::discard(fds.at(j));  // If not taken
+    }
+    if(recv==NULL) {
+      if(old_recv!=NULL) {
+	LocalSyslog(Message::SeverityWarning,
+		    "keeping previous configuration of receiver \"%s\" [%s]",
+		    id.toUtf8().constData(),err_msg.toUtf8().constData());
+      }
+      else {
+	LocalSyslog(Message::SeverityWarning,"%s",
+		    err_msg.toUtf8().constData());
+      }
+      continue;
+    }
+    if(old_recv!=NULL) {
+      delete old_recv;
+      LocalSyslog(Message::SeverityDebug,"stopped receiver \"%s\"",
+		  id.toUtf8().constData());
+    }
+    d_receivers[id]=recv;
+    recv_restarted++;
+    LocalSyslog(Message::SeverityDebug,"started receiver \"%s\"",
+		id.toUtf8().constData());
+  }
+  for(QMap<QString,Receiver *>::const_iterator it=d_receivers.begin();
+      it!=d_receivers.end();it++) {
+    disconnect(it.value(),SIGNAL(messageReceived(Message *,const QHostAddress &)),
+	       NULL,NULL);
+    if(!ConnectReceiver(it.value(),profile,&err_msg)) {
+      LocalSyslog(Message::SeverityWarning,"%s",err_msg.toUtf8().constData());
+    }
+  }
+
+  //
+  // Retire Replaced Processors
+  //
+  for(int i=0;i<old_processors.size();i++) {
+    RetireProcessor(old_processors.at(i));
+  }
+
+  //
+  // Processors and receivers that were left alone still refer to the
+  // previous profile, so keep it around until they are gone.
+  //
+  d_old_profiles.push_back(d_profile);
+  d_profile=profile;
+  PurgeProfiles();
+
+  LocalSyslog(Message::SeverityNotice,
+	      "configuration reloaded: %d processor(s) and %d receiver(s) restarted",
+	      removed_ids.size()+added_ids.size()+changed_ids.size(),
+	      recv_removed_ids.size()+recv_restarted);
+}
+
+
+Profile *MainObject::LoadProfile(QString *err_msg,QStringList *msgs) const
+{
+  QStringList err_msgs;
+  QString err_msg2;
+  Profile *profile=new Profile(true);
+
+  //
+  // Try the cache first
+  //
+  if(!d_config_cache_filename.isEmpty()) {
+    if(profile->loadCache(d_config_cache_filename,d_config_filename,
+			  &err_msg2)) {
+      LocalSyslog(Message::SeverityDebug,
+		  "loaded configuration from cache \"%s\"",
+		  d_config_cache_filename.toUtf8().constData());
+      return profile;
+    }
+    LocalSyslog(Message::SeverityDebug,
+		"not using configuration cache \"%s\" [%s]",
+		d_config_cache_filename.toUtf8().constData(),
+		err_msg2.toUtf8().constData());
+  }
+
+  if(profile->load(d_config_filename,&err_msgs)<=0) {
+    *err_msg=QString::asprintf("cannot open configuration file \"%s\"",
+			       d_config_filename.toUtf8().constData());
+    delete profile;
+    return NULL;
+  }
+  QStringList config_dirs=
+    profile->stringValues("Global","Default","IncludeConfig");
+  for(int i=0;i<config_dirs.size();i++) {
+    int num=profile->load(config_dirs.at(i),&err_msgs);
+    if(num<0) {
+      *err_msg=QString::asprintf(
+	     "failed attempting to read configuration from \"%s\"",
+	     config_dirs.at(i).toUtf8().constData());
+      if(msgs!=NULL) {
+	*msgs=err_msgs;
+      }
+      delete profile;
+      return NULL;
+    }
+    LocalSyslog(Message::SeverityDebug,"loaded %d configurations from \"%s\"",
+		num,config_dirs.at(i).toUtf8().constData());
+  }
+  if(msgs!=NULL) {
+    *msgs=err_msgs;
+  }
+
+  if(!d_config_cache_filename.isEmpty()) {
+    if(!profile->saveCache(d_config_cache_filename,d_config_filename,
+			   &err_msg2)) {
+      LocalSyslog(Message::SeverityWarning,
+		  "failed to write configuration cache \"%s\" [%s]",
+		  d_config_cache_filename.toUtf8().constData(),
+		  err_msg2.toUtf8().constData());
+    }
+  }
+
+  return profile;
+}
+
+
+bool MainObject::ValidateProcessors(QString *err_msg) const
+{
+  //
+  // Done in a fresh instance rather than a fork(), as other threads may
+  // be holding locks at the time.
+  //
+  QStringList args;
+  args.push_back("--check-config");
+  args.push_back("--no-local-syslog");
+  args.push_back("--config="+d_config_filename);
+  ChildProcess *proc=new ChildProcess();
+  proc->start(QCoreApplication::applicationFilePath(),args);
+  if(!proc->waitForFinished(CHECK_CONFIG_TIMEOUT)) {
+    *err_msg=QString::asprintf("unable to check configuration [%s]",
+			       proc->errorString().toUtf8().constData());
+    proc->kill();
+    proc->waitForFinished();
+    delete proc;
+    return false;
+  }
+  if((proc->exitStatus()!=QProcess::NormalExit)||(proc->exitCode()!=0)) {
+    *err_msg=QString::fromUtf8(proc->readAllStandardError()).trimmed();
+    if(err_msg->isEmpty()) {
+      *err_msg="invalid processor configuration";
+    }
+    delete proc;
+    return false;
+  }
+  delete proc;
+
+  return true;
+}
+
+
+void MainObject::RetireProcessor(Processor *proc)
+{
+  d_retiring_processors.push_back(proc);
+  connect(proc,SIGNAL(retired()),this,SLOT(processorRetiredData()),
+	  Qt::QueuedConnection);
+  proc->retire();
+}
+
+
+void MainObject::PurgeProfiles()
+{
+  for(int i=d_old_profiles.size()-1;i>=0;i--) {
+    Profile *p=d_old_profiles.at(i);
+    bool used=false;
+    for(QMap<QString,Processor *>::const_iterator it=d_processors.begin();
+	it!=d_processors.end();it++) {
+      used=used||(it.value()->config()==p);
+    }
+    for(int j=0;j<d_retiring_processors.size();j++) {
+      used=used||(d_retiring_processors.at(j)->config()==p);
+    }
+    for(QMap<QString,Receiver *>::const_iterator it=d_receivers.begin();
+	it!=d_receivers.end();it++) {
+      used=used||(it.value()->profile()==p);
+    }
+    if(!used) {
+      delete p;
+      d_old_profiles.removeAt(i);
+    }
   }
 }
 
@@ -340,37 +1064,10 @@ bool MainObject::ConfigureLogRoot(QString *err_msg)
 
 bool MainObject::StartProcessors(QString *err_msg,bool dry_run)
 {
-  QString err_msg2;
   Processor *proc=NULL;
   QStringList ids=d_profile->sectionIds("Processor");
   for(int i=0;i<ids.size();i++) {
-    QStringList values=d_profile->stringValues("Processor",ids.at(i),"Type");
-    if(values.isEmpty()) {
-      *err_msg=QString::asprintf("%s: no processor type specified",
-				 ids.at(i).toUtf8().constData());
-      return false;
-    }
-    QString procstr=
-      d_profile->stringValues("Processor",ids.at(i),"Type").last();
-    Processor::Type type=Processor::typeFromString(values.last());
-    if(type==Processor::TypeLast) {
-      *err_msg=QString::asprintf("%s: unknown processor type \"%s\"",
-				 ids.at(i).toUtf8().constData(),
-				 values.last().toUtf8().constData());
-      return false;
-    }
-    if((proc=ProcessorFactory(type,ids.at(i),d_profile,this))==NULL) {
-      *err_msg=QString::asprintf(
-	      "%s: failed to initialize processor type \"%s\"",
-	      ids.at(i).toUtf8().constData(),
-	      Processor::typeString(type).toUtf8().constData());
-      return false;
-    }
-    proc->setDryRun(dry_run);
-    if(!proc->start(&err_msg2)) {
-      *err_msg=QString::asprintf("%s: failed to start processor [%s]",
-				 ids.at(i).toUtf8().constData(),
-				 err_msg2.toUtf8().constData());
+    if((proc=StartProcessor(ids.at(i),d_profile,err_msg))==NULL) {
       return false;
     }
     d_processors[ids.at(i)]=proc;
@@ -380,57 +1077,126 @@ bool MainObject::StartProcessors(QString *err_msg,bool dry_run)
 }
 
 
+Processor *MainObject::StartProcessor(const QString &id,Profile *p,
+				      QString *err_msg)
+{
+  QString err_msg2;
+  Processor *proc=NULL;
+
+  QStringList values=p->stringValues("Processor",id,"Type");
+  if(values.isEmpty()) {
+    *err_msg=QString::asprintf("%s: no processor type specified",
+			       id.toUtf8().constData());
+    return NULL;
+  }
+  Processor::Type type=Processor::typeFromString(values.last());
+  if(type==Processor::TypeLast) {
+    *err_msg=QString::asprintf("%s: unknown processor type \"%s\"",
+			       id.toUtf8().constData(),
+			       values.last().toUtf8().constData());
+    return NULL;
+  }
+  if((proc=ProcessorFactory(type,id,p,this))==NULL) {
+    *err_msg=QString::asprintf(
+	      "%s: failed to initialize processor type \"%s\"",
+	      id.toUtf8().constData(),
+	      Processor::typeString(type).toUtf8().constData());
+    return NULL;
+  }
+  proc->setDryRun(d_dry_run);
+  if(!proc->start(&err_msg2)) {
+    *err_msg=QString::asprintf("%s: failed to start processor [%s]",
+			       id.toUtf8().constData(),
+			       err_msg2.toUtf8().constData());
+    delete proc;
+    return NULL;
+  }
+
+  return proc;
+}
+
+
 bool MainObject::StartReceivers(QString *err_msg)
 {
-  QStringList values;
   Receiver *recv=NULL;
   QStringList ids=d_profile->sectionIds("Receiver");
 
   for(int i=0;i<ids.size();i++) {
-    values=d_profile->stringValues("Receiver",ids.at(i),"Type");
-    if(values.isEmpty()) {
-      *err_msg=QString::asprintf("%s: no receiver type specified",
-				 ids.at(i).toUtf8().constData());
+    if((recv=StartReceiver(ids.at(i),d_profile,err_msg))==NULL) {
       return false;
     }
-    Receiver::Type type=Receiver::typeFromString(values.last());
-    if(type==Receiver::TypeLast) {
-      *err_msg=QString::asprintf("%s: unknown receiver type \"%s\"",
-				 ids.at(i).toUtf8().constData(),
-				 values.last().toUtf8().constData());
+    d_receivers[ids.at(i)]=recv;
+    if(!ConnectReceiver(recv,d_profile,err_msg)) {
       return false;
     }
-    if((recv=ReceiverFactory(type,ids.at(i),d_profile,this))==NULL) {
-      *err_msg=QString::asprintf(
+  }
+  syslog_processors=&d_processors;
+
+  return true;
+}
+
+
+Receiver *MainObject::StartReceiver(const QString &id,Profile *p,
+				    QString *err_msg)
+{
+  Receiver *recv=NULL;
+
+  QStringList values=p->stringValues("Receiver",id,"Type");
+  if(values.isEmpty()) {
+    *err_msg=QString::asprintf("%s: no receiver type specified",
+			       id.toUtf8().constData());
+    return NULL;
+  }
+  Receiver::Type type=Receiver::typeFromString(values.last());
+  if(type==Receiver::TypeLast) {
+    *err_msg=QString::asprintf("%s: unknown receiver type \"%s\"",
+			       id.toUtf8().constData(),
+			       values.last().toUtf8().constData());
+    return NULL;
+  }
+  if((recv=ReceiverFactory(type,id,p,this))==NULL) {
+    *err_msg=QString::asprintf(
 	   "%s: failed to initialize receiver type \"%s\"",
-	   ids.at(i).toUtf8().constData(),
+	   id.toUtf8().constData(),
 	   Receiver::typeString(type).toUtf8().constData());
-      return false;
-    }
-    QString err_msg2;
-    if(!recv->start(&err_msg2)) {
-      *err_msg=QString::asprintf("%s: failed to start receiver [%s]",
-				 ids.at(i).toUtf8().constData(),
-				 err_msg2.toUtf8().constData());
-      return false;
-    }
-    d_receivers[ids.at(i)]=recv;
-    QStringList processors=
-      d_profile->stringValues("Receiver",ids.at(i),"Processor");
-    for(int j=0;j<processors.size();j++) {
-      Processor *proc=d_processors.value(processors.at(j));
-      if(proc==NULL) {
-	*err_msg=QString::asprintf(
+    return NULL;
+  }
+  QString err_msg2;
+  if(!recv->start(&err_msg2)) {
+    *err_msg=QString::asprintf("%s: failed to start receiver [%s]",
+			       id.toUtf8().constData(),
+			       err_msg2.toUtf8().constData());
+    delete recv;
+    return NULL;
+  }
+
+  return recv;
+}
+
+
+bool MainObject::ConnectReceiver(Receiver *recv,Profile *p,QString *err_msg)
+{
+  QStringList processors=p->stringValues("Receiver",recv->id(),"Processor");
+  for(int j=0;j<processors.size();j++) {
+    Processor *proc=d_processors.value(processors.at(j));
+    if(proc==NULL) {
+      *err_msg=QString::asprintf(
 	     "unknown processor \"%s\" specified in receiver \"%s\"",
 	     processors.at(j).toUtf8().constData(),
-	     ids.at(i).toUtf8().constData());
-	return false;
-      }
-      connect(recv,SIGNAL(messageReceived(Message *,const QHostAddress &)),
-	      proc,SLOT(process(Message *,const QHostAddress &)));
+	     recv->id().toUtf8().constData());
+      return false;
     }
+    connect(recv,SIGNAL(messageReceived(Message *,const QHostAddress &)),
+	    proc,SLOT(process(Message *,const QHostAddress &)));
+  }
+  if(d_live_tail!=NULL) {
+    connect(recv,SIGNAL(messageReceived(Message *,const QHostAddress &)),
+	    d_live_tail,SLOT(process(Message *,const QHostAddress &)));
+  }
+  if(d_recent_server!=NULL) {
+    connect(recv,SIGNAL(messageReceived(Message *,const QHostAddress &)),
+	    d_recent_server,SLOT(process(Message *,const QHostAddress &)));
   }
-  syslog_processors=&d_processors;
 
   return true;
 }
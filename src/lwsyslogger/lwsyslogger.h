@@ -24,10 +24,14 @@
 #include <QDir>
 #include <QMap>
 #include <QObject>
-#include <QTimer>
+#include <QSocketNotifier>
 
+#include "handoff.h"
+#include "livetail.h"
 #include "local_syslog.h"
+#include "metricsserver.h"
 #include "processor.h"
+#include "recentserver.h"
 #include "profile.h"
 #include "receiver.h"
 
@@ -38,11 +42,12 @@
 #define DEFAULT_LOGROOT "/var/log/lwsyslogger"
 #define DEFAULT_SERVICE_USER "lwsyslogger"
 #define DEFAULT_SERVICE_GROUP "lwsyslogger"
+#define CHECK_CONFIG_TIMEOUT 30000
 
 //
 // Global RIPCD Definitions
 //
-#define LWSYSLOGGER_USAGE "[--config=<filename>] [--rotate-logfiles[=YYYY-MM-DD]] [--dry-run] [--no-local-syslog] [-d]\n\n"
+#define LWSYSLOGGER_USAGE "[--config=<filename>] [--config-cache=<filename>] [--rotate-logfiles[=YYYY-MM-DD]] [--check-config] [--dry-run] [--no-local-syslog] [--takeover] [-d]\n\n"
 
 class MainObject : public QObject
 {
@@ -51,21 +56,44 @@ class MainObject : public QObject
   MainObject(QObject *parent=0);
 
  private slots:
-  void exitData();
+  void signalData(int fd);
+  void handoffData();
+  void shutdownData();
+  void processorRetiredData();
    
  private:
+  void DumpStats() const;
+  void Shutdown();
+  void ReloadConfiguration();
+  Profile *LoadProfile(QString *err_msg,QStringList *msgs) const;
+  bool ValidateProcessors(QString *err_msg) const;
+  void RetireProcessor(Processor *proc);
+  void PurgeProfiles();
   bool ConfigureLogRoot(QString *err_msg);
   bool StartProcessors(QString *err_msg,bool dry_run);
+  Processor *StartProcessor(const QString &id,Profile *p,QString *err_msg);
   bool StartReceivers(QString *err_msg);
+  Receiver *StartReceiver(const QString &id,Profile *p,QString *err_msg);
+  bool ConnectReceiver(Receiver *recv,Profile *p,QString *err_msg);
   QMap<QString,Receiver *> d_receivers;
   QMap<QString,Processor *> d_processors;
+  QList<Processor *> d_retiring_processors;
   QDir *d_logroot_dir;
   uid_t d_uid;
   gid_t d_gid;
   QString d_user_name;
   QString d_group_name;
   Profile *d_profile;
-  QTimer *d_exit_timer;
+  QList<Profile *> d_old_profiles;
+  QString d_config_filename;
+  QString d_config_cache_filename;
+  bool d_dry_run;
+  int d_signal_fd;
+  QSocketNotifier *d_signal_notifier;
+  HandoffServer *d_handoff_server;
+  MetricsServer *d_metrics_server;
+  LiveTail *d_live_tail;
+  RecentServer *d_recent_server;
   friend void LocalSyslog(int prio,const QString &msg);
 };
 
@@ -134,6 +134,21 @@ void Message::setTimestamp(const QDateTime &dt)
 }
 
 
+int64_t Message::receiveTime() const
+{
+  return d_receive_time;
+}
+
+
+void Message::setReceiveTime(int64_t nsec)
+{
+  //
+  // Nanoseconds since the epoch, as reported by SO_TIMESTAMPNS
+  //
+  d_receive_time=nsec;
+}
+
+
 QString Message::hostName() const
 {
   return d_host_name;
@@ -219,6 +234,7 @@ void Message::clear()
   d_facility=Message::FacilityLast;
   d_severity=Message::SeverityLast;;
   d_timestamp=QDateTime();
+  d_receive_time=0;
   d_host_name=QString();
   d_app_name=QString();
   d_proc_id=QString();
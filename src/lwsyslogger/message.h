@@ -56,6 +56,8 @@ class Message
   Severity severity() const;
   QDateTime timestamp() const;
   void setTimestamp(const QDateTime &dt);
+  int64_t receiveTime() const;
+  void setReceiveTime(int64_t nsec);
   QString hostName() const;
   QString appName() const;
   QString procId() const;
@@ -82,6 +84,7 @@ class Message
   Facility d_facility;
   Severity d_severity;
   QDateTime d_timestamp;
+  int64_t d_receive_time;
   QString d_host_name;
   QString d_app_name;
   QString d_proc_id;
@@ -0,0 +1,399 @@
+// metrics.cpp
+//
+// Low-overhead counters and histograms for receivers and processors.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <new>
+
+#include "metrics.h"
+
+//
+// Registered objects are never deleted, so the counts for a receiver or
+// processor survive it being restarted by a configuration reload.
+//
+static QMutex __metrics_mutex;
+static QList<MetricsObject *> __metrics_objects;
+static std::atomic<int> __metrics_next_shard(0);
+
+static const uint64_t __metrics_bucket_bounds[METRICS_HISTOGRAM_BUCKETS]=
+  {10,20,50,100,200,500,1000,2000,5000,10000,20000,50000,100000,200000,
+   500000,1000000,2000000,5000000,10000000,UINT64_MAX};
+
+MetricsObject::MetricsObject(const QString &type,const QString &id,
+			     const QString &name,const QString &help)
+{
+  d_type=type;
+  d_id=id;
+  d_name=name;
+  d_help=help;
+}
+
+
+MetricsObject::~MetricsObject()
+{
+}
+
+
+QString MetricsObject::type() const
+{
+  return d_type;
+}
+
+
+QString MetricsObject::id() const
+{
+  return d_id;
+}
+
+
+QString MetricsObject::name() const
+{
+  return d_name;
+}
+
+
+QString MetricsObject::help() const
+{
+  return d_help;
+}
+
+
+void *MetricsObject::operator new(size_t size)
+{
+  //
+  // Plain new does not honor alignas() under C++11
+  //
+  void *ptr=NULL;
+
+  if(posix_memalign(&ptr,METRICS_CACHE_LINE,size)!=0) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+
+void MetricsObject::operator delete(void *ptr)
+{
+  free(ptr);
+}
+
+
+int MetricsObject::shard()
+{
+  static thread_local int shard=-1;
+
+  if(shard<0) {
+    shard=__metrics_next_shard.fetch_add(1)%METRICS_SHARDS;
+  }
+  return shard;
+}
+
+
+MetricsCounter::MetricsCounter(const QString &type,const QString &id,
+			       const QString &name,const QString &help)
+  : MetricsObject(type,id,name,help)
+{
+  for(int i=0;i<METRICS_SHARDS;i++) {
+    d_cells[i].value.store(0);
+  }
+}
+
+
+MetricsObject::Kind MetricsCounter::kind() const
+{
+  return MetricsObject::KindCounter;
+}
+
+
+uint64_t MetricsCounter::value() const
+{
+  uint64_t ret=0;
+
+  for(int i=0;i<METRICS_SHARDS;i++) {
+    ret+=d_cells[i].value.load(std::memory_order_relaxed);
+  }
+
+  return ret;
+}
+
+
+MetricsGauge::MetricsGauge(const QString &type,const QString &id,
+			   const QString &name,const QString &help)
+  : MetricsObject(type,id,name,help)
+{
+  d_value.store(0);
+}
+
+
+MetricsObject::Kind MetricsGauge::kind() const
+{
+  return MetricsObject::KindGauge;
+}
+
+
+int64_t MetricsGauge::value() const
+{
+  return d_value.load(std::memory_order_relaxed);
+}
+
+
+MetricsHistogram::MetricsHistogram(const QString &type,const QString &id,
+				   const QString &name,const QString &help)
+  : MetricsObject(type,id,name,help)
+{
+  for(int i=0;i<METRICS_SHARDS;i++) {
+    for(int j=0;j<METRICS_HISTOGRAM_BUCKETS;j++) {
+      d_cells[i].buckets[j].store(0);
+    }
+    d_cells[i].sum.store(0);
+  }
+}
+
+
+MetricsObject::Kind MetricsHistogram::kind() const
+{
+  return MetricsObject::KindHistogram;
+}
+
+
+QList<uint64_t> MetricsHistogram::bucketCounts() const
+{
+  QList<uint64_t> ret;
+
+  for(int j=0;j<METRICS_HISTOGRAM_BUCKETS;j++) {
+    uint64_t count=0;
+    for(int i=0;i<METRICS_SHARDS;i++) {
+      count+=d_cells[i].buckets[j].load(std::memory_order_relaxed);
+    }
+    ret.push_back(count);
+  }
+
+  return ret;
+}
+
+
+uint64_t MetricsHistogram::count() const
+{
+  uint64_t ret=0;
+  QList<uint64_t> counts=bucketCounts();
+
+  for(int i=0;i<counts.size();i++) {
+    ret+=counts.at(i);
+  }
+
+  return ret;
+}
+
+
+uint64_t MetricsHistogram::sum() const
+{
+  uint64_t ret=0;
+
+  for(int i=0;i<METRICS_SHARDS;i++) {
+    ret+=d_cells[i].sum.load(std::memory_order_relaxed);
+  }
+
+  return ret;
+}
+
+
+double MetricsHistogram::quantile(double q) const
+{
+  //
+  // Estimated by linear interpolation within the bucket containing the
+  // requested rank, in microseconds.
+  //
+  QList<uint64_t> counts=bucketCounts();
+  uint64_t total=0;
+  for(int i=0;i<counts.size();i++) {
+    total+=counts.at(i);
+  }
+  if(total==0) {
+    return 0.0;
+  }
+  double rank=q*(double)total;
+  uint64_t seen=0;
+  for(int i=0;i<counts.size();i++) {
+    if(((double)(seen+counts.at(i))>=rank)&&(counts.at(i)>0)) {
+      double lower=(i==0)?0.0:(double)__metrics_bucket_bounds[i-1];
+      if(i==(counts.size()-1)) {
+	return lower;
+      }
+      double upper=(double)__metrics_bucket_bounds[i];
+      return lower+(upper-lower)*(rank-(double)seen)/(double)counts.at(i);
+    }
+    seen+=counts.at(i);
+  }
+
+  return (double)__metrics_bucket_bounds[counts.size()-2];
+}
+
+
+uint64_t MetricsHistogram::bucketBound(int bucket)
+{
+  return __metrics_bucket_bounds[bucket];
+}
+
+
+MetricsCounter *Metrics::counter(const QString &type,const QString &id,
+				 const QString &name,const QString &help)
+{
+  QMutexLocker locker(&__metrics_mutex);
+  MetricsObject *obj=Find(type,id,name);
+
+  if(obj==NULL) {
+    obj=new MetricsCounter(type,id,name,help);
+    __metrics_objects.push_back(obj);
+  }
+  MetricsCounter *ret=dynamic_cast<MetricsCounter *>(obj);
+  if(ret==NULL) {
+    KindMismatch(obj);
+  }
+  return ret;
+}
+
+
+MetricsGauge *Metrics::gauge(const QString &type,const QString &id,
+			     const QString &name,const QString &help)
+{
+  QMutexLocker locker(&__metrics_mutex);
+  MetricsObject *obj=Find(type,id,name);
+
+  if(obj==NULL) {
+    obj=new MetricsGauge(type,id,name,help);
+    __metrics_objects.push_back(obj);
+  }
+  MetricsGauge *ret=dynamic_cast<MetricsGauge *>(obj);
+  if(ret==NULL) {
+    KindMismatch(obj);
+  }
+  return ret;
+}
+
+
+MetricsHistogram *Metrics::histogram(const QString &type,const QString &id,
+				     const QString &name,const QString &help)
+{
+  QMutexLocker locker(&__metrics_mutex);
+  MetricsObject *obj=Find(type,id,name);
+
+  if(obj==NULL) {
+    obj=new MetricsHistogram(type,id,name,help);
+    __metrics_objects.push_back(obj);
+  }
+  MetricsHistogram *ret=dynamic_cast<MetricsHistogram *>(obj);
+  if(ret==NULL) {
+    KindMismatch(obj);
+  }
+  return ret;
+}
+
+
+QList<MetricsObject *> Metrics::objects()
+{
+  QMutexLocker locker(&__metrics_mutex);
+
+  return __metrics_objects;
+}
+
+
+uint64_t Metrics::monotonicUsec()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+
+  return 1000000ull*(uint64_t)ts.tv_sec+ts.tv_nsec/1000;
+}
+
+
+int64_t Metrics::realtimeNsec()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_REALTIME,&ts);
+
+  return 1000000000ll*(int64_t)ts.tv_sec+ts.tv_nsec;
+}
+
+
+QStringList Metrics::dump()
+{
+  QStringList ret;
+  QList<MetricsObject *> objs=Metrics::objects();
+
+  for(int i=0;i<objs.size();i++) {
+    MetricsObject *obj=objs.at(i);
+    QString prefix=obj->type()+" "+obj->id()+": "+obj->name();
+    switch(obj->kind()) {
+    case MetricsObject::KindCounter:
+      ret.push_back(prefix+
+		    QString::asprintf(" %" PRIu64,((MetricsCounter *)obj)->value()));
+      break;
+
+    case MetricsObject::KindGauge:
+      ret.push_back(prefix+
+		    QString::asprintf(" %" PRId64,((MetricsGauge *)obj)->value()));
+      break;
+
+    case MetricsObject::KindHistogram:
+      {
+	MetricsHistogram *hist=(MetricsHistogram *)obj;
+	ret.push_back(prefix+
+		      QString::asprintf(" count=%" PRIu64 " p50=%.0fus p99=%.0fus",
+					hist->count(),hist->quantile(0.5),
+					hist->quantile(0.99))+
+		      QString::asprintf(" p999=%.0fus",hist->quantile(0.999)));
+      }
+      break;
+    }
+  }
+
+  return ret;
+}
+
+
+MetricsObject *Metrics::Find(const QString &type,const QString &id,
+			     const QString &name)
+{
+  for(int i=0;i<__metrics_objects.size();i++) {
+    MetricsObject *obj=__metrics_objects.at(i);
+    if((obj->type()==type)&&(obj->id()==id)&&(obj->name()==name)) {
+      return obj;
+    }
+  }
+
+  return NULL;
+}
+
+
+void Metrics::KindMismatch(MetricsObject *obj)
+{
+  //
+  // Two callers disagree about what a metric is, which is a bug
+  //
+  fprintf(stderr,"lwsyslogger: metric \"%s\" for %s \"%s\" registered "
+	  "as more than one kind\n",obj->name().toUtf8().constData(),
+	  obj->type().toUtf8().constData(),obj->id().toUtf8().constData());
+  abort();
+}
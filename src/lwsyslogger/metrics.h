@@ -0,0 +1,166 @@
+// metrics.h
+//
+// Low-overhead counters and histograms for receivers and processors.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+//
+// Each counter is split into this many cache-line aligned cells, with
+// each thread updating only its own cell.
+//
+#define METRICS_SHARDS 8
+#define METRICS_CACHE_LINE 64
+
+//
+// Histogram bucket upper bounds, in microseconds (plus +Inf)
+//
+#define METRICS_HISTOGRAM_BUCKETS 20
+
+class MetricsObject
+{
+ public:
+  enum Kind {KindCounter=0,KindGauge=1,KindHistogram=2};
+  MetricsObject(const QString &type,const QString &id,const QString &name,
+		const QString &help);
+  virtual ~MetricsObject();
+  virtual Kind kind() const=0;
+  QString type() const;
+  QString id() const;
+  QString name() const;
+  QString help() const;
+  static void *operator new(size_t size);
+  static void operator delete(void *ptr);
+
+ protected:
+  static int shard();
+
+ private:
+  QString d_type;
+  QString d_id;
+  QString d_name;
+  QString d_help;
+};
+
+
+class MetricsCounter : public MetricsObject
+{
+ public:
+  MetricsCounter(const QString &type,const QString &id,const QString &name,
+		 const QString &help);
+  Kind kind() const;
+  void increment(uint64_t n=1)
+  {
+    d_cells[shard()].value.fetch_add(n,std::memory_order_relaxed);
+  }
+  uint64_t value() const;
+
+ private:
+  struct alignas(METRICS_CACHE_LINE) Cell {
+    std::atomic<uint64_t> value;
+  };
+  Cell d_cells[METRICS_SHARDS];
+};
+
+
+class MetricsGauge : public MetricsObject
+{
+ public:
+  MetricsGauge(const QString &type,const QString &id,const QString &name,
+	       const QString &help);
+  Kind kind() const;
+  void set(int64_t value)
+  {
+    d_value.store(value,std::memory_order_relaxed);
+  }
+  void add(int64_t n)
+  {
+    d_value.fetch_add(n,std::memory_order_relaxed);
+  }
+  int64_t value() const;
+
+ private:
+  alignas(METRICS_CACHE_LINE) std::atomic<int64_t> d_value;
+};
+
+
+class MetricsHistogram : public MetricsObject
+{
+ public:
+  MetricsHistogram(const QString &type,const QString &id,const QString &name,
+		   const QString &help);
+  Kind kind() const;
+  void observe(uint64_t usec)
+  {
+    Cell *cell=d_cells+shard();
+    int bucket=0;
+    while((bucket<(METRICS_HISTOGRAM_BUCKETS-1))&&
+	  (usec>MetricsHistogram::bucketBound(bucket))) {
+      bucket++;
+    }
+    cell->buckets[bucket].fetch_add(1,std::memory_order_relaxed);
+    cell->sum.fetch_add(usec,std::memory_order_relaxed);
+  }
+  QList<uint64_t> bucketCounts() const;
+  uint64_t count() const;
+  uint64_t sum() const;
+  double quantile(double q) const;
+  static uint64_t bucketBound(int bucket);
+
+ private:
+  struct alignas(METRICS_CACHE_LINE) Cell {
+    std::atomic<uint64_t> buckets[METRICS_HISTOGRAM_BUCKETS];
+    std::atomic<uint64_t> sum;
+  };
+  Cell d_cells[METRICS_SHARDS];
+};
+
+
+class Metrics
+{
+ public:
+  static MetricsCounter *counter(const QString &type,const QString &id,
+				 const QString &name,const QString &help);
+  static MetricsGauge *gauge(const QString &type,const QString &id,
+			     const QString &name,const QString &help);
+  static MetricsHistogram *histogram(const QString &type,const QString &id,
+				     const QString &name,const QString &help);
+  static QList<MetricsObject *> objects();
+  static uint64_t monotonicUsec();
+  static int64_t realtimeNsec();
+  static QStringList dump();
+
+ private:
+  static MetricsObject *Find(const QString &type,const QString &id,
+			     const QString &name);
+  static void KindMismatch(MetricsObject *obj);
+};
+
+
+#endif  // METRICS_H
@@ -0,0 +1,353 @@
+// metricsserver.cpp
+//
+// Serve the metrics registry in Prometheus text format.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <inttypes.h>
+
+#include <QStringList>
+
+#include "metrics.h"
+#include "metricsserver.h"
+
+MetricsServer::MetricsServer()
+  : QObject()
+{
+  d_server=NULL;
+  d_rate_timer=NULL;
+  d_port=0;
+  d_last_usec=0;
+
+  //
+  // Scrapes are handled in a thread of their own, so that they never
+  // delay message processing.
+  //
+  d_thread=new QThread();
+  d_thread->setObjectName("MetricsServer");
+  moveToThread(d_thread);
+  d_thread->start(QThread::LowPriority);
+}
+
+
+MetricsServer::~MetricsServer()
+{
+  stop();
+  delete d_thread;
+}
+
+
+bool MetricsServer::start(const QHostAddress &addr,uint16_t port,
+			  QString *err_msg)
+{
+  bool ret=false;
+
+  d_address=addr;
+  d_port=port;
+  QMetaObject::invokeMethod(this,"listen",Qt::BlockingQueuedConnection,
+			    Q_RETURN_ARG(bool,ret));
+  if(!ret) {
+    *err_msg=d_error_string;
+  }
+
+  return ret;
+}
+
+
+void MetricsServer::stop()
+{
+  if(d_thread->isRunning()) {
+    d_thread->quit();
+    d_thread->wait();
+  }
+}
+
+
+bool MetricsServer::listen()
+{
+  d_server=new QTcpServer(this);
+  connect(d_server,SIGNAL(newConnection()),this,SLOT(newConnectionData()));
+  if(!d_server->listen(d_address,d_port)) {
+    d_error_string=d_server->errorString();
+    return false;
+  }
+
+  //
+  // Rates are sampled here at a fixed interval rather than at each
+  // scrape, so that several scrapers don't skew each other's values.
+  //
+  d_rate_timer=new QTimer(this);
+  connect(d_rate_timer,SIGNAL(timeout()),this,SLOT(rateData()));
+  d_rate_timer->start(METRICSSERVER_RATE_INTERVAL);
+  rateData();
+
+  return true;
+}
+
+
+QByteArray MetricsServer::render()
+{
+  QString ret;
+  QList<MetricsObject *> objs=Metrics::objects();
+  QMap<QString,QList<MetricsObject *> > families;
+
+  for(int i=0;i<objs.size();i++) {
+    families[objs.at(i)->type()+"_"+objs.at(i)->name()].push_back(objs.at(i));
+  }
+  for(QMap<QString,QList<MetricsObject *> >::const_iterator it=
+	families.begin();it!=families.end();it++) {
+    MetricsObject *first=it.value().first();
+    QString name="lwsyslogger_"+it.key();
+    switch(first->kind()) {
+    case MetricsObject::KindCounter:
+      name+="_total";
+      ret+="# HELP "+name+" "+first->help()+"\n";
+      ret+="# TYPE "+name+" counter\n";
+      for(int i=0;i<it.value().size();i++) {
+	MetricsCounter *counter=(MetricsCounter *)it.value().at(i);
+	ret+=QString::asprintf("%s{id=\"%s\"} %" PRIu64 "\n",
+			       name.toUtf8().constData(),
+			       counter->id().toUtf8().constData(),
+			       counter->value());
+      }
+      break;
+
+    case MetricsObject::KindGauge:
+      ret+="# HELP "+name+" "+first->help()+"\n";
+      ret+="# TYPE "+name+" gauge\n";
+      for(int i=0;i<it.value().size();i++) {
+	MetricsGauge *gauge=(MetricsGauge *)it.value().at(i);
+	ret+=QString::asprintf("%s{id=\"%s\"} %" PRId64 "\n",
+			       name.toUtf8().constData(),
+			       gauge->id().toUtf8().constData(),
+			       gauge->value());
+      }
+      break;
+
+    case MetricsObject::KindHistogram:
+      //
+      // Observations are in microseconds; Prometheus expects seconds.
+      //
+      ret+="# HELP "+name+" "+first->help()+"\n";
+      ret+="# TYPE "+name+" histogram\n";
+      for(int i=0;i<it.value().size();i++) {
+	MetricsHistogram *hist=(MetricsHistogram *)it.value().at(i);
+	QByteArray id=hist->id().toUtf8();
+	QList<uint64_t> counts=hist->bucketCounts();
+	uint64_t total=0;
+	for(int j=0;j<counts.size();j++) {
+	  total+=counts.at(j);
+	  QString le="+Inf";
+	  if(j<(counts.size()-1)) {
+	    le=Format((double)MetricsHistogram::bucketBound(j)/1000000.0);
+	  }
+	  ret+=QString::asprintf("%s_bucket{id=\"%s\",le=\"%s\"} %" PRIu64
+				 "\n",
+				 name.toUtf8().constData(),id.constData(),
+				 le.toUtf8().constData(),total);
+	}
+	ret+=QString::asprintf("%s_sum{id=\"%s\"} %s\n",
+			       name.toUtf8().constData(),id.constData(),
+		 Format((double)hist->sum()/1000000.0).toUtf8().constData());
+	ret+=QString::asprintf("%s_count{id=\"%s\"} %" PRIu64 "\n",
+			       name.toUtf8().constData(),id.constData(),total);
+      }
+
+      //
+      // Estimated quantiles, for consumers that can't compute them from
+      // the buckets
+      //
+      ret+="# HELP "+name+"_quantile "+first->help()+" (estimated)\n";
+      ret+="# TYPE "+name+"_quantile gauge\n";
+      for(int i=0;i<it.value().size();i++) {
+	MetricsHistogram *hist=(MetricsHistogram *)it.value().at(i);
+	double quantiles[3]={0.5,0.99,0.999};
+	for(int j=0;j<3;j++) {
+	  ret+=QString::asprintf("%s_quantile{id=\"%s\",quantile=\"%s\"} %s\n",
+				 name.toUtf8().constData(),
+				 hist->id().toUtf8().constData(),
+				 Format(quantiles[j]).toUtf8().constData(),
+		 Format(hist->quantile(quantiles[j])/1000000.0).toUtf8().
+				 constData());
+	}
+      }
+      break;
+    }
+  }
+
+  //
+  // Derived values. Rates are averaged over the last sampling interval.
+  //
+  QString rate_name="lwsyslogger_processor_messages_per_second";
+  QString ratio_name="lwsyslogger_processor_deduplication_ratio";
+  QString rates;
+  QString ratios;
+  QList<MetricsObject *> received=
+    families.value("processor_messages_received");
+  QList<MetricsObject *> deduplicated=
+    families.value("processor_messages_deduplicated");
+  for(int i=0;i<received.size();i++) {
+    QString id=received.at(i)->id();
+    uint64_t value=((MetricsCounter *)received.at(i))->value();
+    if(d_rates.contains(id)) {
+      rates+=QString::asprintf("%s{id=\"%s\"} %s\n",
+			       rate_name.toUtf8().constData(),
+			       id.toUtf8().constData(),
+			  Format(d_rates.value(id)).toUtf8().constData());
+    }
+    MetricsCounter *dups=NULL;
+    for(int j=0;j<deduplicated.size();j++) {
+      if(deduplicated.at(j)->id()==id) {
+	dups=(MetricsCounter *)deduplicated.at(j);
+      }
+    }
+    if((dups!=NULL)&&(value>0)) {
+      ratios+=QString::asprintf("%s{id=\"%s\"} %s\n",
+				ratio_name.toUtf8().constData(),
+				id.toUtf8().constData(),
+		  Format((double)dups->value()/(double)value).toUtf8().
+				constData());
+    }
+  }
+  if(!rates.isEmpty()) {
+    ret+="# HELP "+rate_name+
+      " Messages presented to the processor per second\n";
+    ret+="# TYPE "+rate_name+" gauge\n";
+    ret+=rates;
+  }
+  if(!ratios.isEmpty()) {
+    ret+="# HELP "+ratio_name+
+      " Fraction of received messages suppressed as duplicates\n";
+    ret+="# TYPE "+ratio_name+" gauge\n";
+    ret+=ratios;
+  }
+
+  return ret.toUtf8();
+}
+
+
+void MetricsServer::newConnectionData()
+{
+  QTcpSocket *sock=NULL;
+
+  while((sock=d_server->nextPendingConnection())!=NULL) {
+    if(d_sockets.size()>=METRICSSERVER_MAX_CONNECTIONS) {
+      sock->abort();
+      sock->deleteLater();
+      continue;
+    }
+    connect(sock,SIGNAL(readyRead()),this,SLOT(readyReadData()));
+    connect(sock,SIGNAL(disconnected()),this,SLOT(disconnectedData()));
+    d_sockets.push_back(sock);
+    d_requests[sock]=QByteArray();
+
+    //
+    // Covers both a request that never completes and a response that is
+    // never read
+    //
+    QTimer *timer=new QTimer(sock);
+    timer->setSingleShot(true);
+    connect(timer,SIGNAL(timeout()),this,SLOT(idleData()));
+    timer->start(METRICSSERVER_IDLE_TIMEOUT);
+  }
+}
+
+
+void MetricsServer::readyReadData()
+{
+  QTcpSocket *sock=(QTcpSocket *)sender();
+  QByteArray body;
+  QByteArray status;
+
+  d_requests[sock]+=sock->readAll();
+  QByteArray req=d_requests.value(sock);
+  if(!req.contains("\r\n\r\n")) {
+    if(req.size()>METRICSSERVER_MAX_REQUEST_SIZE) {
+      d_requests.remove(sock);
+      sock->disconnectFromHost();
+    }
+    return;
+  }
+  d_requests.remove(sock);
+
+  QList<QByteArray> f0=req.left(req.indexOf("\r\n")).split(' ');
+  if((f0.size()==3)&&(f0.at(0)=="GET")&&
+     ((f0.at(1)=="/metrics")||f0.at(1).startsWith("/metrics?"))) {
+    status="200 OK";
+    body=render();
+  }
+  else {
+    status="404 Not Found";
+    body="Not Found\n";
+  }
+  sock->write("HTTP/1.0 "+status+"\r\n"+
+	      "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"+
+	      "Content-Length: "+QByteArray::number(body.size())+"\r\n"+
+	      "Connection: close\r\n\r\n"+body);
+  sock->disconnectFromHost();
+}
+
+
+void MetricsServer::disconnectedData()
+{
+  QTcpSocket *sock=(QTcpSocket *)sender();
+
+  d_sockets.removeAll(sock);
+  d_requests.remove(sock);
+  sock->deleteLater();
+}
+
+
+void MetricsServer::idleData()
+{
+  QTcpSocket *sock=(QTcpSocket *)sender()->parent();
+
+  d_sockets.removeAll(sock);
+  d_requests.remove(sock);
+  sock->abort();
+  sock->deleteLater();
+}
+
+
+void MetricsServer::rateData()
+{
+  QList<MetricsObject *> objs=Metrics::objects();
+  QMap<QString,uint64_t> values;
+  uint64_t now_usec=Metrics::monotonicUsec();
+  double elapsed=(double)(now_usec-d_last_usec)/1000000.0;
+
+  d_rates.clear();
+  for(int i=0;i<objs.size();i++) {
+    if((objs.at(i)->type()=="processor")&&
+       (objs.at(i)->name()=="messages_received")) {
+      QString id=objs.at(i)->id();
+      uint64_t value=((MetricsCounter *)objs.at(i))->value();
+      if((d_last_usec>0)&&(elapsed>0.0)&&d_last_values.contains(id)) {
+	d_rates[id]=(double)(value-d_last_values.value(id))/elapsed;
+      }
+      values[id]=value;
+    }
+  }
+  d_last_values=values;
+  d_last_usec=now_usec;
+}
+
+
+QString MetricsServer::Format(double value) const
+{
+  return QString::number(value,'g',9);
+}
@@ -0,0 +1,80 @@
+// metricsserver.h
+//
+// Serve the metrics registry in Prometheus text format.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <stdint.h>
+
+#include <QHostAddress>
+#include <QMap>
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+
+//
+// Defaults
+//
+#define METRICSSERVER_DEFAULT_ADDRESS "127.0.0.1"
+#define METRICSSERVER_DEFAULT_PORT 9514
+#define METRICSSERVER_MAX_REQUEST_SIZE 8192
+#define METRICSSERVER_MAX_CONNECTIONS 16
+#define METRICSSERVER_IDLE_TIMEOUT 10000
+#define METRICSSERVER_RATE_INTERVAL 10000
+
+class MetricsServer : public QObject
+{
+  Q_OBJECT
+ public:
+  MetricsServer();
+  ~MetricsServer();
+  bool start(const QHostAddress &addr,uint16_t port,QString *err_msg);
+  void stop();
+  QByteArray render();
+
+ public slots:
+  bool listen();
+
+ private slots:
+  void newConnectionData();
+  void readyReadData();
+  void disconnectedData();
+  void idleData();
+  void rateData();
+
+ private:
+  QString Format(double value) const;
+  QThread *d_thread;
+  QTcpServer *d_server;
+  QHostAddress d_address;
+  uint16_t d_port;
+  QString d_error_string;
+  QList<QTcpSocket *> d_sockets;
+  QMap<QTcpSocket *,QByteArray> d_requests;
+  QTimer *d_rate_timer;
+  QMap<QString,uint64_t> d_last_values;
+  QMap<QString,double> d_rates;
+  uint64_t d_last_usec;
+};
+
+
+#endif  // METRICSSERVER_H
@@ -0,0 +1,914 @@
+// patternfilter.cpp
+//
+// Match message text against a set of literal and regex patterns.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <ctype.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "patternfilter.h"
+
+PatternFilter::PatternFilter()
+{
+  d_stop_bits=0;
+  d_need_bits=0;
+  memset(d_literal_class_map,0,sizeof(d_literal_class_map));
+  d_literal_classes=0;
+  memset(d_regex_class_map,0,sizeof(d_regex_class_map));
+  d_regex_classes=0;
+}
+
+
+bool PatternFilter::isEmpty() const
+{
+  return d_patterns[PatternFilter::KindMatch].isEmpty()&&
+    d_patterns[PatternFilter::KindExclude].isEmpty();
+}
+
+
+bool PatternFilter::addPattern(Kind kind,const QString &pattern,
+			       QString *err_msg)
+{
+  QByteArray raw=pattern.toUtf8();
+
+  if(raw.isEmpty()) {
+    *err_msg="empty pattern";
+    return false;
+  }
+
+  //
+  // Patterns written as "/regex/" or "/regex/i" are regular expressions,
+  // anything else is a literal substring.
+  //
+  int slash=raw.lastIndexOf('/');
+  QByteArray flags=raw.mid(slash+1);
+  if((raw.at(0)=='/')&&(slash>0)&&(flags.isEmpty()||(flags=="i"))) {
+    int node_count=d_nodes.size();
+    int set_count=d_sets.size();
+    Parser p;
+    Fragment frag;
+    p.pattern=raw.mid(1,slash-1);
+    p.pos=0;
+    p.icase=(flags=="i");
+    if(p.pattern.isEmpty()) {
+      p.error="empty regex";
+    }
+    else {
+      if(ParseAlternation(&p,&frag)&&(p.pos<p.pattern.size())) {
+	p.error="unmatched \")\"";
+      }
+    }
+    if(!p.error.isEmpty()) {
+      *err_msg=QString::asprintf("invalid regex \"%s\" [%s at offset %d]",
+				 pattern.toUtf8().constData(),
+				 p.error.toUtf8().constData(),p.pos);
+      d_nodes.resize(node_count);
+      d_sets.resize(set_count);
+      return false;
+    }
+    Patch(frag.outs,AddNode(PatternFilter::NodeAccept,-1,-1,-1,1u<<kind));
+    d_regex_starts.push_back(frag.start);
+  }
+  else {
+    d_literals[kind].push_back(raw);
+  }
+  d_patterns[kind].push_back(pattern);
+
+  return true;
+}
+
+
+bool PatternFilter::compile(QString *err_msg)
+{
+  uint32_t match_bit=1u<<PatternFilter::KindMatch;
+  uint32_t exclude_bit=1u<<PatternFilter::KindExclude;
+
+  CompileLiterals();
+  if(!CompileRegexes(err_msg)) {
+    return false;
+  }
+
+  //
+  // Scanning can stop as soon as an exclusion is found or, when there are
+  // no exclusions, as soon as a match is.
+  //
+  d_need_bits=0;
+  d_stop_bits=0;
+  if(!d_patterns[PatternFilter::KindMatch].isEmpty()) {
+    d_need_bits=match_bit;
+  }
+  if(d_patterns[PatternFilter::KindExclude].isEmpty()) {
+    d_stop_bits=match_bit;
+  }
+  else {
+    d_stop_bits=exclude_bit;
+  }
+
+  return true;
+}
+
+
+bool PatternFilter::accepts(const QByteArray &text) const
+{
+  const uint8_t *data=(const uint8_t *)text.constData();
+  int len=text.size();
+  uint32_t bits=0;
+  int state=0;
+  int i=0;
+
+  if(!d_literal_table.isEmpty()) {
+    const int32_t *table=d_literal_table.constData();
+    const uint32_t *out=d_literal_bits.constData();
+    for(i=0;i<len;i++) {
+      state=table[state*d_literal_classes+d_literal_class_map[data[i]]];
+      if(((bits|=out[state])&d_stop_bits)!=0) {
+	break;
+      }
+    }
+  }
+  if((!d_regex_table.isEmpty())&&((bits&d_stop_bits)==0)) {
+    const int32_t *table=d_regex_table.constData();
+    const uint32_t *out=d_regex_bits.constData();
+    state=0;
+    bits|=out[0];
+    for(i=0;(i<len)&&((bits&d_stop_bits)==0);i++) {
+      state=table[state*d_regex_classes+d_regex_class_map[data[i]]];
+      bits|=out[state];
+    }
+    if(i==len) {
+      bits|=d_regex_eol_bits.at(state);
+    }
+  }
+  if((bits&(1u<<PatternFilter::KindExclude))!=0) {
+    return false;
+  }
+
+  return (bits&d_need_bits)==d_need_bits;
+}
+
+
+int PatternFilter::literalStates() const
+{
+  return d_literal_bits.size();
+}
+
+
+int PatternFilter::regexStates() const
+{
+  return d_regex_bits.size();
+}
+
+
+QString PatternFilter::patterns(Kind kind) const
+{
+  return d_patterns[kind].join(", ");
+}
+
+
+bool PatternFilter::ParseAlternation(Parser *p,Fragment *frag)
+{
+  Fragment next;
+
+  if(!ParseConcatenation(p,frag)) {
+    return false;
+  }
+  while((p->pos<p->pattern.size())&&(p->pattern.at(p->pos)=='|')) {
+    p->pos++;
+    if(!ParseConcatenation(p,&next)) {
+      return false;
+    }
+    frag->start=AddNode(PatternFilter::NodeSplit,frag->start,next.start);
+    frag->outs+=next.outs;
+  }
+
+  return true;
+}
+
+
+bool PatternFilter::ParseConcatenation(Parser *p,Fragment *frag)
+{
+  Fragment next;
+  bool first=true;
+
+  while((p->pos<p->pattern.size())&&(p->pattern.at(p->pos)!='|')&&
+	(p->pattern.at(p->pos)!=')')) {
+    if(!ParseRepetition(p,&next)) {
+      return false;
+    }
+    if(first) {
+      *frag=next;
+      first=false;
+    }
+    else {
+      Patch(frag->outs,next.start);
+      frag->outs=next.outs;
+    }
+  }
+  if(first) {  // Empty branch
+    frag->start=AddNode(PatternFilter::NodeEpsilon);
+    frag->outs.clear();
+    frag->outs.push_back(2*frag->start);
+  }
+
+  return true;
+}
+
+
+bool PatternFilter::ParseRepetition(Parser *p,Fragment *frag)
+{
+  int atom_pos=p->pos;
+  int split=-1;
+  int min=0;
+  int max=0;
+  bool ok=false;
+
+  if(!ParseAtom(p,frag)) {
+    return false;
+  }
+  if(p->pos>=p->pattern.size()) {
+    return true;
+  }
+  switch(p->pattern.at(p->pos)) {
+  case '*':
+    split=AddNode(PatternFilter::NodeSplit,frag->start);
+    Patch(frag->outs,split);
+    frag->start=split;
+    frag->outs.clear();
+    frag->outs.push_back(2*split+1);
+    p->pos++;
+    break;
+
+  case '+':
+    split=AddNode(PatternFilter::NodeSplit,frag->start);
+    Patch(frag->outs,split);
+    frag->outs.clear();
+    frag->outs.push_back(2*split+1);
+    p->pos++;
+    break;
+
+  case '?':
+    split=AddNode(PatternFilter::NodeSplit,frag->start);
+    frag->start=split;
+    frag->outs.push_back(2*split+1);
+    p->pos++;
+    break;
+
+  case '{': {
+    //
+    // Bounded repeats are expanded into copies of the atom, each made by
+    // parsing it again.
+    //
+    int end=p->pattern.indexOf('}',p->pos);
+    if(end<0) {
+      p->error="missing \"}\"";
+      return false;
+    }
+    QList<QByteArray> f0=p->pattern.mid(p->pos+1,end-p->pos-1).split(',');
+    min=f0.at(0).toInt(&ok);
+    if(ok) {
+      if(f0.size()==1) {
+	max=min;
+      }
+      else {
+	if(f0.at(1).isEmpty()) {
+	  max=-1;
+	}
+	else {
+	  max=f0.at(1).toInt(&ok);
+	}
+      }
+    }
+    if((!ok)||(f0.size()>2)||(min<0)||(min>PATTERNFILTER_MAX_REPEAT)||
+       ((max>=0)&&((max<min)||(max>PATTERNFILTER_MAX_REPEAT)))) {
+      p->error="invalid repeat count";
+      return false;
+    }
+    Fragment result;
+    Fragment copy;
+    bool empty=true;
+    int count=(max<0)?min+1:max;
+    if(count==0) {
+      result.start=AddNode(PatternFilter::NodeEpsilon);
+      result.outs.push_back(2*result.start);
+      empty=false;
+    }
+    for(int i=0;i<count;i++) {
+      if(i==0) {
+	copy=*frag;
+      }
+      else {
+	p->pos=atom_pos;
+	if(!ParseAtom(p,&copy)) {
+	  return false;
+	}
+      }
+      if((max<0)&&(i==min)) {  // Unbounded tail, as for '*'
+	split=AddNode(PatternFilter::NodeSplit,copy.start);
+	Patch(copy.outs,split);
+	copy.start=split;
+	copy.outs.clear();
+	copy.outs.push_back(2*split+1);
+      }
+      else {
+	if(i>=min) {  // Optional copy, as for '?'
+	  split=AddNode(PatternFilter::NodeSplit,copy.start);
+	  copy.start=split;
+	  copy.outs.push_back(2*split+1);
+	}
+      }
+      if(empty) {
+	result=copy;
+	empty=false;
+      }
+      else {
+	Patch(result.outs,copy.start);
+	result.outs=copy.outs;
+      }
+    }
+    *frag=result;
+    p->pos=end+1;
+    break;
+  }
+
+  default:
+    return true;
+  }
+  if((p->pos<p->pattern.size())&&
+     (strchr("*+?{",p->pattern.at(p->pos))!=NULL)) {
+    p->error="nested repeat";
+    return false;
+  }
+
+  return true;
+}
+
+
+bool PatternFilter::ParseAtom(Parser *p,Fragment *frag)
+{
+  CharSet set;
+  int node=-1;
+
+  memset(&set,0,sizeof(set));
+  switch(p->pattern.at(p->pos)) {
+  case '(':
+    p->pos++;
+    if(p->pattern.mid(p->pos,2)=="?:") {
+      p->pos+=2;
+    }
+    if(!ParseAlternation(p,frag)) {
+      return false;
+    }
+    if((p->pos>=p->pattern.size())||(p->pattern.at(p->pos)!=')')) {
+      p->error="missing \")\"";
+      return false;
+    }
+    p->pos++;
+    return true;
+
+  case '*':
+  case '+':
+  case '?':
+  case '{':
+    p->error="nothing to repeat";
+    return false;
+
+  case '^':
+    node=AddNode(PatternFilter::NodeBol);
+    p->pos++;
+    break;
+
+  case '$':
+    node=AddNode(PatternFilter::NodeEol);
+    p->pos++;
+    break;
+
+  case '[':
+    if(!ParseClass(p,&set)) {
+      return false;
+    }
+    node=AddNode(PatternFilter::NodeSet,-1,-1,AddSet(set));
+    break;
+
+  case '.':
+    memset(&set,0xFF,sizeof(set));
+    node=AddNode(PatternFilter::NodeSet,-1,-1,AddSet(set));
+    p->pos++;
+    break;
+
+  case '\\':
+    if(!ParseEscape(p,&set)) {
+      return false;
+    }
+    node=AddNode(PatternFilter::NodeSet,-1,-1,AddSet(set));
+    break;
+
+  default:
+    SetAdd(&set,p->pattern.at(p->pos));
+    if(p->icase) {
+      FoldCase(&set);
+    }
+    node=AddNode(PatternFilter::NodeSet,-1,-1,AddSet(set));
+    p->pos++;
+    break;
+  }
+  frag->start=node;
+  frag->outs.clear();
+  frag->outs.push_back(2*node);
+
+  return true;
+}
+
+
+bool PatternFilter::ParseClass(Parser *p,CharSet *set)
+{
+  bool negate=false;
+  bool first=true;
+
+  p->pos++;  // Skip '['
+  if((p->pos<p->pattern.size())&&(p->pattern.at(p->pos)=='^')) {
+    negate=true;
+    p->pos++;
+  }
+  while(p->pos<p->pattern.size()) {
+    uint8_t c=p->pattern.at(p->pos);
+    if((c==']')&&(!first)) {
+      p->pos++;
+      if(p->icase) {
+	FoldCase(set);
+      }
+      if(negate) {
+	for(int i=0;i<4;i++) {
+	  set->words[i]=~set->words[i];
+	}
+      }
+      return true;
+    }
+    first=false;
+    if(c=='\\') {
+      CharSet esc;
+      memset(&esc,0,sizeof(esc));
+      if(!ParseEscape(p,&esc)) {
+	return false;
+      }
+      for(int i=0;i<4;i++) {
+	set->words[i]|=esc.words[i];
+      }
+      continue;
+    }
+    p->pos++;
+    if(((p->pos+1)<p->pattern.size())&&(p->pattern.at(p->pos)=='-')&&
+       (p->pattern.at(p->pos+1)!=']')) {
+      uint8_t last=p->pattern.at(p->pos+1);
+      if(last<c) {
+	p->error="invalid range";
+	return false;
+      }
+      for(int i=c;i<=last;i++) {
+	SetAdd(set,i);
+      }
+      p->pos+=2;
+    }
+    else {
+      SetAdd(set,c);
+    }
+  }
+  p->error="missing \"]\"";
+
+  return false;
+}
+
+
+bool PatternFilter::ParseEscape(Parser *p,CharSet *set)
+{
+  bool negate=false;
+
+  p->pos++;  // Skip '\'
+  if(p->pos>=p->pattern.size()) {
+    p->error="trailing \"\\\"";
+    return false;
+  }
+  uint8_t c=p->pattern.at(p->pos++);
+  switch(c) {
+  case 'D':
+    negate=true;
+    // Fall through
+  case 'd':
+    for(int i='0';i<='9';i++) {
+      SetAdd(set,i);
+    }
+    break;
+
+  case 'W':
+    negate=true;
+    // Fall through
+  case 'w':
+    for(int i=0;i<256;i++) {
+      if(isalnum(i)||(i=='_')) {
+	SetAdd(set,i);
+      }
+    }
+    break;
+
+  case 'S':
+    negate=true;
+    // Fall through
+  case 's':
+    SetAdd(set,' ');
+    SetAdd(set,'\t');
+    SetAdd(set,'\n');
+    SetAdd(set,'\r');
+    SetAdd(set,'\f');
+    SetAdd(set,'\v');
+    break;
+
+  case 't':
+    SetAdd(set,'\t');
+    break;
+
+  case 'n':
+    SetAdd(set,'\n');
+    break;
+
+  case 'r':
+    SetAdd(set,'\r');
+    break;
+
+  default:
+    if(isalnum(c)) {
+      p->pos--;
+      p->error="unsupported escape";
+      return false;
+    }
+    SetAdd(set,c);
+    break;
+  }
+
+  //
+  // Case is folded before any negation, else "\W" would match letters
+  //
+  if(p->icase) {
+    FoldCase(set);
+  }
+  if(negate) {
+    for(int i=0;i<4;i++) {
+      set->words[i]=~set->words[i];
+    }
+  }
+
+  return true;
+}
+
+
+int PatternFilter::AddNode(NodeType type,int out,int out1,int set,
+			   uint32_t bits)
+{
+  Node node;
+
+  node.type=type;
+  node.out=out;
+  node.out1=out1;
+  node.set=set;
+  node.bits=bits;
+  d_nodes.push_back(node);
+
+  return d_nodes.size()-1;
+}
+
+
+int PatternFilter::AddSet(const CharSet &set)
+{
+  d_sets.push_back(set);
+
+  return d_sets.size()-1;
+}
+
+
+void PatternFilter::Patch(const QVector<int> &outs,int node)
+{
+  for(int i=0;i<outs.size();i++) {
+    if((outs.at(i)&1)==0) {
+      d_nodes[outs.at(i)/2].out=node;
+    }
+    else {
+      d_nodes[outs.at(i)/2].out1=node;
+    }
+  }
+}
+
+
+void PatternFilter::Closure(int node,bool at_begin,bool at_end,
+			    QVector<int> *nodes,QVector<int> *marks,
+			    int mark) const
+{
+  QVector<int> stack;
+
+  //
+  // Collect the nodes reachable from 'node' without consuming a byte.
+  // Only those that consume a byte, accept or test for the end of the
+  // text are kept, as the rest do not affect what happens next.
+  //
+  stack.push_back(node);
+  while(!stack.isEmpty()) {
+    int n=stack.last();
+    stack.pop_back();
+    if((n<0)||(marks->at(n)==mark)) {
+      continue;
+    }
+    (*marks)[n]=mark;
+    const Node &nd=d_nodes.at(n);
+    switch(nd.type) {
+    case PatternFilter::NodeSet:
+    case PatternFilter::NodeAccept:
+      nodes->push_back(n);
+      break;
+
+    case PatternFilter::NodeEol:
+      nodes->push_back(n);
+      if(at_end) {
+	stack.push_back(nd.out);
+      }
+      break;
+
+    case PatternFilter::NodeBol:
+      if(at_begin) {
+	stack.push_back(nd.out);
+      }
+      break;
+
+    case PatternFilter::NodeSplit:
+      stack.push_back(nd.out1);
+      stack.push_back(nd.out);
+      break;
+
+    case PatternFilter::NodeEpsilon:
+      stack.push_back(nd.out);
+      break;
+    }
+  }
+}
+
+
+void PatternFilter::CompileLiterals()
+{
+  QVector<CharSet> sets;
+  QVector<int32_t> table;
+  QVector<uint32_t> bits;
+  QVector<int> fail;
+  QVector<int> queue;
+
+  d_literal_table.clear();
+  d_literal_bits.clear();
+  if(d_literals[PatternFilter::KindMatch].isEmpty()&&
+     d_literals[PatternFilter::KindExclude].isEmpty()) {
+    return;
+  }
+
+  //
+  // Bytes that appear in no literal all share a single class, which keeps
+  // the transition table small.
+  //
+  for(int k=0;k<2;k++) {
+    for(int i=0;i<d_literals[k].size();i++) {
+      for(int j=0;j<d_literals[k].at(i).size();j++) {
+	CharSet set;
+	memset(&set,0,sizeof(set));
+	SetAdd(&set,d_literals[k].at(i).at(j));
+	sets.push_back(set);
+      }
+    }
+  }
+  ClassMap(sets,d_literal_class_map,&d_literal_classes);
+
+  //
+  // Build the trie
+  //
+  table.fill(-1,d_literal_classes);
+  bits.push_back(0);
+  for(int k=0;k<2;k++) {
+    for(int i=0;i<d_literals[k].size();i++) {
+      const QByteArray &lit=d_literals[k].at(i);
+      int state=0;
+      for(int j=0;j<lit.size();j++) {
+	int c=d_literal_class_map[(uint8_t)lit.at(j)];
+	if(table.at(state*d_literal_classes+c)<0) {
+	  table[state*d_literal_classes+c]=bits.size();
+	  table.resize(table.size()+d_literal_classes);
+	  for(int l=0;l<d_literal_classes;l++) {
+	    table[table.size()-d_literal_classes+l]=-1;
+	  }
+	  bits.push_back(0);
+	}
+	state=table.at(state*d_literal_classes+c);
+      }
+      bits[state]|=1u<<k;
+    }
+  }
+
+  //
+  // Add the failure links breadth first, folding them into the table so
+  // that each byte costs exactly one lookup.
+  //
+  fail.fill(0,bits.size());
+  for(int c=0;c<d_literal_classes;c++) {
+    int next=table.at(c);
+    if(next<0) {
+      table[c]=0;
+    }
+    else {
+      queue.push_back(next);
+    }
+  }
+  for(int i=0;i<queue.size();i++) {
+    int state=queue.at(i);
+    bits[state]|=bits.at(fail.at(state));
+    for(int c=0;c<d_literal_classes;c++) {
+      int next=table.at(state*d_literal_classes+c);
+      int fallback=table.at(fail.at(state)*d_literal_classes+c);
+      if(next<0) {
+	table[state*d_literal_classes+c]=fallback;
+      }
+      else {
+	fail[next]=fallback;
+	queue.push_back(next);
+      }
+    }
+  }
+  d_literal_table=table;
+  d_literal_bits=bits;
+}
+
+
+bool PatternFilter::CompileRegexes(QString *err_msg)
+{
+  QHash<QByteArray,int> ids;
+  QVector<QVector<int> > states;
+  QVector<int> marks;
+  QVector<int> next;
+  uint8_t reps[256];
+  int mark=0;
+
+  d_regex_table.clear();
+  d_regex_bits.clear();
+  d_regex_eol_bits.clear();
+  if(d_regex_starts.isEmpty()) {
+    return true;
+  }
+
+  //
+  // Join the patterns under a common root, behind a loop that consumes
+  // any byte so that matches can begin anywhere in the text. These are
+  // dropped again afterward, so that compile() can be called repeatedly.
+  //
+  int node_count=d_nodes.size();
+  int set_count=d_sets.size();
+  int root=d_regex_starts.last();
+  for(int i=d_regex_starts.size()-2;i>=0;i--) {
+    root=AddNode(PatternFilter::NodeSplit,d_regex_starts.at(i),root);
+  }
+  CharSet any;
+  memset(&any,0xFF,sizeof(any));
+  int loop=AddNode(PatternFilter::NodeSplit,-1,root);
+  int any_node=AddNode(PatternFilter::NodeSet,loop,-1,AddSet(any));
+  d_nodes[loop].out=any_node;
+  ClassMap(d_sets,d_regex_class_map,&d_regex_classes);
+  for(int i=255;i>=0;i--) {
+    reps[d_regex_class_map[i]]=i;
+  }
+  marks.fill(-1,d_nodes.size());
+
+  //
+  // Subset construction, breadth first from the start state
+  //
+  Closure(loop,true,false,&next,&marks,mark++);
+  std::sort(next.begin(),next.end());
+  states.push_back(next);
+  ids[QByteArray((const char *)next.constData(),next.size()*sizeof(int))]=0;
+  for(int i=0;i<states.size();i++) {
+    uint32_t bits=0;
+    uint32_t eol_bits=0;
+    for(int c=0;c<d_regex_classes;c++) {
+      next.clear();
+      for(int j=0;j<states.at(i).size();j++) {
+	const Node &nd=d_nodes.at(states.at(i).at(j));
+	if((nd.type==PatternFilter::NodeSet)&&
+	   SetContains(d_sets.at(nd.set),reps[c])) {
+	  Closure(nd.out,false,false,&next,&marks,mark);
+	}
+      }
+      mark++;
+      std::sort(next.begin(),next.end());
+      QByteArray key((const char *)next.constData(),next.size()*sizeof(int));
+      QHash<QByteArray,int>::const_iterator it=ids.find(key);
+      if(it==ids.end()) {
+	if(states.size()>=PATTERNFILTER_MAX_DFA_STATES) {
+	  *err_msg=QString::asprintf("regex set needs more than %d states",
+				     PATTERNFILTER_MAX_DFA_STATES);
+	  d_regex_table.clear();
+	  d_nodes.resize(node_count);
+	  d_sets.resize(set_count);
+	  return false;
+	}
+	ids[key]=states.size();
+	d_regex_table.push_back(states.size());
+	states.push_back(next);
+      }
+      else {
+	d_regex_table.push_back(it.value());
+      }
+    }
+
+    //
+    // Acceptance, both here and should the text end here
+    //
+    next.clear();
+    for(int j=0;j<states.at(i).size();j++) {
+      const Node &nd=d_nodes.at(states.at(i).at(j));
+      if(nd.type==PatternFilter::NodeAccept) {
+	bits|=nd.bits;
+      }
+      if(nd.type==PatternFilter::NodeEol) {
+	Closure(nd.out,false,true,&next,&marks,mark);
+      }
+    }
+    mark++;
+    for(int j=0;j<next.size();j++) {
+      eol_bits|=d_nodes.at(next.at(j)).bits;
+    }
+    d_regex_bits.push_back(bits);
+    d_regex_eol_bits.push_back(eol_bits);
+  }
+  d_nodes.resize(node_count);
+  d_sets.resize(set_count);
+
+  return true;
+}
+
+
+void PatternFilter::ClassMap(const QVector<CharSet> &sets,uint8_t *map,
+			     int *classes)
+{
+  QHash<QByteArray,int> ids;
+
+  //
+  // Bytes that fall in exactly the same sets are interchangeable, and
+  // so get the same class.
+  //
+  for(int i=0;i<256;i++) {
+    QByteArray sig((sets.size()+7)/8,0);
+    for(int j=0;j<sets.size();j++) {
+      if(SetContains(sets.at(j),i)) {
+	sig[j/8]=sig.at(j/8)|(1<<(j%8));
+      }
+    }
+    QHash<QByteArray,int>::const_iterator it=ids.find(sig);
+    if(it==ids.end()) {
+      int id=ids.size();
+      ids[sig]=id;
+      map[i]=id;
+    }
+    else {
+      map[i]=it.value();
+    }
+  }
+  *classes=ids.size();
+}
+
+
+void PatternFilter::FoldCase(CharSet *set)
+{
+  for(int i='A';i<='Z';i++) {
+    if(SetContains(*set,i)||SetContains(*set,tolower(i))) {
+      SetAdd(set,i);
+      SetAdd(set,tolower(i));
+    }
+  }
+}
+
+
+bool PatternFilter::SetContains(const CharSet &set,uint8_t c)
+{
+  return (set.words[c/64]&(1ull<<(c%64)))!=0;
+}
+
+
+void PatternFilter::SetAdd(CharSet *set,uint8_t c)
+{
+  set->words[c/64]|=1ull<<(c%64);
+}
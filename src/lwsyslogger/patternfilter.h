@@ -0,0 +1,120 @@
+// patternfilter.h
+//
+// Match message text against a set of literal and regex patterns.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef PATTERNFILTER_H
+#define PATTERNFILTER_H
+
+#include <stdint.h>
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+//
+// Limits
+//
+#define PATTERNFILTER_MAX_DFA_STATES 8192
+#define PATTERNFILTER_MAX_REPEAT 255
+
+class PatternFilter
+{
+ public:
+  enum Kind {KindMatch=0,KindExclude=1};
+  PatternFilter();
+  bool isEmpty() const;
+  bool addPattern(Kind kind,const QString &pattern,QString *err_msg);
+  bool compile(QString *err_msg);
+  bool accepts(const QByteArray &text) const;
+  int literalStates() const;
+  int regexStates() const;
+  QString patterns(Kind kind) const;
+
+ private:
+  enum NodeType {NodeSet=0,NodeSplit=1,NodeEpsilon=2,NodeBol=3,NodeEol=4,
+		 NodeAccept=5};
+  struct CharSet {
+    uint64_t words[4];
+  };
+  struct Node {
+    NodeType type;
+    int out;
+    int out1;
+    int set;
+    uint32_t bits;
+  };
+  struct Fragment {
+    int start;
+    QVector<int> outs;
+  };
+  struct Parser {
+    QByteArray pattern;
+    int pos;
+    bool icase;
+    QString error;
+  };
+  bool ParseAlternation(Parser *p,Fragment *frag);
+  bool ParseConcatenation(Parser *p,Fragment *frag);
+  bool ParseRepetition(Parser *p,Fragment *frag);
+  bool ParseAtom(Parser *p,Fragment *frag);
+  bool ParseClass(Parser *p,CharSet *set);
+  bool ParseEscape(Parser *p,CharSet *set);
+  int AddNode(NodeType type,int out=-1,int out1=-1,int set=-1,
+	      uint32_t bits=0);
+  int AddSet(const CharSet &set);
+  void Patch(const QVector<int> &outs,int node);
+  void Closure(int node,bool at_begin,bool at_end,QVector<int> *nodes,
+	       QVector<int> *marks,int mark) const;
+  void CompileLiterals();
+  bool CompileRegexes(QString *err_msg);
+  static void ClassMap(const QVector<CharSet> &sets,uint8_t *map,
+		       int *classes);
+  static void FoldCase(CharSet *set);
+  static bool SetContains(const CharSet &set,uint8_t c);
+  static void SetAdd(CharSet *set,uint8_t c);
+  uint32_t d_stop_bits;
+  uint32_t d_need_bits;
+  QStringList d_patterns[2];
+
+  //
+  // Literals, as an Aho-Corasick automaton
+  //
+  QVector<QByteArray> d_literals[2];
+  uint8_t d_literal_class_map[256];
+  int d_literal_classes;
+  QVector<int32_t> d_literal_table;
+  QVector<uint32_t> d_literal_bits;
+
+  //
+  // Regexes, as a single Thompson NFA made into a DFA
+  //
+  QVector<Node> d_nodes;
+  QVector<CharSet> d_sets;
+  QVector<int> d_regex_starts;
+  uint8_t d_regex_class_map[256];
+  int d_regex_classes;
+  QVector<int32_t> d_regex_table;
+  QVector<uint32_t> d_regex_bits;
+  QVector<uint32_t> d_regex_eol_bits;
+};
+
+
+#endif  // PATTERNFILTER_H
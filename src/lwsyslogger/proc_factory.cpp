@@ -19,6 +19,7 @@
 //
 
 #include "proc_filebyhostname.h"
+#include "proc_indexedstore.h"
 #include "proc_sendmail.h"
 #include "proc_simplefile.h"
 #include "proc_udp.h"
@@ -45,6 +46,10 @@ Processor *ProcessorFactory(Processor::Type type,const QString &id,Profile *p,
     proc=new ProcUdp(id,p,parent);
     break;
 
+  case Processor::TypeIndexedStore:
+    proc=new ProcIndexedStore(id,p,parent);
+    break;
+
   case Processor::TypeLast:
     break;
   }
@@ -24,7 +24,7 @@ ProcFileByHostname::ProcFileByHostname(const QString &id,Profile *p,
 				       QObject *parent)
   : Processor(id,p,parent)
 {
-  QStringList values=p->stringValues("Processor",id,"BaseDirname");
+  QStringList values=configSection()->stringValues("BaseDirname");
   if(values.isEmpty()) {
     fprintf(stderr,"lwsyslogger: missing BaseDirname in processor %s\n",
 	    id.toUtf8().constData());
@@ -38,6 +38,21 @@ ProcFileByHostname::ProcFileByHostname(const QString &id,Profile *p,
   }
   lsyslog(Message::SeverityDebug,"using base_dir \"%s\"",
 	  d_base_dir->path().toUtf8().constData());
+
+  d_open_files_gauge=Metrics::gauge("processor",id,"open_files",
+				    "Logfiles currently held open");
+  d_open_files_gauge->set(0);
+}
+
+
+ProcFileByHostname::~ProcFileByHostname()
+{
+  for(QMap<QString,LogFile *>::const_iterator it=d_files.begin();
+      it!=d_files.end();it++) {
+    delete it.value();
+  }
+  d_open_files_gauge->set(0);
+  delete d_base_dir;
 }
 
 
@@ -55,27 +70,40 @@ bool ProcFileByHostname::start(QString *err_msg)
 
 void ProcFileByHostname::rotateLogs(const QDateTime &now)
 {
-  for(QMap<QString,FILE *>::const_iterator it=d_files.begin();it!=d_files.end();
-      it++) {
-    fclose(it.value());
-  }
-  d_files.clear();
-  QStringList filenames=d_base_dir->entryList(QDir::Files);
+  //
+  // Open files are renamed in place; their handles are closed by
+  // reopenLogFile() once the rename is complete.
+  //
+  QDir dir(d_base_dir->path());
+  QStringList filenames=dir.entryList(QDir::Files);
   for(int i=0;i<filenames.size();i++) {
     if(filenames.at(i).contains("-")) {
-      expireLogFile(d_base_dir->path()+"/"+filenames.at(i),now);
+      expireLogFile(dir.path()+"/"+filenames.at(i),now);
     }
     else {
-      rotateLogFile(d_base_dir->path()+"/"+filenames.at(i),now);
+      rotateLogFile(dir.path()+"/"+filenames.at(i),now);
     }
   }
 }
 
 
+void ProcFileByHostname::reopenLogFile(const QString &pathname)
+{
+  LogFile *logfile=d_files.value(pathname);
+
+  if(logfile!=NULL) {
+    delete logfile;
+    d_files.remove(pathname);
+    d_open_files_gauge->set(d_files.size());
+  }
+}
+
+
 void ProcFileByHostname::processMessage(Message *msg,
 					const QHostAddress &from_addr)
 {
-  FILE *f=NULL;
+  LogFile *logfile=NULL;
+  QString err_msg;
   QString hostname=msg->hostName();
   if(msg->hostName().isEmpty()) {
     hostname=from_addr.toString();
@@ -86,15 +114,26 @@ void ProcFileByHostname::processMessage(Message *msg,
   }
   hostname.replace("-","_");
   QString pathname=d_base_dir->path()+"/"+hostname;
-  if((f=d_files.value(pathname))==NULL) {
-    if((f=fopen(pathname.toUtf8(),"w"))==NULL) {
+  if((logfile=d_files.value(pathname))==NULL) {
+    logfile=new LogFile(pathname);
+    if(!logfile->open(&err_msg)) {
       lsyslog(Message::SeverityWarning,"failed to open file \"%s\" [%s]",
-	      pathname.toUtf8().constData(),strerror(errno));
+	      pathname.toUtf8().constData(),err_msg.toUtf8().constData());
+      delete logfile;
       return;
     }
-    d_files[pathname]=f;
+    d_files[pathname]=logfile;
+    d_open_files_gauge->set(d_files.size());
+  }
+  QByteArray data=
+    msg->resolveWildcards(messageTemplate(),from_addr).toUtf8()+"\n";
+  int64_t prior_size=logfile->size();
+  bool ok=logfile->write(data);
+  countWrite(ok,data.size());
+  if(ok) {
+    recordWritten(msg->receiveTime());
+    addFilterKeys(pathname,prior_size,msg);
+    addIndexLines(pathname,prior_size,data);
+    rotateLogFileBySize(logfile);
   }
-  fprintf(f,"%s\n",msg->resolveWildcards(messageTemplate(),from_addr).
-	  toUtf8().constData());
-  fflush(f);
 }
@@ -30,16 +30,19 @@ class ProcFileByHostname : public Processor
   Q_OBJECT
  public:
   ProcFileByHostname(const QString &id,Profile *p,QObject *parent=0);
+  ~ProcFileByHostname();
   Processor::Type type() const;
   bool start(QString *err_msg);
   void rotateLogs(const QDateTime &now);
 
  protected:
   void processMessage(Message *msg,const QHostAddress &from_addr);
+  void reopenLogFile(const QString &pathname);
 
  private:
   QDir *d_base_dir;
-  QMap<QString,FILE *> d_files;
+  QMap<QString,LogFile *> d_files;
+  MetricsGauge *d_open_files_gauge;
 };
 
 
@@ -0,0 +1,383 @@
+// proc_indexedstore.cpp
+//
+// Processor for logging to indexed binary segments.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <string.h>
+#include <unistd.h>
+
+#include <QFile>
+
+#include "proc_indexedstore.h"
+
+ProcIndexedStore::ProcIndexedStore(const QString &id,Profile *p,
+				   QObject *parent)
+  : Processor(id,p,parent)
+{
+  d_segment_file=NULL;
+  d_index_file=NULL;
+  d_last_bucket=-1;
+
+  QStringList values=configSection()->stringValues("BaseDirname");
+  if(values.isEmpty()) {
+    fprintf(stderr,"lwsyslogger: missing BaseDirname in processor %s\n",
+	    id.toUtf8().constData());
+    exit(1);
+  }
+  d_base_dir=new QDir(logRootDirectory()->path()+"/"+values.last());
+  if(!d_base_dir->exists()) {
+    fprintf(stderr,"lwsyslogger: directory \"%s\" does not exist\n",
+	    d_base_dir->path().toUtf8().constData());
+    exit(1);
+  }
+  lsyslog(Message::SeverityDebug,"using base_dir \"%s\"",
+	  d_base_dir->path().toUtf8().constData());
+
+  //
+  // Segments are closed and a new one started as soon as they reach
+  // LogRotationSize. Rotated segments are read in place by query tools,
+  // so they can't be compressed.
+  //
+  d_segment_size=logRotationSize();
+  if(d_segment_size<=0) {
+    d_segment_size=PROC_INDEXEDSTORE_DEFAULT_SEGMENT_SIZE;
+  }
+  if(rotationCompression()!=Processor::CompressionNone) {
+    fprintf(stderr,"lwsyslogger: RotationCompression is not supported "
+	    "by IndexedStore processor %s\n",id.toUtf8().constData());
+    exit(1);
+  }
+
+  d_index_interval=PROC_INDEXEDSTORE_DEFAULT_INDEX_INTERVAL;
+  QList<int> ivalues=configSection()->intValues("IndexInterval");
+  if(!ivalues.isEmpty()) {
+    d_index_interval=ivalues.last();
+  }
+  if(d_index_interval<1) {
+    fprintf(stderr,"lwsyslogger: invalid IndexInterval in processor %s\n",
+	    id.toUtf8().constData());
+    exit(1);
+  }
+  lsyslog(Message::SeverityDebug,
+	  "segment size %ld bytes, index interval %d seconds",
+	  d_segment_size,d_index_interval);
+
+  connect(this,SIGNAL(sealRequested()),this,SLOT(sealData()),
+	  Qt::QueuedConnection);
+}
+
+
+ProcIndexedStore::~ProcIndexedStore()
+{
+  CloseSegment();
+  delete d_base_dir;
+}
+
+
+Processor::Type ProcIndexedStore::type() const
+{
+  return Processor::TypeIndexedStore;
+}
+
+
+bool ProcIndexedStore::start(QString *err_msg)
+{
+  if(dryRun()) {
+    return true;
+  }
+  return OpenSegment(err_msg);
+}
+
+
+void ProcIndexedStore::rotateLogs(const QDateTime &now)
+{
+  QString active_pathname;
+  QDateTime started;
+
+  d_segment_mutex.lock();
+  active_pathname=d_segment_pathname;
+  started=d_segment_started;
+  d_segment_mutex.unlock();
+
+  //
+  // Close out the active segment if it has reached LogRotationAge. The
+  // segment belongs to the processor's thread, so that's where it has
+  // to be done.
+  //
+  if((!active_pathname.isEmpty())&&(logRotationAge()>0)&&
+     (started<now.addDays(-logRotationAge()))) {
+    if(dryRun()) {
+      printf("Processor %s: would close segment \"%s\"\n",
+	     id().toUtf8().constData(),active_pathname.toUtf8().constData());
+    }
+    else {
+      emit sealRequested();
+    }
+  }
+
+  //
+  // Delete Expired Segments
+  //
+  QDir dir(d_base_dir->path());
+  QStringList name_filters;
+  name_filters.push_back(QString("*")+STORE_SEGMENT_SUFFIX);
+  QStringList filenames=dir.entryList(name_filters,QDir::Files);
+  for(int i=0;i<filenames.size();i++) {
+    QString pathname=dir.path()+"/"+filenames.at(i);
+    if(pathname!=active_pathname) {
+      if(expireLogFile(pathname,now)) {
+	QFile::remove(ProcIndexedStore::indexPathname(pathname));
+      }
+    }
+  }
+}
+
+
+QString ProcIndexedStore::indexPathname(const QString &segment_pathname)
+{
+  QString ret=segment_pathname;
+
+  if(ret.endsWith(STORE_SEGMENT_SUFFIX)) {
+    ret=ret.left(ret.length()-strlen(STORE_SEGMENT_SUFFIX));
+  }
+
+  return ret+STORE_INDEX_SUFFIX;
+}
+
+
+void ProcIndexedStore::processMessage(Message *msg,
+				      const QHostAddress &from_addr)
+{
+  QString err_msg;
+  StoreRecordHeader hdr;
+
+  if((d_segment_file==NULL)&&(!OpenSegment(&err_msg))) {
+    lsyslog(Message::SeverityWarning,"failed to open segment in \"%s\" [%s]",
+	    d_base_dir->path().toUtf8().constData(),
+	    err_msg.toUtf8().constData());
+    countWrite(false,0);
+    return;
+  }
+
+  int64_t timestamp=msg->receiveTime();
+  if(timestamp<=0) {
+    timestamp=Metrics::realtimeNsec();
+  }
+  timestamp/=1000;
+  QString hostname=msg->hostName();
+  if(hostname.isEmpty()) {
+    hostname=from_addr.toString();
+  }
+  QByteArray payload=msg->toByteArray(1);
+
+  memset(&hdr,0,sizeof(hdr));
+  hdr.length=payload.size();
+  if((hdr.host_id=HostId(hostname))==0) {
+    countWrite(false,0);  // No name record for it, so drop the message
+    return;
+  }
+  hdr.timestamp=timestamp;
+  hdr.facility=msg->facility();
+  hdr.severity=msg->severity();
+  hdr.msg_offset=payload.size()-msg->msg().toUtf8().size();
+
+  //
+  // Sparse Time Index
+  //
+  // One entry per bucket, pointing at the first record that falls in it.
+  //
+  int64_t bucket=timestamp/(1000000ll*d_index_interval);
+  if(bucket>d_last_bucket) {
+    StoreIndexEntry entry;
+    memset(&entry,0,sizeof(entry));
+    entry.type=STORE_INDEX_BUCKET;
+    entry.timestamp=timestamp;
+    entry.offset=d_segment_file->size();
+    if(WriteIndexEntry(entry,QByteArray())) {
+      d_last_bucket=bucket;
+    }
+    else {
+      countWrite(false,0);
+    }
+  }
+
+  QByteArray data((const char *)(&hdr),sizeof(hdr));
+  data+=payload;
+  int64_t start=d_segment_file->size();
+  bool ok=d_segment_file->write(data);
+  countWrite(ok,data.size());
+  if(!ok) {
+    //
+    // Don't leave a partial record behind, as readers walk the segment
+    // record by record from the header lengths.
+    //
+    if(!d_segment_file->truncate(start)) {
+      lsyslog(Message::SeverityWarning,
+	      "failed to truncate segment \"%s\" after a short write",
+	      d_segment_file->pathname().toUtf8().constData());
+      sealData();
+    }
+  }
+  else {
+    recordWritten(msg->receiveTime());
+    if(d_segment_file->size()>=d_segment_size) {
+      sealData();
+    }
+  }
+}
+
+
+void ProcIndexedStore::sealData()
+{
+  QString err_msg;
+
+  if(d_segment_file==NULL) {
+    return;
+  }
+  CloseSegment();
+  if(!OpenSegment(&err_msg)) {
+    lsyslog(Message::SeverityWarning,"failed to open segment in \"%s\" [%s]",
+	    d_base_dir->path().toUtf8().constData(),
+	    err_msg.toUtf8().constData());
+  }
+}
+
+
+bool ProcIndexedStore::OpenSegment(QString *err_msg)
+{
+  StoreFileHeader hdr;
+  QDateTime now=QDateTime::currentDateTime();
+
+  //
+  // Segments are named for the time they were started
+  //
+  QString base=d_base_dir->path()+"/"+now.toString("yyyyMMdd-hhmmss");
+  QString pathname=base+STORE_SEGMENT_SUFFIX;
+  for(int i=1;QFile::exists(pathname);i++) {
+    if(i>=PROCESSOR_MAX_ROTATION_SUFFIX) {
+      *err_msg=tr("no free segment name available");
+      return false;
+    }
+    pathname=base+QString::asprintf("-%d",i)+STORE_SEGMENT_SUFFIX;
+  }
+  LogFile *segment=new LogFile(pathname,true);
+  LogFile *index=new LogFile(ProcIndexedStore::indexPathname(pathname),true);
+  if((!segment->open(err_msg))||(!index->open(err_msg))) {
+    delete segment;
+    delete index;
+    return false;
+  }
+
+  memset(&hdr,0,sizeof(hdr));
+  memcpy(hdr.magic,STORE_SEGMENT_MAGIC,sizeof(hdr.magic));
+  hdr.version=STORE_FORMAT_VERSION;
+  hdr.created=1000*now.toMSecsSinceEpoch();
+  bool ok=segment->write(QByteArray((const char *)(&hdr),sizeof(hdr)));
+  memcpy(hdr.magic,STORE_INDEX_MAGIC,sizeof(hdr.magic));
+  hdr.bucket_interval=d_index_interval;
+  ok=ok&&index->write(QByteArray((const char *)(&hdr),sizeof(hdr)));
+  if(!ok) {
+    *err_msg=tr("unable to write file header");
+    delete segment;
+    delete index;
+    unlink(pathname.toUtf8());
+    unlink(ProcIndexedStore::indexPathname(pathname).toUtf8());
+    return false;
+  }
+
+  d_segment_file=segment;
+  d_index_file=index;
+  d_host_ids.clear();
+  d_last_bucket=-1;
+  d_segment_mutex.lock();
+  d_segment_pathname=pathname;
+  d_segment_started=now;
+  d_segment_mutex.unlock();
+  lsyslog(Message::SeverityDebug,"started segment \"%s\"",
+	  pathname.toUtf8().constData());
+
+  return true;
+}
+
+
+void ProcIndexedStore::CloseSegment()
+{
+  if(d_segment_file!=NULL) {
+    lsyslog(Message::SeverityDebug,"closed segment \"%s\"",
+	    d_segment_file->pathname().toUtf8().constData());
+    delete d_segment_file;
+    d_segment_file=NULL;
+  }
+  if(d_index_file!=NULL) {
+    delete d_index_file;
+    d_index_file=NULL;
+  }
+  d_segment_mutex.lock();
+  d_segment_pathname=QString();
+  d_segment_mutex.unlock();
+}
+
+
+uint32_t ProcIndexedStore::HostId(const QString &hostname)
+{
+  QHash<QString,uint32_t>::const_iterator it=d_host_ids.find(hostname);
+  if(it!=d_host_ids.end()) {
+    return it.value();
+  }
+
+  //
+  // Zero is never used as an ID, and is returned if the name can't be
+  // written
+  //
+  uint32_t id=d_host_ids.size()+1;
+  QByteArray name=hostname.toUtf8().left(0xFFFF);
+  StoreIndexEntry entry;
+  memset(&entry,0,sizeof(entry));
+  entry.type=STORE_INDEX_HOST;
+  entry.length=name.size();
+  entry.host_id=id;
+  if(!WriteIndexEntry(entry,name)) {
+    return 0;
+  }
+  d_host_ids[hostname]=id;
+
+  return id;
+}
+
+
+bool ProcIndexedStore::WriteIndexEntry(const StoreIndexEntry &entry,
+				       const QByteArray &name)
+{
+  QByteArray data((const char *)(&entry),sizeof(entry));
+  int64_t start=d_index_file->size();
+
+  data+=name;
+  if(!d_index_file->write(data)) {
+    //
+    // As for the segment, readers must never meet a torn entry
+    //
+    if(!d_index_file->truncate(start)) {
+      lsyslog(Message::SeverityWarning,
+	      "failed to truncate index \"%s\" after a short write",
+	      d_index_file->pathname().toUtf8().constData());
+    }
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,75 @@
+// proc_indexedstore.h
+//
+// Processor for logging to indexed binary segments.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef PROC_INDEXEDSTORE_H
+#define PROC_INDEXEDSTORE_H
+
+#include <QDir>
+#include <QHash>
+#include <QMutex>
+
+#include "processor.h"
+#include "storeformat.h"
+
+//
+// Defaults
+//
+#define PROC_INDEXEDSTORE_DEFAULT_SEGMENT_SIZE 67108864
+#define PROC_INDEXEDSTORE_DEFAULT_INDEX_INTERVAL 60
+
+class ProcIndexedStore : public Processor
+{
+  Q_OBJECT
+ public:
+  ProcIndexedStore(const QString &id,Profile *p,QObject *parent);
+  ~ProcIndexedStore();
+  Processor::Type type() const;
+  bool start(QString *err_msg);
+  void rotateLogs(const QDateTime &now);
+  static QString indexPathname(const QString &segment_pathname);
+
+ signals:
+  void sealRequested();
+
+ protected:
+  void processMessage(Message *msg,const QHostAddress &from_addr);
+
+ private slots:
+  void sealData();
+
+ private:
+  bool OpenSegment(QString *err_msg);
+  void CloseSegment();
+  uint32_t HostId(const QString &hostname);
+  bool WriteIndexEntry(const StoreIndexEntry &entry,const QByteArray &name);
+  QDir *d_base_dir;
+  int64_t d_segment_size;
+  int d_index_interval;
+  LogFile *d_segment_file;
+  LogFile *d_index_file;
+  QHash<QString,uint32_t> d_host_ids;
+  int64_t d_last_bucket;
+  QMutex d_segment_mutex;
+  QString d_segment_pathname;
+  QDateTime d_segment_started;
+};
+
+
+#endif  // PROC_INDEXEDSTORE_H
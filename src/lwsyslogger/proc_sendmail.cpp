@@ -24,7 +24,7 @@
 ProcSendmail::ProcSendmail(const QString &id,Profile *p,QObject *parent)
   : Processor(id,p,parent)
 {
-  QStringList strings=p->stringValues("Processor",id,"EmailFromAddress");
+  QStringList strings=configSection()->stringValues("EmailFromAddress");
   if(strings.isEmpty()) {
     fprintf(stderr,"lwsyslogger: missing FromAddress in processor %s\n",
 	    id.toUtf8().constData());
@@ -32,7 +32,7 @@ ProcSendmail::ProcSendmail(const QString &id,Profile *p,QObject *parent)
   }
   d_from_address=strings.last();
 
-  d_to_addresses=p->stringValues("Processor",id,"EmailToAddress");
+  d_to_addresses=configSection()->stringValues("EmailToAddress");
   if(d_to_addresses.isEmpty()) {
     fprintf(stderr,"lwsyslogger: missing ToAddress in processor %s\n",
 	    id.toUtf8().constData());
@@ -40,7 +40,7 @@ ProcSendmail::ProcSendmail(const QString &id,Profile *p,QObject *parent)
   }
 
   d_subject_line=QObject::tr("Syslog Alert");
-  strings=p->stringValues("Processor",id,"EmailSubjectLine");
+  strings=configSection()->stringValues("EmailSubjectLine");
   if(!strings.isEmpty()) {
     d_subject_line=strings.last();  
   }
@@ -49,17 +49,24 @@ ProcSendmail::ProcSendmail(const QString &id,Profile *p,QObject *parent)
   // Throttling Parameters
   //
   d_throttle_limit=0;
-  QList<int> ints=p->intValues("Processor",id,"EmailThrottleLimit");
+  QList<int> ints=configSection()->intValues("EmailThrottleLimit");
   if(!ints.isEmpty()) {
     d_throttle_limit=ints.last();
   }
 
   d_throttle_period=0;
-  ints=p->intValues("Processor",id,"EmailThrottlePeriod");
+  ints=configSection()->intValues("EmailThrottlePeriod");
   if(!ints.isEmpty()) {
     d_throttle_period=ints.last();
   }
 
+  d_sent_counter=Metrics::counter("processor",id,"mail_sent",
+				  "Mail messages sent");
+  d_throttled_counter=Metrics::counter("processor",id,"mail_throttled",
+				       "Mail messages suppressed by throttling");
+  d_failures_counter=Metrics::counter("processor",id,"mail_failures",
+				      "Mail messages that failed to send");
+
   d_throttle_timer=new QTimer(this);
   d_throttle_timer->setSingleShot(true);
   connect(d_throttle_timer,SIGNAL(timeout()),this,SLOT(throttleTimeoutData()));
@@ -101,15 +108,21 @@ void ProcSendmail::processMessage(Message *msg,const QHostAddress &from_addr)
       }
     }
     if(d_throttle_counter>d_throttle_limit) {
+      d_throttled_counter->increment();
       return;
     }
   }
   QString subj=msg->resolveWildcards(d_subject_line,from_addr);
   QString body=msg->resolveWildcards(messageTemplate(),from_addr);
   if(!SendMail(&err_msg,subj,body,d_from_address,d_to_addresses)) {
+    d_failures_counter->increment();
     lsyslog(Message::SeverityWarning,"sendmail failed [%s]",
 	    err_msg.toUtf8().constData());
   }
+  else {
+    d_sent_counter->increment();
+    recordWritten(msg->receiveTime());
+  }
 }
 
 
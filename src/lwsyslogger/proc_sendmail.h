@@ -45,6 +45,9 @@ class ProcSendmail : public Processor
   int d_throttle_limit;
   int d_throttle_counter;
   QTimer *d_throttle_timer;
+  MetricsCounter *d_sent_counter;
+  MetricsCounter *d_throttled_counter;
+  MetricsCounter *d_failures_counter;
 };
 
 
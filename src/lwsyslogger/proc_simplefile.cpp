@@ -23,13 +23,15 @@
 #include <unistd.h>
 #include <sys/types.h>
 
+#include <QTimer>
+
 #include "local_syslog.h"
 #include "proc_simplefile.h"
 
 ProcSimpleFile::ProcSimpleFile(const QString &id,Profile *p,QObject *parent)
   : Processor(id,p,parent)
 {
-  QStringList values=p->stringValues("Processor",id,"BaseFilename");
+  QStringList values=configSection()->stringValues("BaseFilename");
   if(values.isEmpty()) {
     fprintf(stderr,"lwsyslogger: missing BaseFilename in processor %s\n",
 	    id.toUtf8().constData());
@@ -47,7 +49,98 @@ ProcSimpleFile::ProcSimpleFile(const QString &id,Profile *p,QObject *parent)
   }
   lsyslog(Message::SeverityDebug,"using base_dir \"%s\"",
 	  d_base_dir->path().toUtf8().constData());
-  d_base_file=NULL;
+
+  //
+  // Output Batching
+  //
+  d_flush_interval=0;  // Default value
+  QList<int> ivalues=configSection()->intValues("FlushInterval");
+  if(!ivalues.isEmpty()) {
+    d_flush_interval=ivalues.last();
+  }
+
+  //
+  // Live Compression
+  //
+  int zstd_level=0;  // Default value
+  values=configSection()->stringValues("OutputCompression");
+  if(!values.isEmpty()) {
+    bool ok=false;
+    int level=3;  // Default value
+    QStringList f1=values.last().split(":",Qt::KeepEmptyParts);
+    Processor::Compression comp=Processor::compressionFromString(f1.at(0));
+    if((comp!=Processor::CompressionNone)&&
+       (comp!=Processor::CompressionZstd)) {
+      fprintf(stderr,
+       "lwsyslogger: unsupported OutputCompression \"%s\" in processor %s\n",
+	      values.last().toUtf8().constData(),id.toUtf8().constData());
+      exit(1);
+    }
+    if(f1.size()==2) {
+      level=f1.at(1).toInt(&ok);
+      if((!ok)||(level<1)||(level>19)) {
+	fprintf(stderr,
+	"lwsyslogger: invalid OutputCompression level \"%s\" in processor %s\n",
+		values.last().toUtf8().constData(),id.toUtf8().constData());
+	exit(1);
+      }
+    }
+    if(comp==Processor::CompressionZstd) {
+      if(!LogFile::zstdSupported()) {
+	fprintf(stderr,
+		"lwsyslogger: zstd support not available in processor %s\n",
+		id.toUtf8().constData());
+	exit(1);
+      }
+      if(rotationCompression()!=Processor::CompressionNone) {
+	fprintf(stderr,"lwsyslogger: OutputCompression and RotationCompression "
+		"cannot both be set in processor %s\n",
+		id.toUtf8().constData());
+	exit(1);
+      }
+      QList<bool> bools=configSection()->boolValues("TrigramIndex");
+      if((!bools.isEmpty())&&bools.last()) {
+	fprintf(stderr,"lwsyslogger: OutputCompression and TrigramIndex "
+		"cannot both be set in processor %s\n",
+		id.toUtf8().constData());
+	exit(1);
+      }
+
+      //
+      // One batch becomes one frame, so per-message frames would
+      // compress poorly.
+      //
+      if(d_flush_interval<=0) {
+	d_flush_interval=PROC_SIMPLEFILE_DEFAULT_COMPRESSED_FLUSH_INTERVAL;
+      }
+      zstd_level=level;
+
+      //
+      // So that it is recognized as compressed, both live and once rotated
+      //
+      d_base_pathname+=Processor::compressionSuffix(comp);
+      lsyslog(Message::SeverityDebug,"writing zstd frames at level %d",level);
+    }
+  }
+  d_base_file=new LogFile(d_base_pathname);
+  d_base_file->setZstdLevel(zstd_level);
+  if(d_flush_interval>0) {
+    d_base_file->setBuffered(true);
+    lsyslog(Message::SeverityDebug,"flushing output every %d ms",
+	    d_flush_interval);
+  }
+  d_flush_timer=new QTimer(this);
+  d_flush_timer->setSingleShot(true);
+  connect(d_flush_timer,SIGNAL(timeout()),this,SLOT(flushData()));
+}
+
+
+ProcSimpleFile::~ProcSimpleFile()
+{
+  delete d_base_file;
+  if(d_base_dir!=logRootDirectory()) {
+    delete d_base_dir;
+  }
 }
 
 
@@ -64,24 +157,35 @@ void ProcSimpleFile::rotateLogs(const QDateTime &now)
   //
   // Rotate Base File
   //
-  if(d_base_file!=NULL) {
-    fclose(d_base_file);
-    d_base_file=NULL;
-  }
+  // The base file stays open while it is renamed, so messages logged in
+  // the meantime land in the rotated file. The handle is swapped by
+  // reopenLogFile() once the rename is complete.
+  //
   rotateLogFile(d_base_pathname,now);
-  if((d_base_file=fopen(d_base_pathname.toUtf8(),"a"))==NULL) {
-    lsyslog(Message::SeverityWarning,"failed to reopen logfile %s [%s]",
-	    d_base_pathname.toUtf8().constData(),strerror(errno));
-  }
 
   //
   // Delete Expired Files
   //
+  QDir dir(d_base_dir->path());
   QStringList name_filters;
   name_filters.push_back(d_base_filename+"-*");
-  QStringList filenames=d_base_dir->entryList(name_filters,QDir::Files);
+  QStringList filenames=dir.entryList(name_filters,QDir::Files);
   for(int i=0;i<filenames.size();i++) {
-    expireLogFile(d_base_dir->path()+"/"+filenames.at(i),now);
+    expireLogFile(dir.path()+"/"+filenames.at(i),now);
+  }
+}
+
+
+void ProcSimpleFile::reopenLogFile(const QString &pathname)
+{
+  QString err_msg;
+
+  if(pathname!=d_base_pathname) {
+    return;
+  }
+  if(!d_base_file->reopen(&err_msg)) {
+    lsyslog(Message::SeverityWarning,"failed to reopen logfile %s [%s]",
+	    d_base_pathname.toUtf8().constData(),err_msg.toUtf8().constData());
   }
 }
 
@@ -90,13 +194,45 @@ void ProcSimpleFile::processMessage(Message *msg,const QHostAddress &from_addr)
 {
   //  printf("MSG: %s\n",msg->dump().toUtf8().constData());
   
-  if(d_base_file==NULL) {
-    d_base_file=fopen(d_base_pathname.toUtf8(),"a");
+  QByteArray data=
+    msg->resolveWildcards(messageTemplate(),from_addr).toUtf8()+"\n";
+  int64_t prior_size=d_base_file->size();
+  bool ok=d_base_file->write(data);
+  countWrite(ok,data.size());
+  if(ok) {
+    addFilterKeys(d_base_pathname,prior_size,msg);
+    addIndexLines(d_base_pathname,prior_size,data);
+
+    //
+    // Buffered messages count as written once their batch is flushed
+    //
+    if(msg->receiveTime()>0) {
+      d_pending_receive_times.push_back(msg->receiveTime());
+    }
+    if(!d_base_file->hasPendingData()) {
+      RecordPendingWrites();
+    }
+    rotateLogFileBySize(d_base_file);
   }
-  if(d_base_file!=NULL) {
-    fprintf(d_base_file,"%s\n",
-	    msg->resolveWildcards(messageTemplate(),from_addr).
-	    toUtf8().constData());
-    fflush(d_base_file);
+  if(d_base_file->isBuffered()&&(!d_flush_timer->isActive())) {
+    d_flush_timer->start(d_flush_interval);
+  }
+}
+
+
+void ProcSimpleFile::flushData()
+{
+  if(d_base_file->flush()) {
+    RecordPendingWrites();
+    rotateLogFileBySize(d_base_file);
+  }
+}
+
+
+void ProcSimpleFile::RecordPendingWrites()
+{
+  for(int i=0;i<d_pending_receive_times.size();i++) {
+    recordWritten(d_pending_receive_times.at(i));
   }
+  d_pending_receive_times.clear();
 }
@@ -25,22 +25,36 @@
 
 #include "processor.h"
 
+//
+// Defaults
+//
+#define PROC_SIMPLEFILE_DEFAULT_COMPRESSED_FLUSH_INTERVAL 1000
+
 class ProcSimpleFile : public Processor
 {
   Q_OBJECT
  public:
   ProcSimpleFile(const QString &id,Profile *p,QObject *parent);
+  ~ProcSimpleFile();
   Processor::Type type() const;
   void rotateLogs(const QDateTime &now);
 
  protected:
   void processMessage(Message *msg,const QHostAddress &from_addr);
+  void reopenLogFile(const QString &pathname);
+
+ private slots:
+  void flushData();
 
  private:
+  void RecordPendingWrites();
   QString d_base_pathname;
   QString d_base_filename;
   QDir *d_base_dir;
-  FILE *d_base_file;
+  LogFile *d_base_file;
+  int d_flush_interval;
+  QTimer *d_flush_timer;
+  QList<int64_t> d_pending_receive_times;
 };
 
 
@@ -25,7 +25,7 @@ ProcUdp::ProcUdp(const QString &id,Profile *p,QObject *parent)
 {
   bool ok=false;
   
-  QStringList strings=p->stringValues("Processor",id,"DestinationAddress");
+  QStringList strings=configSection()->stringValues("DestinationAddress");
   if(strings.isEmpty()) {
     fprintf(stderr,"lwsyslogger: missing parameter \"DestinationAddress\"\n");
     exit(1);
@@ -57,6 +57,11 @@ ProcUdp::ProcUdp(const QString &id,Profile *p,QObject *parent)
   }
   
   d_send_socket=new QUdpSocket(this);
+
+  d_sent_counter=Metrics::counter("processor",id,"datagrams_sent",
+				  "Datagrams forwarded");
+  d_send_errors_counter=Metrics::counter("processor",id,"send_errors",
+					 "Datagrams that failed to send");
 }
 
 
@@ -68,9 +73,20 @@ Processor::Type ProcUdp::type() const
 
 void ProcUdp::processMessage(Message *msg,const QHostAddress &from_addr)
 {
+  bool sent=false;
+
   for(int i=0;i<d_destination_addresses.size();i++) {
-    d_send_socket->writeDatagram(msg->toByteArray(msg->version()),
-				 d_destination_addresses.at(i),
-				 d_destination_ports.at(i));
+    if(d_send_socket->writeDatagram(msg->toByteArray(msg->version()),
+				    d_destination_addresses.at(i),
+				    d_destination_ports.at(i))<0) {
+      d_send_errors_counter->increment();
+    }
+    else {
+      d_sent_counter->increment();
+      sent=true;
+    }
+  }
+  if(sent) {
+    recordWritten(msg->receiveTime());
   }
 }
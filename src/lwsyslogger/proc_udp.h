@@ -41,6 +41,8 @@ class ProcUdp : public Processor
   QList<QHostAddress> d_destination_addresses;
   QList<uint16_t> d_destination_ports;
   QUdpSocket *d_send_socket;
+  MetricsCounter *d_sent_counter;
+  MetricsCounter *d_send_errors_counter;
 };
 
 
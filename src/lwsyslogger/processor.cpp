@@ -18,12 +18,20 @@
 //   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 //
 
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
+#include <sys/stat.h>
 
+#include <QCoreApplication>
 #include <QFile>
 #include <QFileInfo>
 
+#include "archivewriter.h"
+#include "childprocess.h"
 #include "local_syslog.h"
 #include "processor.h"
 
@@ -36,10 +44,44 @@ Processor::Processor(const QString &id,Profile *p,QObject *parent)
   
   d_id=id;
   d_profile=p;
+  d_config_section=p->section("Processor",id);
   d_dry_run=false;
+  d_retire_passes=0;
   d_address_filter=new AddressFilter();
+  d_host_name_filter=new FieldFilter(true);
+  d_app_name_filter=new FieldFilter();
+  d_msg_id_filter=new FieldFilter();
+  d_pattern_filter=new PatternFilter();
   d_deduplication_timeout=0;
   d_last_message_count=0;
+
+  //
+  // Metrics
+  //
+  d_received_counter=Metrics::counter("processor",id,"messages_received",
+				      "Messages presented to the processor");
+  d_filtered_counter=Metrics::counter("processor",id,"messages_filtered",
+			 "Messages discarded by the processor's filters");
+  d_deduplicated_counter=Metrics::counter("processor",id,
+					  "messages_deduplicated",
+			 "Messages suppressed as duplicates of the previous one");
+  d_bytes_written_counter=Metrics::counter("processor",id,"bytes_written",
+					   "Bytes of output written");
+  d_write_errors_counter=Metrics::counter("processor",id,"write_errors",
+					  "Failed output writes");
+  d_processing_histogram=Metrics::histogram("processor",id,
+					    "processing_seconds",
+				   "Time taken to process a single message");
+  d_dispatch_histogram=Metrics::histogram("processor",id,
+					  "dispatch_latency_seconds",
+		 "Time from kernel receipt until handed to the processor");
+  d_written_histogram=Metrics::histogram("processor",id,
+					 "write_latency_seconds",
+		 "Time from kernel receipt until written out by the processor");
+  d_latency_countdown=PROCESSOR_LATENCY_SAMPLE_INTERVAL;
+  d_written_countdown=PROCESSOR_LATENCY_SAMPLE_INTERVAL;
+  d_maintenance_gauge=Metrics::gauge("processor",id,"maintenance_queue_depth",
+			  "Rotation and compression jobs awaiting completion");
   
   values=p->stringValues("Global","Default","LogRoot");
   if(values.isEmpty()) {
@@ -52,7 +94,7 @@ Processor::Processor(const QString &id,Profile *p,QObject *parent)
   // Override Timestamps
   //
   d_override_timestamps=false;
-  QList<bool> bools=d_profile->boolValues("Processor",id,"OverrideTimestamps");
+  QList<bool> bools=d_config_section->boolValues("OverrideTimestamps");
   if(!bools.isEmpty()) {
     d_override_timestamps=bools.last();
   }
@@ -60,8 +102,8 @@ Processor::Processor(const QString &id,Profile *p,QObject *parent)
   //
   // Facility Values
   //
-  QStringList strings=d_profile->stringValues("Processor",id,"Facility");
-  d_facility_mask=MakeFacilityMask(strings.join(","),&ok,&err_msg);
+  QStringList strings=d_config_section->stringValues("Facility");
+  d_facility_mask=makeFacilityMask(strings.join(","),&ok,&err_msg);
   if(!ok) {
     fprintf(stderr,
 	  "lwsyslogger: invalid facility string \"%s\" for processor \"%s\"\n",
@@ -81,8 +123,8 @@ Processor::Processor(const QString &id,Profile *p,QObject *parent)
   //
   // Severity Values
   //
-  strings=d_profile->stringValues("Processor",id,"Severity");
-  d_severity_mask=MakeSeverityMask(strings.join(","),&ok,&err_msg);
+  strings=d_config_section->stringValues("Severity");
+  d_severity_mask=makeSeverityMask(strings.join(","),&ok,&err_msg);
   if(!ok) {
     fprintf(stderr,
 	  "lwsyslogger: invalid severity string \"%s\" for processor \"%s\"\n",
@@ -102,7 +144,7 @@ Processor::Processor(const QString &id,Profile *p,QObject *parent)
   //
   // Upstream Addresses
   //
-  strings=d_profile->stringValues("Processor",id,"UpstreamAddress");
+  strings=d_config_section->stringValues("UpstreamAddress");
   for(int i=0;i<strings.size();i++) {
     QStringList f0=strings.at(i).split(",",Qt::SkipEmptyParts);
     for(int j=0;j<f0.size();j++) {
@@ -135,27 +177,124 @@ Processor::Processor(const QString &id,Profile *p,QObject *parent)
   lsyslog(Message::SeverityDebug,"processing addresses: %s",
 	  d_address_filter->subnets().toUtf8().constData());
 
+  //
+  // Header Fields
+  //
+  // Hostnames compare without regard to case, as in DNS.
+  //
+  FieldFilter *field_filters[3]=
+    {d_host_name_filter,d_app_name_filter,d_msg_id_filter};
+  const char *field_params[3]={"HostName","AppName","MsgId"};
+  for(int i=0;i<3;i++) {
+    strings=d_config_section->stringValues(field_params[i]);
+    for(int j=0;j<strings.size();j++) {
+      QStringList f0=strings.at(j).split(",",Qt::SkipEmptyParts);
+      for(int k=0;k<f0.size();k++) {
+	if(!field_filters[i]->addPattern(f0.at(k).trimmed(),&err_msg)) {
+	  fprintf(stderr,"lwsyslogger: %s in %s= for processor \"%s\"\n",
+		  err_msg.toUtf8().constData(),field_params[i],
+		  id.toUtf8().constData());
+	  exit(1);
+	}
+      }
+    }
+    field_filters[i]->compile();
+    if(!field_filters[i]->isEmpty()) {
+      lsyslog(Message::SeverityDebug,"processing %s values: %s",
+	      field_params[i],
+	      field_filters[i]->patterns().toUtf8().constData());
+    }
+  }
+
+  //
+  // Message Content
+  //
+  // All patterns are compiled together, so that each message is scanned
+  // once however many there are.
+  //
+  for(int i=0;i<2;i++) {
+    PatternFilter::Kind kind=(PatternFilter::Kind)i;
+    strings=d_config_section->
+      stringValues((kind==PatternFilter::KindMatch)?"MessageMatch":
+		   "MessageExclude");
+    for(int j=0;j<strings.size();j++) {
+      if(!d_pattern_filter->addPattern(kind,strings.at(j),&err_msg)) {
+	fprintf(stderr,"lwsyslogger: %s for processor \"%s\"\n",
+		err_msg.toUtf8().constData(),id.toUtf8().constData());
+	exit(1);
+      }
+    }
+  }
+  if(!d_pattern_filter->compile(&err_msg)) {
+    fprintf(stderr,"lwsyslogger: %s for processor \"%s\"\n",
+	    err_msg.toUtf8().constData(),id.toUtf8().constData());
+    exit(1);
+  }
+  if(!d_pattern_filter->isEmpty()) {
+    lsyslog(Message::SeverityDebug,
+	    "matching messages: %s; excluding messages: %s",
+	    d_pattern_filter->patterns(PatternFilter::KindMatch).
+	    toUtf8().constData(),
+	    d_pattern_filter->patterns(PatternFilter::KindExclude).
+	    toUtf8().constData());
+  }
+
   //
   // Message Template
   //
   d_message_template="%t %h %m";
-  values=p->stringValues("Processor",id,"Template");
+  values=d_config_section->stringValues("Template");
   if(!values.isEmpty()) {
     d_message_template=values.last();
   }
 
+  //
+  // Bloom Filter Sidecars
+  //
+  d_bloom_filter=false;  // Default value
+  bools=d_config_section->boolValues("BloomFilter");
+  if(!bools.isEmpty()) {
+    d_bloom_filter=bools.last();
+  }
+  d_bloom_filter_tokens=false;  // Default value
+  bools=d_config_section->boolValues("BloomFilterTokens");
+  if(!bools.isEmpty()) {
+    d_bloom_filter_tokens=bools.last();
+  }
+
+  //
+  // Trigram Index
+  //
+  bool trigram_index=false;  // Default value
+  bools=d_config_section->boolValues("TrigramIndex");
+  if(!bools.isEmpty()) {
+    trigram_index=bools.last();
+  }
+  int64_t trigram_index_size=TRIGRAMINDEX_DEFAULT_MAX_SIZE;  // Default value
+  QList<int> ivalues=d_config_section->intValues("TrigramIndexSize");
+  if(!ivalues.isEmpty()) {
+    trigram_index_size=ivalues.last();
+    if(trigram_index_size<=0) {
+      fprintf(stderr,
+	      "lwsyslogger: invalid TrigramIndexSize for processor \"%s\"\n",
+	      d_id.toUtf8().constData());
+      exit(1);
+    }
+  }
+
   //
   // Deduplication Values
   //
   d_deduplication_timeout=0;  // Default value
-  QList<int> ivalues=p->intValues("Processor",id,"DeduplicationTimeout");
+  ivalues=d_config_section->intValues("DeduplicationTimeout");
   if(!ivalues.isEmpty()) {
     d_deduplication_timeout=ivalues.last();
   }
+  d_deduplication_deadline=0;
   d_deduplication_timer=new QTimer(this);
   d_deduplication_timer->setSingleShot(true);
   connect(d_deduplication_timer,SIGNAL(timeout()),
-	  this,SLOT(deduplicationTimeoutData()));
+	  this,SLOT(deduplicationTimerData()));
   lsyslog(Message::SeverityDebug,"DeduplicationTimeout set to %d seconds",
 	  d_deduplication_timeout);
   
@@ -163,22 +302,91 @@ Processor::Processor(const QString &id,Profile *p,QObject *parent)
   // Log Rotation Values
   //
   d_log_rotation_age=0;  // Default value
-  ivalues=p->intValues("Processor",id,"LogRotationAge");
+  ivalues=d_config_section->intValues("LogRotationAge");
   if(!ivalues.isEmpty()) {
     d_log_rotation_age=ivalues.last();
   }
   d_log_rotation_size=0;  // Default value
-  ivalues=p->intValues("Processor",id,"LogRotationSize");
-  if(!ivalues.isEmpty()) {
-    d_log_rotation_size=ivalues.last();
+  QList<int64_t> sizes=d_config_section->int64Values("LogRotationSize");
+  if(!sizes.isEmpty()) {
+    d_log_rotation_size=sizes.last();
+  }
+
+  //
+  // Size token filters for the words expected in one logfile, so that
+  // they don't saturate
+  //
+  d_bloom_filter_bits=BLOOMFILTER_DEFAULT_BITS;
+  d_bloom_filter_memory=0;
+  if(d_bloom_filter_tokens) {
+    uint64_t items=BLOOMFILTER_DEFAULT_TOKEN_ITEMS;
+    if(d_log_rotation_size>0) {
+      items=d_log_rotation_size/BLOOMFILTER_BYTES_PER_TOKEN;
+    }
+    d_bloom_filter_bits=BloomFilter::bitsForItems(items);
+  }
+  d_rotation_compression=Processor::CompressionNone;  // Default value
+  d_rotation_compression_level=-1;  // Default value, the method's own
+  values=d_config_section->stringValues("RotationCompression");
+  if(!values.isEmpty()) {
+    QStringList f0=values.last().split(":",Qt::KeepEmptyParts);
+    d_rotation_compression=Processor::compressionFromString(f0.at(0));
+    if(d_rotation_compression==Processor::CompressionLast) {
+      fprintf(stderr,
+       "lwsyslogger: invalid RotationCompression \"%s\" for processor \"%s\"\n",
+	      values.last().toUtf8().constData(),id.toUtf8().constData());
+      exit(1);
+    }
+    if(f0.size()==2) {
+      int min=1;
+      int max=19;
+      switch(d_rotation_compression) {
+      case Processor::CompressionGzip:
+	max=9;
+	break;
+
+      case Processor::CompressionXz:
+	min=0;
+	max=9;
+	break;
+
+      default:
+	break;
+      }
+      d_rotation_compression_level=f0.at(1).toInt(&ok);
+      if((!ok)||(d_rotation_compression_level<min)||
+	 (d_rotation_compression_level>max)) {
+	fprintf(stderr,
+	  "lwsyslogger: invalid RotationCompression level \"%s\" for processor \"%s\"\n",
+		values.last().toUtf8().constData(),id.toUtf8().constData());
+	exit(1);
+      }
+    }
+    if(f0.size()>2) {
+      fprintf(stderr,
+       "lwsyslogger: invalid RotationCompression \"%s\" for processor \"%s\"\n",
+	      values.last().toUtf8().constData(),id.toUtf8().constData());
+      exit(1);
+    }
+  }
+
+  //
+  // The index holds offsets into the uncompressed file, and the search
+  // tools skip compressed ones.
+  //
+  if(trigram_index&&(d_rotation_compression!=Processor::CompressionNone)) {
+    fprintf(stderr,"lwsyslogger: RotationCompression and TrigramIndex "
+	    "cannot both be set in processor %s\n",
+	    id.toUtf8().constData());
+    exit(1);
   }
   d_old_log_purge_age=0;  // Default value
-  ivalues=p->intValues("Processor",id,"OldLogPurgeAge");
+  ivalues=d_config_section->intValues("OldLogPurgeAge");
   if(!ivalues.isEmpty()) {
     d_old_log_purge_age=ivalues.last();
   }
   d_log_rotation_time=QTime();  // Default value
-  QList<QTime> tvalues=p->timeValues("Processor",id,"LogRotationTime");
+  QList<QTime> tvalues=d_config_section->timeValues("LogRotationTime");
   if(!tvalues.isEmpty()) {
     d_log_rotation_time=tvalues.last();
   }
@@ -188,10 +396,63 @@ Processor::Processor(const QString &id,Profile *p,QObject *parent)
   d_log_rotation_timer=new QTimer(this);
   d_log_rotation_timer->setSingleShot(true);
   connect(d_log_rotation_timer,SIGNAL(timeout()),this,SLOT(logRotationData()));
+
+  //
+  // Rotation and purge scans run in the maintenance thread. Results are
+  // delivered back to this thread as queued signals.
+  //
+  d_log_maintainer=new LogMaintainer(this);
+  connect(this,SIGNAL(rotationRequested(const QDateTime &)),
+	  d_log_maintainer,SLOT(rotate(const QDateTime &)));
+  connect(this,SIGNAL(compressionRequested(const QString &)),
+	  d_log_maintainer,SLOT(compress(const QString &)));
+  connect(this,SIGNAL(logFileRotated(const QString &,const QString &)),
+	  this,SLOT(logFileRotatedData(const QString &,const QString &)));
+  connect(this,SIGNAL(maintenanceMessage(int,const QString &)),
+	  this,SLOT(maintenanceMessageData(int,const QString &)));
+
+  //
+  // Likewise, trigram indexes are built in the indexer thread
+  //
+  d_trigram_indexer=NULL;
+  d_index_pending_size=0;
+  if(trigram_index) {
+    d_trigram_indexer=new TrigramIndexer(trigram_index_size);
+    connect(this,SIGNAL(indexRequested(const QString &,qint64,qint64,
+				       const QByteArray &)),
+	    d_trigram_indexer,SLOT(addLines(const QString &,qint64,qint64,
+					    const QByteArray &)));
+    connect(this,SIGNAL(indexSealRequested(const QString &,const QString &)),
+	    d_trigram_indexer,SLOT(seal(const QString &,const QString &)));
+    connect(d_trigram_indexer,SIGNAL(maintenanceMessage(int,const QString &)),
+	    this,SLOT(maintenanceMessageData(int,const QString &)));
+  }
   StartLogRotationTimer();
 }
 
 
+Processor::~Processor()
+{
+  //
+  // The maintainer lives in another thread, so let that thread delete it.
+  //
+  d_log_maintainer->deleteLater();
+  if(d_trigram_indexer!=NULL) {
+    d_trigram_indexer->deleteLater();
+  }
+  for(QHash<QString,BloomFilter *>::const_iterator it=d_bloom_filters.begin();
+      it!=d_bloom_filters.end();it++) {
+    delete it.value();
+  }
+  delete d_pattern_filter;
+  delete d_msg_id_filter;
+  delete d_app_name_filter;
+  delete d_host_name_filter;
+  delete d_address_filter;
+  delete d_log_root_directory;
+}
+
+
 QString Processor::id() const
 {
   return d_id;
@@ -222,17 +483,192 @@ bool Processor::start(QString *err_msg)
 }
 
 
+void Processor::stop()
+{
+  //
+  // Write out any pending duplicate count and wait for queued maintenance
+  // jobs to finish, so that the processor can be safely deleted.
+  //
+  d_log_rotation_timer->stop();
+  d_deduplication_timer->stop();
+  deduplicationTimeoutData();
+  QMetaObject::invokeMethod(d_log_maintainer,"sync",
+			    Qt::BlockingQueuedConnection);
+  QCoreApplication::sendPostedEvents(this);
+  QMetaObject::invokeMethod(d_log_maintainer,"sync",
+			    Qt::BlockingQueuedConnection);
+  if(d_trigram_indexer!=NULL) {
+    QMetaObject::invokeMethod(d_trigram_indexer,"sync",
+			      Qt::BlockingQueuedConnection);
+  }
+}
+
+
+void Processor::retire()
+{
+  //
+  // As stop(), but without blocking the caller on maintenance jobs that
+  // may take some time to finish. Emits retired() once the processor can
+  // be safely deleted.
+  //
+  d_log_rotation_timer->stop();
+  d_deduplication_timer->stop();
+  deduplicationTimeoutData();
+  d_retire_passes=0;
+  connect(d_log_maintainer,SIGNAL(drained()),
+	  this,SLOT(maintenanceDrainedData()));
+  QMetaObject::invokeMethod(d_log_maintainer,"drain",Qt::QueuedConnection);
+}
+
+
 Profile *Processor::config() const
 {
   return d_profile;
 }
 
 
+const ProfileSection *Processor::configSection() const
+{
+  return d_config_section;
+}
+
+
 void Processor::rotateLogs(const QDateTime &now)
 {
 }
 
 
+void Processor::forceLogRotation(const QDateTime &now)
+{
+  //
+  // Run the rotation in the maintenance thread as usual, but don't return
+  // until it (and any resulting compression) has completed.
+  //
+  d_maintenance_gauge->add(1);
+  QMetaObject::invokeMethod(d_log_maintainer,"rotate",
+			    Qt::BlockingQueuedConnection,
+			    Q_ARG(QDateTime,now));
+  QCoreApplication::sendPostedEvents(this);
+  QMetaObject::invokeMethod(d_log_maintainer,"sync",
+			    Qt::BlockingQueuedConnection);
+}
+
+
+void Processor::compressLogFile(const QString &pathname)
+{
+  QString program;
+  QStringList args;
+  struct stat statbuf;
+
+  if(d_rotation_compression==Processor::CompressionNone) {
+    return;
+  }
+  QString new_pathname=
+    pathname+Processor::compressionSuffix(d_rotation_compression);
+  QString tmp_pathname=new_pathname+".tmp";
+  if(d_dry_run) {
+    printf("Processor %s: would compress file \"%s\" to \"%s\"\n",
+	   id().toUtf8().constData(),
+	   pathname.toUtf8().constData(),
+	   new_pathname.toUtf8().constData());
+    return;
+  }
+
+  //
+  // Run the compressor single-threaded at the lowest CPU priority, so
+  // that it can never starve the receivers.
+  //
+  switch(d_rotation_compression) {
+  case Processor::CompressionGzip:
+    program="gzip";
+    break;
+
+  case Processor::CompressionZstd:
+    program="zstd";
+    args.push_back("-q");
+    args.push_back("-T1");
+    break;
+
+  case Processor::CompressionXz:
+    program="xz";
+    args.push_back("-T1");
+    break;
+
+  case Processor::CompressionArchive:
+    break;
+
+  case Processor::CompressionNone:
+  case Processor::CompressionLast:
+    return;
+  }
+  if(d_rotation_compression==Processor::CompressionArchive) {
+    //
+    // Converted in-process; this thread already runs at low priority.
+    //
+    QString err_msg;
+    if(!ArchiveWriter::convertTextFile(pathname,tmp_pathname,
+				       d_rotation_compression_level,
+				       &err_msg)) {
+      MaintenanceSyslog(Message::SeverityWarning,
+			"compression of \"%s\" failed [%s]",
+			pathname.toUtf8().constData(),
+			err_msg.toUtf8().constData());
+      unlink(tmp_pathname.toUtf8());
+      return;
+    }
+  }
+  else {
+    if(d_rotation_compression_level>=0) {
+      args.push_back(QString::asprintf("-%d",d_rotation_compression_level));
+    }
+    args.push_back("-c");
+    args.push_front(program);
+    args.push_front("19");
+    args.push_front("-n");
+
+    QProcess *proc=new ChildProcess();
+    proc->setStandardInputFile(pathname);
+    proc->setStandardOutputFile(tmp_pathname,QIODevice::Truncate);
+    proc->start("nice",args);
+    proc->waitForFinished(-1);
+    if((proc->exitStatus()!=QProcess::NormalExit)||(proc->exitCode()!=0)) {
+      MaintenanceSyslog(Message::SeverityWarning,
+			"compression of \"%s\" failed [%s]",
+			pathname.toUtf8().constData(),
+			proc->errorString().toUtf8().constData());
+      unlink(tmp_pathname.toUtf8());
+      delete proc;
+      return;
+    }
+    delete proc;
+  }
+
+  //
+  // Carry over the modification time, which is used for expiring
+  // compressed files.
+  //
+  memset(&statbuf,0,sizeof(statbuf));
+  if(stat(pathname.toUtf8(),&statbuf)==0) {
+    struct timespec times[2];
+    times[0]=statbuf.st_atim;
+    times[1]=statbuf.st_mtim;
+    utimensat(AT_FDCWD,tmp_pathname.toUtf8(),times,0);
+  }
+  if(rename(tmp_pathname.toUtf8(),new_pathname.toUtf8())!=0) {
+    MaintenanceSyslog(Message::SeverityWarning,
+		      "compression of \"%s\" failed [%s]",
+		      pathname.toUtf8().constData(),strerror(errno));
+    unlink(tmp_pathname.toUtf8());
+    return;
+  }
+  unlink(pathname.toUtf8());
+  MaintenanceSyslog(Message::SeverityDebug,
+		    "compressed log file \"%s\" to \"%s\"",
+		    pathname.toUtf8().constData(),
+		    new_pathname.toUtf8().constData());
+}
+
+
 QString Processor::typeString(Processor::Type type)
 {
   QString ret="UNKNOWN";
@@ -254,6 +690,10 @@ QString Processor::typeString(Processor::Type type)
     ret="UDP";
     break;
 
+  case Processor::TypeIndexedStore:
+    ret="IndexedStore";
+    break;
+
   case Processor::TypeLast:
     break;
   }
@@ -274,11 +714,116 @@ Processor::Type Processor::typeFromString(const QString &str)
 }
 
 
+QString Processor::compressionString(Processor::Compression comp)
+{
+  QString ret="UNKNOWN";
+
+  switch(comp) {
+  case Processor::CompressionNone:
+    ret="none";
+    break;
+
+  case Processor::CompressionGzip:
+    ret="gzip";
+    break;
+
+  case Processor::CompressionZstd:
+    ret="zstd";
+    break;
+
+  case Processor::CompressionXz:
+    ret="xz";
+    break;
+
+  case Processor::CompressionArchive:
+    ret="archive";
+    break;
+
+  case Processor::CompressionLast:
+    break;
+  }
+
+  return ret;
+}
+
+
+Processor::Compression Processor::compressionFromString(const QString &str)
+{
+  for(int i=0;i<Processor::CompressionLast;i++) {
+    if(Processor::compressionString((Processor::Compression)i).toLower()==
+       str.trimmed().toLower()) {
+      return (Processor::Compression)i;
+    }
+  }
+
+  return Processor::CompressionLast;
+}
+
+
+QString Processor::compressionSuffix(Processor::Compression comp)
+{
+  QString ret;
+
+  switch(comp) {
+  case Processor::CompressionGzip:
+    ret=".gz";
+    break;
+
+  case Processor::CompressionZstd:
+    ret=".zst";
+    break;
+
+  case Processor::CompressionXz:
+    ret=".xz";
+    break;
+
+  case Processor::CompressionArchive:
+    ret=ARCHIVE_SUFFIX;
+    break;
+
+  case Processor::CompressionNone:
+  case Processor::CompressionLast:
+    break;
+  }
+
+  return ret;
+}
+
+
+bool Processor::isCompressedLogFile(const QString &pathname)
+{
+  for(int i=Processor::CompressionGzip;i<Processor::CompressionLast;i++) {
+    if(pathname.endsWith(Processor::compressionSuffix((Compression)i))) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
 void Processor::process(Message *msg,const QHostAddress &from_addr)
 {
+  uint64_t start_usec=0;
+  bool sampled=(--d_latency_countdown==0);
+
+  d_received_counter->increment();
+  if(sampled) {
+    d_latency_countdown=PROCESSOR_LATENCY_SAMPLE_INTERVAL;
+    start_usec=Metrics::monotonicUsec();
+    if(msg->receiveTime()>0) {
+      int64_t nsec=Metrics::realtimeNsec()-msg->receiveTime();
+      d_dispatch_histogram->observe((nsec>0)?nsec/1000:0);
+    }
+  }
   if(((MakeMask(((uint32_t)msg->facility()))&d_facility_mask)!=0)&&
      ((MakeMask(((uint32_t)msg->severity()))&d_severity_mask)!=0)&&
-     d_address_filter->contains(from_addr)) {
+     d_address_filter->contains(from_addr)&&
+     d_host_name_filter->contains(msg->hostName())&&
+     d_app_name_filter->contains(msg->appName())&&
+     d_msg_id_filter->contains(msg->msgId())&&
+     (d_pattern_filter->isEmpty()||
+      d_pattern_filter->accepts(msg->msg().toUtf8()))) {
     if(d_override_timestamps) {
       msg->setTimestamp(QDateTime::currentDateTime());
     }
@@ -287,10 +832,18 @@ void Processor::process(Message *msg,const QHostAddress &from_addr)
     // Deduplication Stuff
     //
     if(d_deduplication_timeout>0) {
-      d_deduplication_timer->stop();
-      d_deduplication_timer->start(1000*d_deduplication_timeout);
+      //
+      // Only push the deadline back here; the timer is re-armed for the
+      // remainder when it fires, rather than restarted for every message.
+      //
+      d_deduplication_deadline=
+	(int64_t)Metrics::monotonicUsec()+1000000ll*d_deduplication_timeout;
+      if(!d_deduplication_timer->isActive()) {
+	d_deduplication_timer->start(1000*d_deduplication_timeout);
+      }
       if(msg->isDuplicateOf(d_last_message)) {
 	d_last_message_count++;
+	d_deduplicated_counter->increment();
 	return;
       }
       else {
@@ -301,6 +854,115 @@ void Processor::process(Message *msg,const QHostAddress &from_addr)
     }
 	
     processMessage(msg,from_addr);
+    if(sampled) {
+      d_processing_histogram->observe(Metrics::monotonicUsec()-start_usec);
+    }
+  }
+  else {
+    d_filtered_counter->increment();
+  }
+}
+
+
+void Processor::countWrite(bool ok,int bytes)
+{
+  if(ok) {
+    d_bytes_written_counter->increment(bytes);
+  }
+  else {
+    d_write_errors_counter->increment();
+  }
+}
+
+
+void Processor::recordWritten(int64_t receive_time)
+{
+  if((receive_time>0)&&(--d_written_countdown==0)) {
+    d_written_countdown=PROCESSOR_LATENCY_SAMPLE_INTERVAL;
+    int64_t nsec=Metrics::realtimeNsec()-receive_time;
+    d_written_histogram->observe((nsec>0)?nsec/1000:0);
+  }
+}
+
+
+void Processor::addFilterKeys(const QString &pathname,int64_t prior_size,
+			      Message *msg)
+{
+  if(!d_bloom_filter) {
+    return;
+  }
+  BloomFilter *filter=d_bloom_filters.value(pathname);
+  if(filter==NULL) {
+    //
+    // Keep the filters of all open logfiles (one per host, for
+    // FileByHostname) within the memory cap, giving new ones whatever is
+    // left. Files that don't get one simply have no sidecar.
+    //
+    uint64_t bits=8*(PROCESSOR_MAX_BLOOM_FILTER_MEMORY-d_bloom_filter_memory);
+    if(bits<BLOOMFILTER_DEFAULT_BITS) {
+      return;
+    }
+    if(bits>d_bloom_filter_bits) {
+      bits=d_bloom_filter_bits;
+    }
+    filter=new BloomFilter(bits);
+    filter->setHasTokens(d_bloom_filter_tokens);
+    d_bloom_filters[pathname]=filter;
+    d_bloom_filter_memory+=filter->bits()/8;
+
+    //
+    // Messages written before we started (e.g. by a previous instance)
+    // aren't in the filter, so it mustn't be used to rule the file out.
+    //
+    if(prior_size>0) {
+      d_partial_bloom_filters.insert(pathname);
+    }
+  }
+  filter->insert(BloomFilter::hostKey(msg->hostName().toUtf8()));
+  filter->insert(BloomFilter::appKey(msg->appName().toUtf8()));
+  if(d_bloom_filter_tokens) {
+    QByteArray data=msg->msg().toUtf8();
+    int start=-1;
+    for(int i=0;i<=data.size();i++) {
+      uint8_t c=(i<data.size())?data.at(i):0;
+      if(isalnum(c)||(c=='_')||(c>=0x80)) {
+	if(start<0) {
+	  start=i;
+	}
+      }
+      else {
+	if((start>=0)&&((i-start)>=BLOOMFILTER_MIN_TOKEN_LENGTH)) {
+	  filter->insert(BloomFilter::tokenKey(data.mid(start,i-start)));
+	}
+	start=-1;
+      }
+    }
+  }
+}
+
+
+void Processor::addIndexLines(const QString &pathname,int64_t prior_size,
+			      const QByteArray &data)
+{
+  if(d_trigram_indexer==NULL) {
+    return;
+  }
+  if(!d_index_offsets.contains(pathname)) {
+    d_index_starts[pathname]=prior_size;
+    d_index_offsets[pathname]=prior_size;
+  }
+  d_index_pending[pathname]+=data;
+  d_index_pending_size+=data.size();
+
+  //
+  // The batch size bounds the lines held for all of the processor's
+  // logfiles together, not for each one.
+  //
+  if(d_index_pending_size>=PROCESSOR_INDEX_BATCH_SIZE) {
+    QStringList pathnames=d_index_pending.keys();
+    for(int i=0;i<pathnames.size();i++) {
+      FlushIndexLines(pathnames.at(i));
+    }
   }
 }
 
@@ -311,64 +973,143 @@ QString Processor::messageTemplate() const
 }
 
 
-void Processor::rotateLogFile(const QString &filename,
-			      const QDateTime &now) const
+Processor::Compression Processor::rotationCompression() const
 {
-  QFileInfo info(filename);
+  return d_rotation_compression;
+}
+
+
+int Processor::logRotationAge() const
+{
+  return d_log_rotation_age;
+}
+
 
+int64_t Processor::logRotationSize() const
+{
+  return d_log_rotation_size;
+}
+
+
+void Processor::reopenLogFile(const QString &pathname)
+{
+}
+
+
+void Processor::rotateLogFile(const QString &filename,const QDateTime &now)
+{
+  struct stat before;
+  struct stat after;
+
+  //
+  // Runs in the maintenance thread, so the processor may rotate the same
+  // file by size at any moment. Remember which file was examined, so that
+  // its fresh replacement is never rotated in its place.
+  //
+  if(stat(filename.toUtf8(),&before)!=0) {
+    return;
+  }
+  QFileInfo info(filename);
   if(((d_log_rotation_size>0)&&
-      (info.size()>=d_log_rotation_size))||
+      (before.st_size>=d_log_rotation_size))||
      ((d_log_rotation_age>0)&&
       (info.fileTime(QFileDevice::FileBirthTime)<
        now.addDays(-d_log_rotation_age)))) {
-    QString new_filename=
-      QString::asprintf("%s-%s",filename.toUtf8().constData(),
-			now.toString("yyyy-MM-dd").toUtf8().constData());
-    if(QFile::exists(new_filename)) {
-      int count=0;
+    QString new_filename;
+    QString err_msg;
+    if(d_dry_run) {
       new_filename=
 	QString::asprintf("%s-%s",filename.toUtf8().constData(),
-			  now.toString("yyyy-MM-dd").toUtf8().constData())+
-	QString::asprintf("-%d",1+count);
-      while(QFile::exists(new_filename)) {
-	count++;
-	new_filename=
-	  QString::asprintf("%s-%s",filename.toUtf8().constData(),
-			    now.toString("yyyy-MM-dd").toUtf8().constData())+
-	  QString::asprintf("-%d",1+count);
-      }
-    }
-    if(d_dry_run) {
+			  now.toString("yyyy-MM-dd").toUtf8().constData());
       printf("Processor %s: would rotate file \"%s\" to \"%s\"\n",
 	     id().toUtf8().constData(),
 	     filename.toUtf8().constData(),
 	     new_filename.toUtf8().constData());
     }
     else {
-      if(rename(filename.toUtf8(),new_filename.toUtf8())==0) {
-	lsyslog(Message::SeverityDebug,
-		    "rotated log file \"%s\" to \"%s\"",
-		    filename.toUtf8().constData(),
-		    new_filename.toUtf8().constData());
+      if(RenameLogFile(filename,now,&new_filename,&err_msg)) {
+	if((stat(new_filename.toUtf8(),&after)!=0)||
+	   (after.st_dev!=before.st_dev)||(after.st_ino!=before.st_ino)) {
+	  //
+	  // Renamed a file that the processor had only just opened; put
+	  // it back unless yet another has been created meanwhile.
+	  //
+	  if(renameat2(AT_FDCWD,new_filename.toUtf8(),AT_FDCWD,
+		       filename.toUtf8(),RENAME_NOREPLACE)==0) {
+	    MaintenanceSyslog(Message::SeverityDebug,
+			      "log file \"%s\" was rotated concurrently",
+			      filename.toUtf8().constData());
+	    return;
+	  }
+	}
+	MaintenanceSyslog(Message::SeverityDebug,
+			  "rotated log file \"%s\" to \"%s\"",
+			  filename.toUtf8().constData(),
+			  new_filename.toUtf8().constData());
+	emit logFileRotated(filename,new_filename);
       }
       else {
-	lsyslog(Message::SeverityWarning,"log rotation of \"%s\" failed [%s]",
-		    filename.toUtf8().constData(),strerror(errno));
+	MaintenanceSyslog(Message::SeverityWarning,
+			  "log rotation of \"%s\" failed [%s]",
+			  filename.toUtf8().constData(),
+			  err_msg.toUtf8().constData());
       }
     }
   }
 }
 
 
-bool Processor::expireLogFile(const QString &pathname,
-			      const QDateTime &now) const
+bool Processor::rotateLogFileBySize(LogFile *logfile)
+{
+  QString new_filename;
+  QString err_msg;
+
+  if((d_log_rotation_size<=0)||(logfile->size()<d_log_rotation_size)||
+     d_dry_run) {
+    return false;
+  }
+  if(!RenameLogFile(logfile->pathname(),QDateTime::currentDateTime(),
+		    &new_filename,&err_msg)) {
+    lsyslog(Message::SeverityWarning,"log rotation of \"%s\" failed [%s]",
+	    logfile->pathname().toUtf8().constData(),
+	    err_msg.toUtf8().constData());
+    return false;
+  }
+  WriteBloomFilter(logfile->pathname(),new_filename);
+  SealTrigramIndex(logfile->pathname(),new_filename);
+  if(!logfile->reopen(&err_msg)) {
+    lsyslog(Message::SeverityWarning,"failed to reopen logfile %s [%s]",
+	    logfile->pathname().toUtf8().constData(),
+	    err_msg.toUtf8().constData());
+  }
+  lsyslog(Message::SeverityDebug,"rotated log file \"%s\" to \"%s\"",
+	  logfile->pathname().toUtf8().constData(),
+	  new_filename.toUtf8().constData());
+  d_maintenance_gauge->add(1);
+  emit compressionRequested(new_filename);
+
+  return true;
+}
+
+
+bool Processor::expireLogFile(const QString &pathname,const QDateTime &now)
 {
   QFileInfo info(pathname);
   bool ret=false;
-  
-  if((d_old_log_purge_age>0)&&
-     (info.fileTime(QFileDevice::FileBirthTime)<
-      now.addDays(-d_old_log_purge_age))) {
+
+  //
+  // Compressed files are newly created by the compressor, so go by the
+  // modification time carried over from the original.
+  //
+  QDateTime created=info.fileTime(QFileDevice::FileBirthTime);
+  if(Processor::isCompressedLogFile(pathname)) {
+    created=info.fileTime(QFileDevice::FileModificationTime);
+  }
+  if(pathname.endsWith(BLOOMFILTER_SUFFIX)||
+     pathname.endsWith(TRIGRAMINDEX_SUFFIX)) {
+    return false;  // Purged along with its logfile
+  }
+  if((d_old_log_purge_age>0)&&(created<now.addDays(-d_old_log_purge_age))) {
     if(d_dry_run) {
       printf("Processor %s: would purge file \"%s\"\n",
 	     id().toUtf8().constData(),
@@ -376,15 +1117,17 @@ bool Processor::expireLogFile(const QString &pathname,
     }
     else {
       if(unlink(info.filePath().toUtf8())==0) {
-	lsyslog(Message::SeverityDebug,
-		"purged log file \"%s\"",
-		info.filePath().toUtf8().constData());
+	MaintenanceSyslog(Message::SeverityDebug,
+			  "purged log file \"%s\"",
+			  info.filePath().toUtf8().constData());
+	unlink(BloomFilter::sidecarPathname(info.filePath()).toUtf8());
+	unlink(TrigramIndex::sidecarPathname(info.filePath()).toUtf8());
 	ret=true;
       }
       else {
-	lsyslog(Message::SeverityWarning,
-		"failed to purge log file \"%s\" [%s]",
-		info.filePath().toUtf8().constData(),strerror(errno));
+	MaintenanceSyslog(Message::SeverityWarning,
+			  "failed to purge log file \"%s\" [%s]",
+			  info.filePath().toUtf8().constData(),strerror(errno));
       }
     }
   }
@@ -413,11 +1156,34 @@ void Processor::lsyslog(Message::Severity severity,const char *fmt,...) const
 
 void Processor::logRotationData()
 {
-  rotateLogs(QDateTime::currentDateTime());
+  d_maintenance_gauge->add(1);
+  emit rotationRequested(QDateTime::currentDateTime());
   StartLogRotationTimer();
 }
 
 
+void Processor::logFileRotatedData(const QString &pathname,
+				   const QString &new_pathname)
+{
+  WriteBloomFilter(pathname,new_pathname);
+  SealTrigramIndex(pathname,new_pathname);
+  reopenLogFile(pathname);
+
+  //
+  // Nothing more will be written to the rotated file once the handle has
+  // been swapped, so it's now safe to compress it.
+  //
+  d_maintenance_gauge->add(1);
+  emit compressionRequested(new_pathname);
+}
+
+
+void Processor::maintenanceMessageData(int severity,const QString &msg)
+{
+  lsyslog((Message::Severity)severity,"%s",msg.toUtf8().constData());
+}
+
+
 void Processor::deduplicationTimeoutData()
 {
   if(d_last_message_count>0) {
@@ -431,6 +1197,46 @@ void Processor::deduplicationTimeoutData()
 }
 
 
+void Processor::deduplicationTimerData()
+{
+  int64_t remaining=
+    d_deduplication_deadline-(int64_t)Metrics::monotonicUsec();
+
+  if(remaining>0) {
+    d_deduplication_timer->start((remaining+999)/1000);
+    return;
+  }
+  deduplicationTimeoutData();
+}
+
+
+void Processor::maintenanceDrainedData()
+{
+  //
+  // Completed rotations can queue compression jobs by way of
+  // logFileRotatedData(), which will have run by now, so go round twice.
+  //
+  if(++d_retire_passes<2) {
+    QMetaObject::invokeMethod(d_log_maintainer,"drain",Qt::QueuedConnection);
+    return;
+  }
+  if(d_trigram_indexer!=NULL) {
+    connect(d_trigram_indexer,SIGNAL(drained()),
+	    this,SLOT(indexerDrainedData()));
+    QMetaObject::invokeMethod(d_trigram_indexer,"drain",
+			      Qt::QueuedConnection);
+    return;
+  }
+  emit retired();
+}
+
+
+void Processor::indexerDrainedData()
+{
+  emit retired();
+}
+
+
 void Processor::StartLogRotationTimer()
 {
   if(!d_log_rotation_time.isNull()) {
@@ -447,8 +1253,81 @@ void Processor::StartLogRotationTimer()
 }
 
 
-uint32_t Processor::MakeSeverityMask(const QString &params,bool *ok,
-				     QString *err_msg) const
+void Processor::MaintenanceSyslog(Message::Severity severity,
+				  const char *fmt,...)
+{
+  char buffer[1024];
+
+  //
+  // LocalSyslog() is not thread-safe, so hand the message to the
+  // processor's own thread for logging.
+  //
+  va_list args;
+  va_start(args,fmt);
+  vsnprintf(buffer,1024,fmt,args);
+  va_end(args);
+  emit maintenanceMessage(severity,QString::fromUtf8(buffer));
+}
+
+
+bool Processor::RenameLogFile(const QString &filename,const QDateTime &now,
+			      QString *new_filename,QString *err_msg) const
+{
+  //
+  // A file that is compressed as it is written keeps its compression
+  // suffix at the end of the rotated name.
+  //
+  QString stem=filename;
+  QString suffix;
+  for(int i=Processor::CompressionGzip;i<Processor::CompressionLast;i++) {
+    QString comp_suffix=Processor::compressionSuffix((Compression)i);
+    if(filename.endsWith(comp_suffix)) {
+      stem.chop(comp_suffix.size());
+      suffix=comp_suffix;
+      break;
+    }
+  }
+  QString base=QString::asprintf("%s-%s",stem.toUtf8().constData(),
+				 now.toString("yyyy-MM-dd").toUtf8().constData());
+
+  //
+  // Let the kernel pick the first free suffix atomically, rather than
+  // probing for one with stat() beforehand.
+  //
+  *new_filename=base+suffix;
+  for(int count=1;count<PROCESSOR_MAX_ROTATION_SUFFIX;count++) {
+    if(renameat2(AT_FDCWD,filename.toUtf8(),AT_FDCWD,new_filename->toUtf8(),
+		 RENAME_NOREPLACE)==0) {
+      return true;
+    }
+    if((errno==EINVAL)||(errno==ENOSYS)) {
+      //
+      // Filesystem doesn't support RENAME_NOREPLACE
+      //
+      if(access(new_filename->toUtf8(),F_OK)!=0) {
+	if(rename(filename.toUtf8(),new_filename->toUtf8())==0) {
+	  return true;
+	}
+	*err_msg=strerror(errno);
+	return false;
+      }
+    }
+    else {
+      if(errno!=EEXIST) {
+	*err_msg=strerror(errno);
+	return false;
+      }
+    }
+    *new_filename=base+QString::asprintf("-%d",count)+suffix;
+  }
+  *err_msg=QObject::tr("no free filename suffix available");
+
+  return false;
+}
+
+
+uint32_t Processor::makeSeverityMask(const QString &params,bool *ok,
+				     QString *err_msg)
 {
   uint32_t mask=0;
   
@@ -495,8 +1374,8 @@ uint32_t Processor::MakeSeverityMask(const QString &params,bool *ok,
 }
 
 
-uint32_t Processor::MakeFacilityMask(const QString &params,bool *ok,
-				     QString *err_msg) const
+uint32_t Processor::makeFacilityMask(const QString &params,bool *ok,
+				     QString *err_msg)
 {
   uint32_t mask=0;
   
@@ -543,7 +1422,74 @@ uint32_t Processor::MakeFacilityMask(const QString &params,bool *ok,
 }
 
 
-uint32_t Processor::MakeMask(uint32_t num) const
+uint32_t Processor::MakeMask(uint32_t num)
 {
   return 1<<(uint32_t)num;
 }
+
+
+void Processor::WriteBloomFilter(const QString &pathname,
+				 const QString &new_pathname)
+{
+  QString err_msg;
+
+  //
+  // Called in the processor's thread once a logfile has been renamed.
+  // Anything written through the old handle in the meantime went to the
+  // rotated file, so the filter covers exactly that file's contents.
+  //
+  BloomFilter *filter=d_bloom_filters.value(pathname);
+  if(filter==NULL) {
+    return;
+  }
+  d_bloom_filters.remove(pathname);
+  d_bloom_filter_memory-=filter->bits()/8;
+  if(d_partial_bloom_filters.remove(pathname)) {
+    lsyslog(Message::SeverityDebug,
+	    "skipped filter for \"%s\", as it does not cover the whole file",
+	    new_pathname.toUtf8().constData());
+  }
+  else {
+    if(filter->falsePositiveRate()>BLOOMFILTER_MAX_FALSE_POSITIVES) {
+      lsyslog(Message::SeverityDebug,
+	      "skipped filter for \"%s\", as it is saturated",
+	      new_pathname.toUtf8().constData());
+    }
+    else {
+      if(!filter->save(BloomFilter::sidecarPathname(new_pathname),&err_msg)) {
+	lsyslog(Message::SeverityWarning,
+		"failed to write filter for \"%s\" [%s]",
+		new_pathname.toUtf8().constData(),err_msg.toUtf8().constData());
+      }
+    }
+  }
+  delete filter;
+}
+
+
+void Processor::FlushIndexLines(const QString &pathname)
+{
+  QByteArray &pending=d_index_pending[pathname];
+
+  if(!pending.isEmpty()) {
+    emit indexRequested(pathname,d_index_starts.value(pathname),
+			d_index_offsets.value(pathname),pending);
+    d_index_offsets[pathname]+=pending.size();
+    d_index_pending_size-=pending.size();
+    pending.clear();
+  }
+}
+
+
+void Processor::SealTrigramIndex(const QString &pathname,
+				 const QString &new_pathname)
+{
+  if((d_trigram_indexer==NULL)||(!d_index_offsets.contains(pathname))) {
+    return;
+  }
+  FlushIndexLines(pathname);
+  emit indexSealRequested(pathname,new_pathname);
+  d_index_starts.remove(pathname);
+  d_index_offsets.remove(pathname);
+  d_index_pending.remove(pathname);
+}
@@ -23,72 +23,178 @@
 
 #include <QDateTime>
 #include <QDir>
+#include <QHash>
 #include <QObject>
+#include <QSet>
 #include <QTimer>
 
 #include "addressfilter.h"
+#include "bloomfilter.h"
+#include "fieldfilter.h"
+#include "logfile.h"
+#include "logmaintainer.h"
+#include "metrics.h"
+#include "patternfilter.h"
 #include "profile.h"
+#include "trigramindexer.h"
 
 #include "message.h"
 
+//
+// Maximum number of rotated files per base filename per day
+//
+#define PROCESSOR_MAX_ROTATION_SUFFIX 10000
+
+//
+// Written lines are passed to the trigram indexer in batches of this size
+//
+#define PROCESSOR_INDEX_BATCH_SIZE 65536
+
+//
+// Latency histograms are fed from one message in this many, to keep clock
+// reads off the per-message path
+//
+#define PROCESSOR_LATENCY_SAMPLE_INTERVAL 64
+
+//
+// Most memory, in bytes, taken by the Bloom filters of a processor's open
+// logfiles at any one time
+//
+#define PROCESSOR_MAX_BLOOM_FILTER_MEMORY 67108864
+
 class Processor : public QObject
 {
   Q_OBJECT
  public:
   enum Type {TypeSimpleFile=0,TypeFileByHostname=1,TypeSendmail=2,TypeUdp=3,
-    TypeLast=4};
+    TypeIndexedStore=4,TypeLast=5};
+  enum Compression {CompressionNone=0,CompressionGzip=1,CompressionZstd=2,
+    CompressionXz=3,CompressionArchive=4,CompressionLast=5};
   Processor(const QString &id,Profile *p,QObject *parent=0);
+  ~Processor();
   QString id() const;
   bool overrideTimestamps();
   bool dryRun() const;
   void setDryRun(bool state);
   virtual Type type() const=0;
+  Profile *config() const;
   virtual bool start(QString *err_msg);
+  void stop();
+  void retire();
   virtual void rotateLogs(const QDateTime &now);
+  void forceLogRotation(const QDateTime &now);
+  void compressLogFile(const QString &pathname);
   static QString typeString(Type type);
   static Type typeFromString(const QString &str);
+  static QString compressionString(Compression comp);
+  static Compression compressionFromString(const QString &str);
+  static QString compressionSuffix(Compression comp);
+  static bool isCompressedLogFile(const QString &pathname);
+  static uint32_t makeSeverityMask(const QString &params,bool *ok,
+				   QString *err_msg);
+  static uint32_t makeFacilityMask(const QString &params,bool *ok,
+				   QString *err_msg);
 
  public slots:
   void process(Message *msg,const QHostAddress &from_addr);
 
+ signals:
+  void rotationRequested(const QDateTime &now);
+  void compressionRequested(const QString &pathname);
+  void logFileRotated(const QString &pathname,const QString &new_pathname);
+  void maintenanceMessage(int severity,const QString &msg);
+  void indexRequested(const QString &pathname,qint64 start,qint64 offset,
+		      const QByteArray &data);
+  void indexSealRequested(const QString &pathname,const QString &new_pathname);
+  void retired();
+
  protected:
   virtual void processMessage(Message *msg,const QHostAddress &from_addr)=0;
+  virtual void reopenLogFile(const QString &pathname);
   QString messageTemplate() const;
-  void rotateLogFile(const QString &filename,const QDateTime &now) const;
-  bool expireLogFile(const QString &pathname,const QDateTime &now) const;
-  Profile *config() const;
+  Compression rotationCompression() const;
+  int logRotationAge() const;
+  int64_t logRotationSize() const;
+  void rotateLogFile(const QString &filename,const QDateTime &now);
+  bool rotateLogFileBySize(LogFile *logfile);
+  bool expireLogFile(const QString &pathname,const QDateTime &now);
+  void countWrite(bool ok,int bytes);
+  void recordWritten(int64_t receive_time);
+  void addFilterKeys(const QString &pathname,int64_t prior_size,Message *msg);
+  void addIndexLines(const QString &pathname,int64_t prior_size,
+		     const QByteArray &data);
+  const ProfileSection *configSection() const;
   QDir *logRootDirectory() const;
   void lsyslog(Message::Severity severity,const char *fmt,...) const;
 
  private slots:
   void logRotationData();
+  void logFileRotatedData(const QString &pathname,const QString &new_pathname);
+  void maintenanceMessageData(int severity,const QString &msg);
   void deduplicationTimeoutData();
+  void deduplicationTimerData();
+  void maintenanceDrainedData();
+  void indexerDrainedData();
   
  private:
   void StartLogRotationTimer();
-  uint32_t MakeSeverityMask(const QString &params,bool *ok,
-			    QString *err_msg) const;
-  uint32_t MakeFacilityMask(const QString &params,bool *ok,
-			    QString *err_msg) const;
-  uint32_t MakeMask(uint32_t num) const;
+  void MaintenanceSyslog(Message::Severity severity,const char *fmt,...);
+  void WriteBloomFilter(const QString &pathname,const QString &new_pathname);
+  void FlushIndexLines(const QString &pathname);
+  void SealTrigramIndex(const QString &pathname,const QString &new_pathname);
+  bool RenameLogFile(const QString &filename,const QDateTime &now,
+		     QString *new_filename,QString *err_msg) const;
+  static uint32_t MakeMask(uint32_t num);
   uint32_t d_facility_mask;
   uint32_t d_severity_mask;
   AddressFilter *d_address_filter;
+  FieldFilter *d_host_name_filter;
+  FieldFilter *d_app_name_filter;
+  FieldFilter *d_msg_id_filter;
+  PatternFilter *d_pattern_filter;
   Profile *d_profile;
+  const ProfileSection *d_config_section;
   QTimer *d_log_rotation_timer;
+  LogMaintainer *d_log_maintainer;
   QTime d_log_rotation_time;
   int d_old_log_purge_age;
   int d_log_rotation_age;
-  int d_log_rotation_size;
+  int64_t d_log_rotation_size;
+  Compression d_rotation_compression;
+  int d_rotation_compression_level;
   QString d_id;
   bool d_dry_run;
+  int d_retire_passes;
   int d_deduplication_timeout;
   QTimer *d_deduplication_timer;
+  int64_t d_deduplication_deadline;
+  MetricsCounter *d_received_counter;
+  MetricsCounter *d_filtered_counter;
+  MetricsCounter *d_deduplicated_counter;
+  MetricsCounter *d_bytes_written_counter;
+  MetricsCounter *d_write_errors_counter;
+  MetricsHistogram *d_processing_histogram;
+  MetricsHistogram *d_dispatch_histogram;
+  MetricsHistogram *d_written_histogram;
+  uint32_t d_latency_countdown;
+  uint32_t d_written_countdown;
+  MetricsGauge *d_maintenance_gauge;
   QString d_message_template;
   Message d_last_message;
   int d_last_message_count;
   bool d_override_timestamps;
   QDir *d_log_root_directory;
+  bool d_bloom_filter;
+  bool d_bloom_filter_tokens;
+  uint64_t d_bloom_filter_bits;
+  QHash<QString,BloomFilter *> d_bloom_filters;
+  uint64_t d_bloom_filter_memory;
+  QSet<QString> d_partial_bloom_filters;
+  TrigramIndexer *d_trigram_indexer;
+  QHash<QString,int64_t> d_index_starts;
+  QHash<QString,int64_t> d_index_offsets;
+  QHash<QString,QByteArray> d_index_pending;
+  int64_t d_index_pending_size;
 };
 
 
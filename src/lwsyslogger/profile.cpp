@@ -21,8 +21,13 @@
 // EXEMPLAR_VERSION: 2.0.0
 //
 
+#include <errno.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
+#include <QDataStream>
 #include <QDir>
 #include <QFile>
 #include <QStringList>
@@ -32,6 +37,7 @@
 
 #define __PROFILE_SECTION_ID_DELIMITER "|"
 #define __PROFILE_DEFAULT_SECTION_ID "Default"
+#define __PROFILE_CACHE_MAGIC "LWSYSLOGGER-PROFILE-CACHE"
 
 Profile::Profile(bool use_section_ids)
 {
@@ -39,6 +45,12 @@ Profile::Profile(bool use_section_ids)
 }
 
 
+Profile::~Profile()
+{
+  ClearSections();
+}
+
+
 QStringList Profile::sectionNames() const
 {
   return d_blocks.keys();
@@ -56,6 +68,7 @@ bool Profile::addSource(const QStringList &values)
   QString block_name;
   QMap<QString,QStringList> block_lines;
 
+  ClearSections();
   for(int i=0;i<values.size();i++) {
     QString line=values.at(i);
     if((line.left(1)=="[")&&(line.right(1)=="]")) {  // Block Starts
@@ -101,7 +114,9 @@ bool Profile::loadFile(const QString &filename,QString *err_msg)
   while(fgets(data,1023,f)!=NULL) {
     values.push_back(QString::fromUtf8(data).trimmed());
   }
+  fclose(f);
   addSource(values);
+  d_source_mtimes[filename]=ModificationTime(filename);
   if(err_msg!=NULL) {
     *err_msg=
       QString::asprintf("loaded file \"%s\"",filename.toUtf8().constData());
@@ -130,6 +145,11 @@ int Profile::loadDirectory(const QString &dirpath,const QString &glob_template,
       return -1;
     }
   }
+  //
+  // The directory's own mtime changes when files are added or removed,
+  // which is what invalidates a cached profile in that case.
+  //
+  d_source_mtimes[dir.path()]=ModificationTime(dir.path());
   QStringList name_filters;
   name_filters.push_back(glob_template);
   QStringList filenames=dir.entryList(name_filters,QDir::Files,QDir::Name);
@@ -209,6 +229,31 @@ QStringList Profile::sectionIds(const QString &section) const
 }
 
 
+QMap<QString,QStringList> Profile::sectionValues(const QString &section,
+						 const QString &section_id) const
+{
+  return d_blocks.value(section+__PROFILE_SECTION_ID_DELIMITER+section_id);
+}
+
+
+const ProfileSection *Profile::section(const QString &section,
+				       const QString &section_id) const
+{
+  //
+  // Handles are built on first use and remain valid until the profile
+  // is next modified.
+  //
+  QString key=section+__PROFILE_SECTION_ID_DELIMITER+section_id;
+  ProfileSection *ret=d_sections.value(key);
+  if(ret==NULL) {
+    ret=new ProfileSection(section,section_id,d_blocks.value(key));
+    d_sections[key]=ret;
+  }
+
+  return ret;
+}
+
+
 QString Profile::stringValue(const QString &section,const QString &tag,
 			     const QString &default_str,bool *found)
 {
@@ -415,10 +460,7 @@ QList<bool> Profile::boolValues(const QString &section,const QString &tag)
   QList<bool> ret;
   QStringList values=block.value(tag);
   for(int i=0;i<values.size();i++) {
-    ret.push_back((values.at(i).toLower()=="yes")||
-		  (values.at(i).toLower()=="true")||
-		  (values.at(i).toLower()=="on")||
-		  (values.at(i).toLower()=="1"));
+    ret.push_back(toBool(values.at(i)));
   }
   return ret;
 }
@@ -437,10 +479,7 @@ QList<bool> Profile::boolValues(const QString &section,
   }
   QStringList values=block.value(tag);
   for(int i=0;i<values.size();i++) {
-    ret.push_back((values.at(i).toLower()=="yes")||
-		  (values.at(i).toLower()=="true")||
-		  (values.at(i).toLower()=="on")||
-		  (values.at(i).toLower()=="1"));
+    ret.push_back(toBool(values.at(i)));
   }
   
   return ret;
@@ -470,19 +509,7 @@ QList<QTime> Profile::timeValues(const QString &section,const QString &tag)
   QList<QTime> ret;
   QStringList values=block.value(tag);
   for(int i=0;i<values.size();i++) {
-    QStringList fields=values.at(i).split(":");
-    if(fields.size()==2) {
-      ret.push_back(QTime(fields.at(0).toInt(),fields.at(1).toInt(),0));
-    }
-    else {
-      if(fields.size()==3) {
-	ret.push_back(QTime(fields.at(0).toInt(),fields.at(1).toInt(),
-			    fields.at(2).toInt()));
-      }
-      else {
-	ret.push_back(QTime());
-      }
-    }
+    ret.push_back(toTime(values.at(i)));
   }
   return ret;
 }
@@ -501,19 +528,7 @@ QList<QTime> Profile::timeValues(const QString &section,
   }
   QStringList values=block.value(tag);
   for(int i=0;i<values.size();i++) {
-    QStringList fields=values.at(i).split(":");
-    if(fields.size()==2) {
-      ret.push_back(QTime(fields.at(0).toInt(),fields.at(1).toInt(),0));
-    }
-    else {
-      if(fields.size()==3) {
-	ret.push_back(QTime(fields.at(0).toInt(),fields.at(1).toInt(),
-			    fields.at(2).toInt()));
-      }
-      else {
-	ret.push_back(QTime());
-      }
-    }
+    ret.push_back(toTime(values.at(i)));
   }
   
   return ret;
@@ -570,10 +585,34 @@ QList<QHostAddress> Profile::addressValues(const QString &section,
 }
 
 
+bool Profile::toBool(const QString &str)
+{
+  QString value=str.toLower();
+
+  return (value=="yes")||(value=="true")||(value=="on")||(value=="1");
+}
+
+
+QTime Profile::toTime(const QString &str)
+{
+  QStringList fields=str.split(":");
+  if(fields.size()==2) {
+    return QTime(fields.at(0).toInt(),fields.at(1).toInt(),0);
+  }
+  if(fields.size()==3) {
+    return QTime(fields.at(0).toInt(),fields.at(1).toInt(),
+		 fields.at(2).toInt());
+  }
+  return QTime();
+}
+
+
 void Profile::clear()
 {
+  ClearSections();
   profile_source="";
   d_blocks.clear();
+  d_source_mtimes.clear();
 }
 
 
@@ -603,6 +642,97 @@ QString Profile::dump() const
 }
 
 
+bool Profile::loadCache(const QString &cache_filename,
+			const QString &config_filename,QString *err_msg)
+{
+  QString magic;
+  quint32 version=0;
+  QString filename;
+  bool use_section_ids=false;
+  QMap<QString,qint64> mtimes;
+  QMap<QString,QMap<QString,QStringList> > blocks;
+
+  QFile file(cache_filename);
+  if(!file.open(QIODevice::ReadOnly)) {
+    *err_msg=file.errorString();
+    return false;
+  }
+  QDataStream stream(&file);
+  stream.setVersion(QDataStream::Qt_5_0);
+  stream>>magic>>version;
+  if((stream.status()!=QDataStream::Ok)||(magic!=__PROFILE_CACHE_MAGIC)||
+     (version!=PROFILE_CACHE_VERSION)) {
+    *err_msg="unrecognized cache format";
+    return false;
+  }
+  stream>>filename>>use_section_ids>>mtimes>>blocks;
+  if(stream.status()!=QDataStream::Ok) {
+    *err_msg="cache file is truncated";
+    return false;
+  }
+  if((filename!=config_filename)||(use_section_ids!=d_use_section_ids)) {
+    *err_msg="cache was made from a different configuration";
+    return false;
+  }
+  for(QMap<QString,qint64>::const_iterator it=mtimes.begin();
+      it!=mtimes.end();it++) {
+    if(ModificationTime(it.key())!=it.value()) {
+      *err_msg=QString::asprintf("\"%s\" has changed",
+				 it.key().toUtf8().constData());
+      return false;
+    }
+  }
+
+  clear();
+  d_blocks=blocks;
+  for(QMap<QString,qint64>::const_iterator it=mtimes.begin();
+      it!=mtimes.end();it++) {
+    d_source_mtimes[it.key()]=it.value();
+  }
+
+  return true;
+}
+
+
+bool Profile::saveCache(const QString &cache_filename,
+			const QString &config_filename,QString *err_msg) const
+{
+  QMap<QString,qint64> mtimes;
+
+  for(QMap<QString,int64_t>::const_iterator it=d_source_mtimes.begin();
+      it!=d_source_mtimes.end();it++) {
+    mtimes[it.key()]=it.value();
+  }
+
+  //
+  // Write to a temporary file first, so that a concurrent reader never
+  // sees a partial cache.
+  //
+  QFile file(cache_filename+".tmp");
+  if(!file.open(QIODevice::WriteOnly|QIODevice::Truncate)) {
+    *err_msg=file.errorString();
+    return false;
+  }
+  QDataStream stream(&file);
+  stream.setVersion(QDataStream::Qt_5_0);
+  stream<<QString(__PROFILE_CACHE_MAGIC)<<(quint32)PROFILE_CACHE_VERSION;
+  stream<<config_filename<<d_use_section_ids<<mtimes<<d_blocks;
+  file.close();
+  if((stream.status()!=QDataStream::Ok)||(file.error()!=QFile::NoError)) {
+    *err_msg=file.errorString();
+    unlink((cache_filename+".tmp").toUtf8());
+    return false;
+  }
+  if(rename((cache_filename+".tmp").toUtf8(),cache_filename.toUtf8())!=0) {
+    *err_msg=strerror(errno);
+    unlink((cache_filename+".tmp").toUtf8());
+    return false;
+  }
+
+  return true;
+}
+
+
 void Profile::ProcessBlock(const QString &name,
 			   const QMap<QString,QStringList> &lines)
 {
@@ -646,6 +776,28 @@ QStringList Profile::InvertList(const QStringList &list) const
 }
 
 
+void Profile::ClearSections()
+{
+  for(QHash<QString,ProfileSection *>::const_iterator it=d_sections.begin();
+      it!=d_sections.end();it++) {
+    delete it.value();
+  }
+  d_sections.clear();
+}
+
+
+int64_t Profile::ModificationTime(const QString &pathname) const
+{
+  struct stat statbuf;
+
+  if(stat(pathname.toUtf8(),&statbuf)!=0) {
+    return -1;
+  }
+
+  return 1000000000ll*(int64_t)statbuf.st_mtim.tv_sec+statbuf.st_mtim.tv_nsec;
+}
+
+
 void Profile::DumpList(const QString &title,const QStringList &list) const
 {
   printf("%s\n",title.toUtf8().constData());
@@ -24,6 +24,9 @@
 #ifndef PROFILE_H
 #define PROFILE_H
 
+#include <stdint.h>
+
+#include <QHash>
 #include <QHostAddress>
 #include <QList>
 #include <QMultiMap>
@@ -31,10 +34,18 @@
 #include <QStringList>
 #include <QTime>
 
+#include "profilesection.h"
+
+//
+// Cache File Format Version
+//
+#define PROFILE_CACHE_VERSION 1
+
 class Profile
 {
  public:
   Profile(bool use_section_ids=false);
+  ~Profile();
   QStringList sectionNames() const;
   QString source() const;
   bool addSource(const QStringList &values);
@@ -44,6 +55,10 @@ class Profile
   int load(const QString &glob_path,QStringList *err_msgs);
   QStringList sections() const;
   QStringList sectionIds(const QString &section) const;
+  QMap<QString,QStringList> sectionValues(const QString &section,
+					  const QString &section_id) const;
+  const ProfileSection *section(const QString &section,
+				const QString &section_id) const;
   QString stringValue(const QString &section,const QString &tag,
 		      const QString &default_value="",bool *found=0);
   QStringList stringValues(const QString &section,const QString &tag);
@@ -83,17 +98,27 @@ class Profile
   QList<QHostAddress> addressValues(const QString &section,
 				    const QString &section_id,
 				    const QString &tag);
+  static bool toBool(const QString &str);
+  static QTime toTime(const QString &str);
 
   void clear();
   QString dump() const;
+  bool loadCache(const QString &cache_filename,const QString &config_filename,
+		 QString *err_msg);
+  bool saveCache(const QString &cache_filename,const QString &config_filename,
+		 QString *err_msg) const;
 
  private:
   void ProcessBlock(const QString &name,
 		    const QMap<QString,QStringList> &lines);
   QStringList InvertList(const QStringList &list) const;
   void DumpList(const QString &title,const QStringList &list) const;
+  void ClearSections();
+  int64_t ModificationTime(const QString &pathname) const;
   QString profile_source;
   QMap<QString,QMap<QString,QStringList> > d_blocks;
+  QMap<QString,int64_t> d_source_mtimes;
+  mutable QHash<QString,ProfileSection *> d_sections;
   bool d_use_section_ids;
 };
 
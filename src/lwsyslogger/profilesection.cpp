@@ -0,0 +1,182 @@
+// profilesection.cpp
+//
+// Typed handle for a single section of a configuration profile.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include "profile.h"
+#include "profilesection.h"
+
+//
+// The typed parameters of each section. Anything not listed here is a
+// string.
+//
+struct __ProfileSectionSchema
+{
+  const char *section;
+  const char *tag;
+  ProfileSection::Type type;
+};
+static const __ProfileSectionSchema __profilesection_schema[]={
+  {"Processor","OverrideTimestamps",ProfileSection::TypeBool},
+  {"Processor","BloomFilter",ProfileSection::TypeBool},
+  {"Processor","BloomFilterTokens",ProfileSection::TypeBool},
+  {"Processor","TrigramIndex",ProfileSection::TypeBool},
+  {"Processor","TrigramIndexSize",ProfileSection::TypeInt},
+  {"Processor","DeduplicationTimeout",ProfileSection::TypeInt},
+  {"Processor","LogRotationAge",ProfileSection::TypeInt},
+  {"Processor","LogRotationSize",ProfileSection::TypeInt64},
+  {"Processor","LogRotationTime",ProfileSection::TypeTime},
+  {"Processor","OldLogPurgeAge",ProfileSection::TypeInt},
+  {"Processor","FlushInterval",ProfileSection::TypeInt},
+  {"Processor","IndexInterval",ProfileSection::TypeInt},
+  {"Processor","EmailThrottleLimit",ProfileSection::TypeInt},
+  {"Processor","EmailThrottlePeriod",ProfileSection::TypeInt},
+  {"Receiver","Port",ProfileSection::TypeInt},
+  {"Receiver","ReceiveBufferSize",ProfileSection::TypeInt},
+  {"LiveTail","Address",ProfileSection::TypeAddress},
+  {"LiveTail","Port",ProfileSection::TypeInt},
+  {"LiveTail","RingSize",ProfileSection::TypeInt},
+  {"RecentMessages","LinesPerHost",ProfileSection::TypeInt},
+  {"RecentMessages","MaxMemory",ProfileSection::TypeInt},
+  {"Metrics","Address",ProfileSection::TypeAddress},
+  {"Metrics","Port",ProfileSection::TypeInt},
+  {NULL,NULL,ProfileSection::TypeString}
+};
+
+ProfileSection::ProfileSection(const QString &name,const QString &id,
+			       const QMap<QString,QStringList> &values)
+{
+  d_name=name;
+  d_id=id;
+
+  //
+  // Convert each value once, here, into the type declared for its tag
+  //
+  for(QMap<QString,QStringList>::const_iterator it=values.begin();
+      it!=values.end();it++) {
+    d_strings.insert(it.key(),it.value());
+    switch(tagType(name,it.key())) {
+    case ProfileSection::TypeInt:
+      for(int i=0;i<it.value().size();i++) {
+	d_ints[it.key()].push_back(it.value().at(i).toInt());
+      }
+      break;
+
+    case ProfileSection::TypeInt64:
+      for(int i=0;i<it.value().size();i++) {
+	d_int64s[it.key()].push_back(it.value().at(i).toLongLong());
+      }
+      break;
+
+    case ProfileSection::TypeBool:
+      for(int i=0;i<it.value().size();i++) {
+	d_bools[it.key()].push_back(Profile::toBool(it.value().at(i)));
+      }
+      break;
+
+    case ProfileSection::TypeTime:
+      for(int i=0;i<it.value().size();i++) {
+	d_times[it.key()].push_back(Profile::toTime(it.value().at(i)));
+      }
+      break;
+
+    case ProfileSection::TypeAddress:
+      for(int i=0;i<it.value().size();i++) {
+	d_addresses[it.key()].push_back(QHostAddress(it.value().at(i)));
+      }
+      break;
+
+    case ProfileSection::TypeString:
+      break;
+    }
+  }
+}
+
+
+QString ProfileSection::name() const
+{
+  return d_name;
+}
+
+
+QString ProfileSection::id() const
+{
+  return d_id;
+}
+
+
+QStringList ProfileSection::tags() const
+{
+  return d_strings.keys();
+}
+
+
+bool ProfileSection::contains(const QString &tag) const
+{
+  return d_strings.contains(tag);
+}
+
+
+QStringList ProfileSection::stringValues(const QString &tag) const
+{
+  return d_strings.value(tag);
+}
+
+
+QList<int> ProfileSection::intValues(const QString &tag) const
+{
+  return d_ints.value(tag);
+}
+
+
+QList<int64_t> ProfileSection::int64Values(const QString &tag) const
+{
+  return d_int64s.value(tag);
+}
+
+
+QList<bool> ProfileSection::boolValues(const QString &tag) const
+{
+  return d_bools.value(tag);
+}
+
+
+QList<QTime> ProfileSection::timeValues(const QString &tag) const
+{
+  return d_times.value(tag);
+}
+
+
+QList<QHostAddress> ProfileSection::addressValues(const QString &tag) const
+{
+  return d_addresses.value(tag);
+}
+
+
+ProfileSection::Type ProfileSection::tagType(const QString &section,
+					     const QString &tag)
+{
+  for(int i=0;__profilesection_schema[i].section!=NULL;i++) {
+    if((section==__profilesection_schema[i].section)&&
+       (tag==__profilesection_schema[i].tag)) {
+      return __profilesection_schema[i].type;
+    }
+  }
+
+  return ProfileSection::TypeString;
+}
@@ -0,0 +1,65 @@
+// profilesection.h
+//
+// Typed handle for a single section of a configuration profile.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef PROFILESECTION_H
+#define PROFILESECTION_H
+
+#include <stdint.h>
+
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QTime>
+
+class ProfileSection
+{
+ public:
+  enum Type {TypeString=0,TypeInt=1,TypeBool=2,TypeTime=3,TypeAddress=4,
+	     TypeInt64=5};
+  ProfileSection(const QString &name,const QString &id,
+		 const QMap<QString,QStringList> &values);
+  QString name() const;
+  QString id() const;
+  QStringList tags() const;
+  bool contains(const QString &tag) const;
+  QStringList stringValues(const QString &tag) const;
+  QList<int> intValues(const QString &tag) const;
+  QList<int64_t> int64Values(const QString &tag) const;
+  QList<bool> boolValues(const QString &tag) const;
+  QList<QTime> timeValues(const QString &tag) const;
+  QList<QHostAddress> addressValues(const QString &tag) const;
+  static Type tagType(const QString &section,const QString &tag);
+
+ private:
+  QString d_name;
+  QString d_id;
+  QHash<QString,QStringList> d_strings;
+  QHash<QString,QList<int> > d_ints;
+  QHash<QString,QList<int64_t> > d_int64s;
+  QHash<QString,QList<bool> > d_bools;
+  QHash<QString,QList<QTime> > d_times;
+  QHash<QString,QList<QHostAddress> > d_addresses;
+};
+
+
+#endif  // PROFILESECTION_H
@@ -39,6 +39,12 @@ QString Receiver::id() const
 }
 
 
+QList<int> Receiver::socketDescriptors() const
+{
+  return QList<int>();
+}
+
+
 Profile *Receiver::profile() const
 {
   return d_profile;
@@ -24,6 +24,7 @@
 #ifndef RECEIVER_H
 #define RECEIVER_H
 
+#include <QList>
 #include <QMap>
 #include <QObject>
 
@@ -39,6 +40,8 @@ class Receiver : public QObject
   QString id() const;
   virtual Type type() const=0;
   virtual bool start(QString *err_msg)=0;
+  virtual QList<int> socketDescriptors() const;
+  Profile *profile() const;
   static QString typeString(Type type);
   static Type typeFromString(const QString &str);
 
@@ -47,7 +50,6 @@ class Receiver : public QObject
 
  protected:
   void forwardMessage(Message *msg,const QHostAddress &from_addr);
-  Profile *profile() const;
   void lsyslog(Message::Severity severity,const char *fmt,...) const;
 
  private:
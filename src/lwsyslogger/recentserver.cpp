@@ -0,0 +1,216 @@
+// recentserver.cpp
+//
+// Keep recent messages per host in memory, and serve them to clients.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <QDateTime>
+#include <QList>
+
+#include "recentserver.h"
+
+RecentServer::RecentServer(const QString &id,int lines_per_host,
+			   int64_t max_memory,const QString &tmpl,
+			   QObject *parent)
+  : QObject(parent)
+{
+  d_store=new RecentStore(lines_per_host,max_memory);
+  d_template=tmpl;
+  d_server=NULL;
+  d_socket_inode=0;
+  d_hosts_gauge=Metrics::gauge("recent",id,"hosts",
+			       "Hosts with recent messages held in memory");
+  d_memory_gauge=Metrics::gauge("recent",id,"memory_bytes",
+				"Memory used by recent messages");
+  d_evictions_counter=Metrics::counter("recent",id,"host_evictions",
+			 "Hosts evicted from memory to stay under the cap");
+}
+
+
+RecentServer::~RecentServer()
+{
+  stop();
+  delete d_store;
+}
+
+
+bool RecentServer::listen(const QString &socket_path,QString *err_msg)
+{
+  struct stat st;
+
+  d_socket_path=socket_path;
+  d_server=new QLocalServer(this);
+  d_server->setSocketOptions(QLocalServer::UserAccessOption|
+			     QLocalServer::GroupAccessOption);
+  connect(d_server,SIGNAL(newConnection()),this,SLOT(newConnectionData()));
+  QLocalServer::removeServer(d_socket_path);
+  if(!d_server->listen(d_socket_path)) {
+    *err_msg=d_server->errorString();
+    return false;
+  }
+  if(stat(d_socket_path.toUtf8(),&st)==0) {
+    d_socket_inode=st.st_ino;
+  }
+
+  return true;
+}
+
+
+void RecentServer::stop()
+{
+  struct stat st;
+
+  //
+  // After a takeover, the path may already belong to the new instance.
+  //
+  if((d_server!=NULL)&&(stat(d_socket_path.toUtf8(),&st)==0)&&
+     (st.st_ino==d_socket_inode)) {
+    unlink(d_socket_path.toUtf8());
+  }
+}
+
+
+void RecentServer::process(Message *msg,const QHostAddress &from_addr)
+{
+  int64_t timestamp=msg->receiveTime();
+  if(timestamp<=0) {
+    timestamp=Metrics::realtimeNsec();
+  }
+  QString hostname=msg->hostName();
+  if(hostname.isEmpty()) {
+    hostname=from_addr.toString();
+  }
+  uint64_t evictions=d_store->evictions();
+  d_store->append(hostname.toLower().toUtf8(),timestamp/1000000000,
+		  msg->resolveWildcards(d_template,from_addr).toUtf8());
+  d_hosts_gauge->set(d_store->hosts());
+  d_memory_gauge->set(d_store->memory());
+  if(d_store->evictions()!=evictions) {
+    d_evictions_counter->increment(d_store->evictions()-evictions);
+  }
+}
+
+
+void RecentServer::newConnectionData()
+{
+  QLocalSocket *sock=NULL;
+
+  while((sock=d_server->nextPendingConnection())!=NULL) {
+    connect(sock,SIGNAL(readyRead()),this,SLOT(readyReadData()));
+    connect(sock,SIGNAL(disconnected()),this,SLOT(disconnectedData()));
+    d_requests[sock]=QByteArray();
+  }
+}
+
+
+void RecentServer::readyReadData()
+{
+  QLocalSocket *sock=(QLocalSocket *)sender();
+
+  if(!d_requests.contains(sock)) {
+    sock->readAll();  // Already answered
+    return;
+  }
+  QByteArray req=d_requests.value(sock)+sock->readAll();
+  int nl=req.indexOf('\n');
+  if(nl<0) {
+    if(req.size()>RECENTSERVER_MAX_REQUEST_SIZE) {
+      sock->write(RECENTSERVER_ERROR " request too long\n");
+      d_requests.remove(sock);
+      sock->disconnectFromServer();
+    }
+    else {
+      d_requests[sock]=req;
+    }
+    return;
+  }
+
+  //
+  // One request per connection. Any output still pending is written out
+  // before the connection closes.
+  //
+  d_requests.remove(sock);
+  sock->write(Reply(req.left(nl).trimmed()));
+  sock->disconnectFromServer();
+}
+
+
+void RecentServer::disconnectedData()
+{
+  QLocalSocket *sock=(QLocalSocket *)sender();
+
+  d_requests.remove(sock);
+  sock->deleteLater();
+}
+
+
+QByteArray RecentServer::Reply(const QByteArray &req) const
+{
+  QByteArray ret;
+  QList<QByteArray> f0=req.split(' ');
+  QList<QByteArray> f1;
+  bool ok=false;
+
+  for(int i=0;i<f0.size();i++) {
+    if(!f0.at(i).isEmpty()) {
+      f1.push_back(f0.at(i));
+    }
+  }
+
+  //
+  // HOSTS
+  //
+  // One line per host, most recently active first:
+  //   <host> <lines-held> <lines-received> <last-active>
+  //
+  if((f1.size()==1)&&(f1.at(0)==RECENTSERVER_HOSTS)) {
+    QList<RecentStore::HostInfo> hosts=d_store->hostList();
+    for(int i=0;i<hosts.size();i++) {
+      ret+=hosts.at(i).name+" "+QByteArray::number(hosts.at(i).lines)+" "+
+	QByteArray::number((qulonglong)hosts.at(i).received)+" "+
+	QDateTime::fromMSecsSinceEpoch(1000ll*hosts.at(i).lastActive).
+	toString("yyyy-MM-ddThh:mm:ss").toUtf8()+"\n";
+    }
+    return ret;
+  }
+
+  //
+  // LINES <host> <since> <limit>
+  //
+  // Lines held for <host> received at or after <since> (seconds since
+  // the epoch), limited to the last <limit> of them. Zero means no limit.
+  //
+  if((f1.size()==4)&&(f1.at(0)==RECENTSERVER_LINES)) {
+    qlonglong since=f1.at(2).toLongLong(&ok);
+    if(ok&&(since>=0)) {
+      int limit=f1.at(3).toInt(&ok);
+      if(ok&&(limit>=0)) {
+	QList<QByteArray> lines=
+	  d_store->lines(f1.at(1).toLower(),since,limit);
+	for(int i=0;i<lines.size();i++) {
+	  ret+=lines.at(i)+"\n";
+	}
+	return ret;
+      }
+    }
+  }
+
+  return RECENTSERVER_ERROR " malformed request\n";
+}
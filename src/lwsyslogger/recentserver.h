@@ -0,0 +1,81 @@
+// recentserver.h
+//
+// Keep recent messages per host in memory, and serve them to clients.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef RECENTSERVER_H
+#define RECENTSERVER_H
+
+#include <sys/types.h>
+
+#include <QHostAddress>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QMap>
+#include <QObject>
+
+#include "message.h"
+#include "metrics.h"
+#include "recentstore.h"
+
+//
+// Protocol Values
+//
+#define RECENTSERVER_HOSTS "HOSTS"
+#define RECENTSERVER_LINES "LINES"
+#define RECENTSERVER_ERROR "#ERROR"
+#define RECENTSERVER_MAX_REQUEST_SIZE 1024
+
+//
+// Defaults
+//
+#define RECENTSERVER_DEFAULT_TEMPLATE "%t %h %m"
+
+class RecentServer : public QObject
+{
+  Q_OBJECT
+ public:
+  RecentServer(const QString &id,int lines_per_host,int64_t max_memory,
+	       const QString &tmpl,QObject *parent=0);
+  ~RecentServer();
+  bool listen(const QString &socket_path,QString *err_msg);
+  void stop();
+
+ public slots:
+  void process(Message *msg,const QHostAddress &from_addr);
+
+ private slots:
+  void newConnectionData();
+  void readyReadData();
+  void disconnectedData();
+
+ private:
+  QByteArray Reply(const QByteArray &req) const;
+  RecentStore *d_store;
+  QString d_template;
+  QLocalServer *d_server;
+  QString d_socket_path;
+  ino_t d_socket_inode;
+  QMap<QLocalSocket *,QByteArray> d_requests;
+  MetricsGauge *d_hosts_gauge;
+  MetricsGauge *d_memory_gauge;
+  MetricsCounter *d_evictions_counter;
+};
+
+
+#endif  // RECENTSERVER_H
@@ -0,0 +1,275 @@
+// recentstore.cpp
+//
+// In-memory rings of recent messages, one per host.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <algorithm>
+
+#include "recentstore.h"
+
+RecentStore::RecentStore(int lines_per_host,int64_t max_memory)
+{
+  d_lines_per_host=lines_per_host;
+  d_max_memory=max_memory;
+  d_memory=0;
+  d_evictions=0;
+  d_most_active=-1;
+  d_least_active=-1;
+}
+
+
+RecentStore::~RecentStore()
+{
+  for(int i=0;i<d_hosts.size();i++) {
+    delete d_hosts.at(i);
+  }
+}
+
+
+int RecentStore::linesPerHost() const
+{
+  return d_lines_per_host;
+}
+
+
+int64_t RecentStore::maxMemory() const
+{
+  return d_max_memory;
+}
+
+
+int RecentStore::hosts() const
+{
+  return d_ids.size();
+}
+
+
+int64_t RecentStore::memory() const
+{
+  return d_memory;
+}
+
+
+uint64_t RecentStore::evictions() const
+{
+  return d_evictions;
+}
+
+
+void RecentStore::append(const QByteArray &host,time_t when,
+			 const QByteArray &line)
+{
+  int id=Intern(host);
+  Host *h=d_hosts.at(id);
+
+  //
+  // Each ring grows on demand up to its full size, then wraps. Slots
+  // behind the oldest line are kept empty, so the one being written
+  // holds the oldest line only when the ring is full.
+  //
+  if(h->entries.size()<d_lines_per_host) {
+    h->entries.push_back(Entry());
+  }
+  Entry *e=h->entries.data()+h->next;
+  if(h->count==h->entries.size()) {
+    h->memory-=e->line.size()+RECENTSTORE_LINE_OVERHEAD;
+    d_memory-=e->line.size()+RECENTSTORE_LINE_OVERHEAD;
+    h->count--;
+  }
+  e->when=when;
+  e->line=line;
+  h->memory+=line.size()+RECENTSTORE_LINE_OVERHEAD;
+  d_memory+=line.size()+RECENTSTORE_LINE_OVERHEAD;
+  h->count++;
+  if(++h->next==d_lines_per_host) {
+    h->next=0;
+  }
+  h->received++;
+  h->last_active=when;
+  Touch(id);
+
+  //
+  // Enforce the memory cap, evicting the least recently active hosts
+  // first. Only when this host is all that is left do we trim its own
+  // ring, always keeping the line just added.
+  //
+  while(d_memory>d_max_memory) {
+    if(d_least_active!=id) {
+      Evict(d_least_active);
+    }
+    else {
+      if(h->count<=1) {
+	break;
+      }
+      DropOldest(h);
+    }
+  }
+}
+
+
+QList<RecentStore::HostInfo> RecentStore::hostList() const
+{
+  QList<RecentStore::HostInfo> ret;
+
+  for(int id=d_most_active;id>=0;id=d_hosts.at(id)->next_id) {
+    const Host *h=d_hosts.at(id);
+    RecentStore::HostInfo info;
+    info.name=h->name;
+    info.lines=h->count;
+    info.received=h->received;
+    info.lastActive=h->last_active;
+    ret.push_back(info);
+  }
+
+  return ret;
+}
+
+
+QList<QByteArray> RecentStore::lines(const QByteArray &host,time_t since,
+				     int limit) const
+{
+  QList<QByteArray> ret;
+
+  QHash<QByteArray,int>::const_iterator it=d_ids.find(host);
+  if(it==d_ids.end()) {
+    return ret;
+  }
+  const Host *h=d_hosts.at(it.value());
+  int size=h->entries.size();
+
+  //
+  // Walk backward from the newest line, then put the result in order
+  //
+  int pos=h->next;
+  for(int i=0;i<h->count;i++) {
+    if(--pos<0) {
+      pos=size-1;
+    }
+    const Entry &e=h->entries.at(pos);
+    if((e.when<since)||((limit>0)&&(ret.size()>=limit))) {
+      break;
+    }
+    ret.push_back(e.line);
+  }
+  std::reverse(ret.begin(),ret.end());
+
+  return ret;
+}
+
+
+int RecentStore::Intern(const QByteArray &name)
+{
+  QHash<QByteArray,int>::const_iterator it=d_ids.find(name);
+  if(it!=d_ids.end()) {
+    return it.value();
+  }
+
+  int id=-1;
+  Host *h=new Host();
+  h->name=name;
+  h->next=0;
+  h->count=0;
+  h->memory=0;
+  h->received=0;
+  h->last_active=0;
+  h->prev_id=-1;
+  h->next_id=-1;
+  if(d_free_ids.isEmpty()) {
+    id=d_hosts.size();
+    d_hosts.push_back(h);
+  }
+  else {
+    id=d_free_ids.takeLast();
+    d_hosts[id]=h;
+  }
+  d_ids[name]=id;
+  d_memory+=name.size()+RECENTSTORE_HOST_OVERHEAD;
+
+  return id;
+}
+
+
+void RecentStore::Touch(int id)
+{
+  if(d_most_active==id) {
+    return;
+  }
+  Unlink(id);
+  Host *h=d_hosts.at(id);
+  h->prev_id=-1;
+  h->next_id=d_most_active;
+  if(d_most_active>=0) {
+    d_hosts.at(d_most_active)->prev_id=id;
+  }
+  d_most_active=id;
+  if(d_least_active<0) {
+    d_least_active=id;
+  }
+}
+
+
+void RecentStore::Unlink(int id)
+{
+  Host *h=d_hosts.at(id);
+
+  if(h->prev_id>=0) {
+    d_hosts.at(h->prev_id)->next_id=h->next_id;
+  }
+  else {
+    if(d_most_active==id) {
+      d_most_active=h->next_id;
+    }
+  }
+  if(h->next_id>=0) {
+    d_hosts.at(h->next_id)->prev_id=h->prev_id;
+  }
+  else {
+    if(d_least_active==id) {
+      d_least_active=h->prev_id;
+    }
+  }
+  h->prev_id=-1;
+  h->next_id=-1;
+}
+
+
+void RecentStore::Evict(int id)
+{
+  Host *h=d_hosts.at(id);
+
+  Unlink(id);
+  d_memory-=h->memory+h->name.size()+RECENTSTORE_HOST_OVERHEAD;
+  d_ids.remove(h->name);
+  d_hosts[id]=NULL;
+  d_free_ids.push_back(id);
+  d_evictions++;
+  delete h;
+}
+
+
+void RecentStore::DropOldest(Host *host)
+{
+  int size=host->entries.size();
+  int pos=(host->next-host->count+size)%size;
+  Entry *e=host->entries.data()+pos;
+
+  host->memory-=e->line.size()+RECENTSTORE_LINE_OVERHEAD;
+  d_memory-=e->line.size()+RECENTSTORE_LINE_OVERHEAD;
+  e->line=QByteArray();
+  host->count--;
+}
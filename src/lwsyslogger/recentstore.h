@@ -0,0 +1,100 @@
+// recentstore.h
+//
+// In-memory rings of recent messages, one per host.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef RECENTSTORE_H
+#define RECENTSTORE_H
+
+#include <stdint.h>
+#include <time.h>
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QVector>
+
+//
+// Defaults
+//
+#define RECENTSTORE_DEFAULT_LINES_PER_HOST 1000
+#define RECENTSTORE_DEFAULT_MAX_MEMORY 67108864
+
+//
+// Approximate bookkeeping cost, in bytes, charged against the memory
+// cap for each stored line and each known host.
+//
+#define RECENTSTORE_LINE_OVERHEAD 48
+#define RECENTSTORE_HOST_OVERHEAD 160
+
+class RecentStore
+{
+ public:
+  struct HostInfo {
+    QByteArray name;
+    int lines;
+    uint64_t received;
+    time_t lastActive;
+  };
+  RecentStore(int lines_per_host=RECENTSTORE_DEFAULT_LINES_PER_HOST,
+	      int64_t max_memory=RECENTSTORE_DEFAULT_MAX_MEMORY);
+  ~RecentStore();
+  int linesPerHost() const;
+  int64_t maxMemory() const;
+  int hosts() const;
+  int64_t memory() const;
+  uint64_t evictions() const;
+  void append(const QByteArray &host,time_t when,const QByteArray &line);
+  QList<HostInfo> hostList() const;
+  QList<QByteArray> lines(const QByteArray &host,time_t since,
+			  int limit) const;
+
+ private:
+  struct Entry {
+    time_t when;
+    QByteArray line;
+  };
+  struct Host {
+    QByteArray name;
+    QVector<Entry> entries;
+    int next;
+    int count;
+    int64_t memory;
+    uint64_t received;
+    time_t last_active;
+    int prev_id;
+    int next_id;
+  };
+  int Intern(const QByteArray &name);
+  void Touch(int id);
+  void Unlink(int id);
+  void Evict(int id);
+  void DropOldest(Host *host);
+  int d_lines_per_host;
+  int64_t d_max_memory;
+  int64_t d_memory;
+  uint64_t d_evictions;
+  QHash<QByteArray,int> d_ids;
+  QVector<Host *> d_hosts;
+  QList<int> d_free_ids;
+  int d_most_active;
+  int d_least_active;
+};
+
+
+#endif  // RECENTSTORE_H
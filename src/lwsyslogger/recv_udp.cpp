@@ -21,18 +21,59 @@
 //   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 //
 
-#include <QNetworkDatagram>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <time.h>
 
+#include <QFile>
+#include <QStringList>
+
+#include "listensockets.h"
 #include "recv_udp.h"
 
 RecvUdp::RecvUdp(const QString &id,Profile *p,QObject *parent)
   : Receiver(id,p,parent)
 {
-  d_socket=new QUdpSocket(this);
-  connect(d_socket,SIGNAL(readyRead()),this,SLOT(readyReadData()));
-  connect(d_socket,SIGNAL(error(QAbstractSocket::SocketError)),
-	  this,SLOT(errorData(QAbstractSocket::SocketError)));
-  
+  d_fd=-1;
+  d_notifier=NULL;
+  d_rxq_ovfl=false;
+  d_kernel_drops=0;
+  d_reported_drops=0;
+  d_buffer.resize(RECVUDP_MAX_DATAGRAM_SIZE);
+
+  d_datagrams_counter=Metrics::counter("receiver",id,"datagrams_received",
+				      "Datagrams received");
+  d_bytes_counter=Metrics::counter("receiver",id,"bytes_received",
+				   "Bytes received");
+  d_invalid_counter=Metrics::counter("receiver",id,"messages_invalid",
+				     "Datagrams discarded as invalid messages");
+  d_drops_counter=Metrics::counter("receiver",id,"kernel_drops",
+			"Datagrams dropped by the kernel for lack of buffer space");
+  d_queue_gauge=Metrics::gauge("receiver",id,"receive_queue_bytes",
+			       "Bytes waiting in the socket receive queue");
+  d_buffer_gauge=Metrics::gauge("receiver",id,"receive_buffer_bytes",
+				"Size of the socket receive buffer");
+
+  d_sample_timer=new QTimer(this);
+  d_sample_timer->setTimerType(Qt::CoarseTimer);
+  connect(d_sample_timer,SIGNAL(timeout()),this,SLOT(sampleData()));
+}
+
+
+RecvUdp::~RecvUdp()
+{
+  if(d_notifier!=NULL) {
+    delete d_notifier;
+  }
+  if(d_fd>=0) {
+    close(d_fd);
+  }
 }
 
 
@@ -44,8 +85,9 @@ Receiver::Type RecvUdp::type() const
 
 bool RecvUdp::start(QString *err_msg)
 {
-  QList<int> ivalues=profile()->intValues("Receiver",id(),"Port");
-  unsigned udp_port=514;  // Default value
+  const ProfileSection *cfg=profile()->section("Receiver",id());
+  QList<int> ivalues=cfg->intValues("Port");
+  unsigned udp_port=RECVUDP_DEFAULT_PORT;  // Default value
   if(!ivalues.isEmpty()) {
     udp_port=ivalues.last();
   }
@@ -53,9 +95,224 @@ bool RecvUdp::start(QString *err_msg)
     *err_msg=QObject::tr("invalid port specified");
     return false;
   }
-  if(!d_socket->bind(udp_port)) {
+
+  //
+  // Use an already bound socket if one was passed to us
+  //
+  if((d_fd=ListenSockets::take(SOCK_DGRAM,udp_port))>=0) {
+    fcntl(d_fd,F_SETFL,fcntl(d_fd,F_GETFL)|O_NONBLOCK);
+    lsyslog(Message::SeverityDebug,"using inherited socket for udp port %u",
+	    udp_port);
+  }
+  else {
+    if(!Bind(udp_port,err_msg)) {
+      return false;
+    }
+  }
+
+  //
+  // Kernel Drop Counts
+  //
+  int64_t rx_queue=0;
+  int64_t drops=0;
+  if(ReadQueueStats(&rx_queue,&drops)) {
+    d_kernel_drops=drops;
+  }
+  //
+  // Both SO_RXQ_OVFL and /proc/net/udp report the same kernel counter,
+  // so only one of them may be used to advance the baseline.
+  //
+  int one=1;
+  if(setsockopt(d_fd,SOL_SOCKET,SO_RXQ_OVFL,&one,sizeof(one))==0) {
+    d_rxq_ovfl=true;
+  }
+  else {
+    lsyslog(Message::SeverityWarning,"unable to enable SO_RXQ_OVFL [%s]",
+	    strerror(errno));
+  }
+
+  //
+  // Kernel Receive Timestamps
+  //
+  if(setsockopt(d_fd,SOL_SOCKET,SO_TIMESTAMPNS,&one,sizeof(one))!=0) {
+    lsyslog(Message::SeverityWarning,"unable to enable SO_TIMESTAMPNS [%s]",
+	    strerror(errno));
+  }
+
+  //
+  // Receive Buffer Size
+  //
+  ivalues=cfg->intValues("ReceiveBufferSize");
+  if(!ivalues.isEmpty()) {
+    if(ivalues.last()<=0) {
+      *err_msg=QObject::tr("invalid ReceiveBufferSize specified");
+      return false;
+    }
+    SetReceiveBuffer(ivalues.last());
+  }
+  int bufsize=0;
+  socklen_t len=sizeof(bufsize);
+  if(getsockopt(d_fd,SOL_SOCKET,SO_RCVBUF,&bufsize,&len)==0) {
+    d_buffer_gauge->set(bufsize);
+  }
+
+  d_notifier=new QSocketNotifier(d_fd,QSocketNotifier::Read,this);
+  connect(d_notifier,SIGNAL(activated(int)),this,SLOT(readyReadData(int)));
+  d_sample_timer->start(RECVUDP_SAMPLE_INTERVAL);
+
+  return true;
+}
+
+
+QList<int> RecvUdp::socketDescriptors() const
+{
+  QList<int> ret;
+
+  if(d_fd>=0) {
+    ret.push_back(d_fd);
+  }
+
+  return ret;
+}
+
+
+void RecvUdp::readyReadData(int fd)
+{
+  struct sockaddr_storage sa;
+  struct msghdr msg;
+  struct iovec iov;
+  char control[CMSG_SPACE(sizeof(uint32_t))+
+	       CMSG_SPACE(sizeof(struct timespec))];
+  ssize_t n;
+
+  //
+  // Read a bounded number of datagrams per wakeup, so that one busy
+  // socket can't starve the rest of the event loop.
+  //
+  for(int i=0;i<RECVUDP_MAX_BATCH;i++) {
+    memset(&msg,0,sizeof(msg));
+    iov.iov_base=d_buffer.data();
+    iov.iov_len=d_buffer.size();
+    msg.msg_name=&sa;
+    msg.msg_namelen=sizeof(sa);
+    msg.msg_iov=&iov;
+    msg.msg_iovlen=1;
+    msg.msg_control=control;
+    msg.msg_controllen=sizeof(control);
+    if((n=recvmsg(fd,&msg,0))<0) {
+      if((errno!=EAGAIN)&&(errno!=EWOULDBLOCK)&&(errno!=EINTR)) {
+	lsyslog(Message::SeverityWarning,"recvmsg failed [%s]",
+		strerror(errno));
+      }
+      return;
+    }
+    int64_t receive_time=0;
+    for(struct cmsghdr *cmsg=CMSG_FIRSTHDR(&msg);cmsg!=NULL;
+	cmsg=CMSG_NXTHDR(&msg,cmsg)) {
+      if((cmsg->cmsg_level==SOL_SOCKET)&&(cmsg->cmsg_type==SCM_TIMESTAMPNS)) {
+	struct timespec ts;
+	memcpy(&ts,CMSG_DATA(cmsg),sizeof(ts));
+	receive_time=1000000000ll*(int64_t)ts.tv_sec+ts.tv_nsec;
+      }
+      if((cmsg->cmsg_level==SOL_SOCKET)&&(cmsg->cmsg_type==SO_RXQ_OVFL)) {
+	//
+	// The count can arrive out of order relative to a reading taken
+	// earlier in this batch, so never let the baseline move backward.
+	//
+	uint32_t drops;
+	memcpy(&drops,CMSG_DATA(cmsg),sizeof(drops));
+	int32_t delta=(int32_t)(drops-d_kernel_drops);
+	if(delta>0) {
+	  d_drops_counter->increment(delta);
+	  d_kernel_drops=drops;
+	}
+      }
+    }
+    d_datagrams_counter->increment();
+    d_bytes_counter->increment(n);
+
+    //
+    // Report IPv4 senders as such, rather than as mapped IPv6 addresses
+    //
+    bool ok=false;
+    QHostAddress from_addr((struct sockaddr *)&sa);
+    quint32 addr4=from_addr.toIPv4Address(&ok);
+    if(ok) {
+      from_addr=QHostAddress(addr4);
+    }
+    Message *m=new Message(QByteArray(d_buffer.constData(),n));
+    if(receive_time==0) {
+      receive_time=Metrics::realtimeNsec();
+    }
+    m->setReceiveTime(receive_time);
+    if(m->isValid()) {
+      forwardMessage(m,from_addr);
+    }
+    else {
+      d_invalid_counter->increment();
+    }
+    delete m;
+  }
+}
+
+
+void RecvUdp::sampleData()
+{
+  int64_t rx_queue=0;
+  int64_t drops=0;
+
+  if(ReadQueueStats(&rx_queue,&drops)) {
+    d_queue_gauge->set(rx_queue);
+    int32_t delta=(int32_t)((uint32_t)drops-d_kernel_drops);
+    if((!d_rxq_ovfl)&&(delta>0)) {
+      d_drops_counter->increment(delta);
+      d_kernel_drops=drops;
+    }
+  }
+  uint64_t total=d_drops_counter->value();
+  if(total>d_reported_drops) {
+    lsyslog(Message::SeverityWarning,
+	    "kernel dropped %" PRIu64 " datagram(s) in the last %d seconds",
+	    total-d_reported_drops,RECVUDP_SAMPLE_INTERVAL/1000);
+    d_reported_drops=total;
+  }
+}
+
+
+bool RecvUdp::Bind(uint16_t port,QString *err_msg)
+{
+  int zero=0;
+  struct sockaddr_in6 sa6;
+  struct sockaddr_in sa4;
+
+  //
+  // Prefer a dual-stack socket, falling back to IPv4 only
+  //
+  if((d_fd=socket(AF_INET6,SOCK_DGRAM|SOCK_NONBLOCK|SOCK_CLOEXEC,0))>=0) {
+    setsockopt(d_fd,IPPROTO_IPV6,IPV6_V6ONLY,&zero,sizeof(zero));
+    memset(&sa6,0,sizeof(sa6));
+    sa6.sin6_family=AF_INET6;
+    sa6.sin6_addr=in6addr_any;
+    sa6.sin6_port=htons(port);
+    if(bind(d_fd,(struct sockaddr *)&sa6,sizeof(sa6))==0) {
+      return true;
+    }
+    close(d_fd);
+  }
+  if((d_fd=socket(AF_INET,SOCK_DGRAM|SOCK_NONBLOCK|SOCK_CLOEXEC,0))<0) {
+    *err_msg=QObject::tr("failed to create udp socket")+
+      QString::asprintf(" [%s]",strerror(errno));
+    return false;
+  }
+  memset(&sa4,0,sizeof(sa4));
+  sa4.sin_family=AF_INET;
+  sa4.sin_addr.s_addr=htonl(INADDR_ANY);
+  sa4.sin_port=htons(port);
+  if(bind(d_fd,(struct sockaddr *)&sa4,sizeof(sa4))!=0) {
     *err_msg=QObject::tr("failed to bind udp port")+
-      QString::asprintf(" %u",udp_port);
+      QString::asprintf(" %u [%s]",port,strerror(errno));
+    close(d_fd);
+    d_fd=-1;
     return false;
   }
 
@@ -63,17 +320,65 @@ bool RecvUdp::start(QString *err_msg)
 }
 
 
-void RecvUdp::readyReadData()
+void RecvUdp::SetReceiveBuffer(int bytes)
 {
-  QNetworkDatagram dg=d_socket->receiveDatagram();
-  Message *msg=new Message(dg.data());
-  if(msg->isValid()) {
-    forwardMessage(msg,dg.senderAddress());
+  //
+  // SO_RCVBUFFORCE can exceed net.core.rmem_max, but needs
+  // CAP_NET_ADMIN. Note that the kernel doubles the value given.
+  //
+  if(setsockopt(d_fd,SOL_SOCKET,SO_RCVBUFFORCE,&bytes,sizeof(bytes))==0) {
+    return;
+  }
+  if(setsockopt(d_fd,SOL_SOCKET,SO_RCVBUF,&bytes,sizeof(bytes))!=0) {
+    lsyslog(Message::SeverityWarning,"unable to set receive buffer size [%s]",
+	    strerror(errno));
+    return;
+  }
+  int actual=0;
+  socklen_t len=sizeof(actual);
+  if((getsockopt(d_fd,SOL_SOCKET,SO_RCVBUF,&actual,&len)==0)&&
+     (actual<bytes)) {
+    lsyslog(Message::SeverityWarning,
+	    "receive buffer limited to %d bytes by net.core.rmem_max",
+	    actual/2);
   }
-  delete msg;
 }
 
 
-void RecvUdp::errorData(QAbstractSocket::SocketError err)
+bool RecvUdp::ReadQueueStats(int64_t *rx_queue,int64_t *drops) const
 {
+  //
+  // SIOCINQ only reports the size of the next datagram for UDP, so look
+  // the socket up by inode in /proc/net/udp[6] for the whole queue.
+  //
+  struct stat statbuf;
+  bool ok=false;
+
+  if(fstat(d_fd,&statbuf)!=0) {
+    return false;
+  }
+  QString inode=QString::asprintf("%lu",(unsigned long)statbuf.st_ino);
+  QStringList tables;
+  tables.push_back("/proc/net/udp6");
+  tables.push_back("/proc/net/udp");
+  for(int i=0;i<tables.size();i++) {
+    QFile file(tables.at(i));
+    if(!file.open(QIODevice::ReadOnly)) {
+      continue;
+    }
+    QList<QByteArray> lines=file.readAll().split('\n');
+    for(int j=1;j<lines.size();j++) {
+      QList<QByteArray> f0=lines.at(j).simplified().split(' ');
+      if((f0.size()>=13)&&(f0.at(9)==inode)) {
+	QList<QByteArray> f1=f0.at(4).split(':');
+	if(f1.size()==2) {
+	  *rx_queue=f1.at(1).toLongLong(&ok,16);
+	  *drops=f0.last().toLongLong();
+	  return ok;
+	}
+      }
+    }
+  }
+
+  return false;
 }
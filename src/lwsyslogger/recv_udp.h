@@ -24,24 +24,54 @@
 #ifndef RECV_UDP_H
 #define RECV_UDP_H
 
-#include <QUdpSocket>
+#include <stdint.h>
 
+#include <QByteArray>
+#include <QSocketNotifier>
+#include <QTimer>
+
+#include "metrics.h"
 #include "receiver.h"
 
+//
+// Defaults
+//
+#define RECVUDP_DEFAULT_PORT 514
+#define RECVUDP_MAX_DATAGRAM_SIZE 65536
+#define RECVUDP_MAX_BATCH 64
+#define RECVUDP_SAMPLE_INTERVAL 10000
+
 class RecvUdp : public Receiver
 {
   Q_OBJECT
  public:
   RecvUdp(const QString &id,Profile *p,QObject *parent);
+  ~RecvUdp();
   Receiver::Type type() const;
   bool start(QString *err_msg);
+  QList<int> socketDescriptors() const;
   
  private slots:
-  void readyReadData();
-  void errorData(QAbstractSocket::SocketError err);
+  void readyReadData(int fd);
+  void sampleData();
 
  private:
-  QUdpSocket *d_socket;
+  bool Bind(uint16_t port,QString *err_msg);
+  void SetReceiveBuffer(int bytes);
+  bool ReadQueueStats(int64_t *rx_queue,int64_t *drops) const;
+  int d_fd;
+  QSocketNotifier *d_notifier;
+  QByteArray d_buffer;
+  bool d_rxq_ovfl;
+  uint32_t d_kernel_drops;
+  uint64_t d_reported_drops;
+  QTimer *d_sample_timer;
+  MetricsCounter *d_datagrams_counter;
+  MetricsCounter *d_bytes_counter;
+  MetricsCounter *d_invalid_counter;
+  MetricsCounter *d_drops_counter;
+  MetricsGauge *d_queue_gauge;
+  MetricsGauge *d_buffer_gauge;
 };
 
 
@@ -22,9 +22,9 @@
 
 #include <QObject>
 
+#include "childprocess.h"
 #include "sendmail.h"
 
-#include <QProcess>
 
 bool __SendMail_IsAscii(const QString &str)
 {
@@ -284,7 +284,7 @@ bool SendMail(QString *err_msg,const QString &subject,const QString &body,
   args.clear();
   args.push_back("-bm");
   args.push_back("-t");
-  proc=new QProcess();
+  proc=new ChildProcess();
   proc->start("sendmail",args);
   if(!proc->waitForStarted()) {
     *err_msg=QObject::tr("unable to start sendmail")+"\n";
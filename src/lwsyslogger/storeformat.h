@@ -0,0 +1,73 @@
+// storeformat.h
+//
+// On-disk format of IndexedStore segment and index files.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef STOREFORMAT_H
+#define STOREFORMAT_H
+
+#include <stdint.h>
+
+//
+// An IndexedStore processor writes a series of segment files, each with
+// an index file alongside. A segment holds a file header followed by
+// records, each being a StoreRecordHeader followed by 'length' bytes of
+// the message, rendered in RFC-5424 format. The index holds a file
+// header followed by entries, each being a StoreIndexEntry followed by
+// 'length' bytes of name (for host entries).
+//
+// Both files are append-only, and are written in host byte order.
+//
+#define STORE_SEGMENT_MAGIC "LWSTSEG"
+#define STORE_INDEX_MAGIC "LWSTIDX"
+#define STORE_FORMAT_VERSION 1
+#define STORE_SEGMENT_SUFFIX ".seg"
+#define STORE_INDEX_SUFFIX ".idx"
+#define STORE_INDEX_BUCKET 1
+#define STORE_INDEX_HOST 2
+
+struct StoreFileHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t bucket_interval;  // Seconds per time bucket (index only)
+  int64_t created;           // uSecs since the epoch
+};
+
+struct StoreRecordHeader
+{
+  uint32_t length;           // Of the message, following this header
+  uint32_t host_id;          // As interned in the index
+  int64_t timestamp;         // Time of receipt, uSecs since the epoch
+  uint8_t facility;
+  uint8_t severity;
+  uint16_t msg_offset;       // Start of MSG within the message
+  uint32_t reserved;
+};
+
+struct StoreIndexEntry
+{
+  uint16_t type;             // STORE_INDEX_BUCKET or STORE_INDEX_HOST
+  uint16_t length;           // Of the name following this entry
+  uint32_t host_id;          // Host entries only
+  int64_t timestamp;         // Bucket entries: time of first record
+  uint64_t offset;           // Bucket entries: segment offset of same
+};
+
+
+#endif  // STOREFORMAT_H
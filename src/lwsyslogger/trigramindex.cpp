@@ -0,0 +1,441 @@
+// trigramindex.cpp
+//
+// Trigram inverted index of the lines in a logfile.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <iterator>
+
+#include <QFile>
+
+#include "trigramindex.h"
+
+//
+// Approximate in-memory cost of a trigram's hash node and list header,
+// for size accounting.
+//
+#define TRIGRAMINDEX_ENTRY_OVERHEAD 48
+
+static inline uint32_t __fold(uint8_t c)
+{
+  return ((c>='A')&&(c<='Z'))?c+32:c;
+}
+
+
+static inline uint32_t __trigram(const char *data)
+{
+  return (__fold(data[0])<<16)|(__fold(data[1])<<8)|__fold(data[2]);
+}
+
+
+static bool __list_size_less_than(const QVector<uint32_t> &lhs,
+				  const QVector<uint32_t> &rhs)
+{
+  return lhs.size()<rhs.size();
+}
+
+
+TrigramIndex::TrigramIndex(int64_t start,int64_t max_size)
+{
+  d_start=start;
+  d_covered=start;
+  d_max_size=max_size;
+  d_block_size=TRIGRAMINDEX_INITIAL_BLOCK_SIZE;
+  d_size=sizeof(TrigramIndexHeader);
+  d_stopped=false;
+}
+
+
+int64_t TrigramIndex::start() const
+{
+  return d_start;
+}
+
+
+int64_t TrigramIndex::covered() const
+{
+  return d_covered;
+}
+
+
+int64_t TrigramIndex::blockSize() const
+{
+  return d_block_size;
+}
+
+
+int64_t TrigramIndex::size() const
+{
+  return d_size;
+}
+
+
+int64_t TrigramIndex::maxSize() const
+{
+  return d_max_size;
+}
+
+
+void TrigramIndex::setMaxSize(int64_t max_size)
+{
+  d_max_size=max_size;
+  Shrink();
+}
+
+
+bool TrigramIndex::addLines(int64_t offset,const QByteArray &data)
+{
+  const char *p=data.constData();
+  int64_t len=data.size();
+  int64_t pos=0;
+
+  //
+  // Anything not contiguous with what we have so far leaves a hole that
+  // we can't account for, so stop here and let searches scan the rest.
+  //
+  if(d_stopped||(offset!=d_covered)) {
+    d_stopped=true;
+    return false;
+  }
+  while(pos<len) {
+    const char *nl=(const char *)memchr(p+pos,'\n',len-pos);
+    int64_t end=(nl==NULL)?len:(nl-p);
+    if(d_blocks.isEmpty()||((d_covered-d_blocks.last())>=d_block_size)) {
+      d_blocks.push_back(d_covered);
+      d_size+=sizeof(int64_t);
+    }
+    uint32_t block=d_blocks.size()-1;
+    for(int64_t i=pos;(i+2)<end;i++) {
+      QVector<uint32_t> &list=d_postings[__trigram(p+i)];
+      if(list.isEmpty()) {
+	d_size+=TRIGRAMINDEX_ENTRY_OVERHEAD;
+      }
+      if(list.isEmpty()||(list.last()!=block)) {
+	list.push_back(block);
+	d_size+=sizeof(uint32_t);
+      }
+    }
+    d_covered+=end-pos+(nl!=NULL);
+    pos=end+1;
+
+    Shrink();
+    if(d_stopped) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+bool TrigramIndex::save(const QString &pathname,QString *err_msg) const
+{
+  TrigramIndexHeader hdr;
+  TrigramIndexEntry entry;
+  QByteArray entries;
+  QByteArray lists;
+  QString tmp_pathname=pathname+".tmp";
+
+  QList<uint32_t> trigrams=d_postings.keys();
+  std::sort(trigrams.begin(),trigrams.end());
+  for(int i=0;i<trigrams.size();i++) {
+    QVector<uint32_t> list=d_postings.value(trigrams.at(i));
+    entry.trigram=trigrams.at(i);
+    entry.postings=list.size();
+    entry.offset=lists.size();
+    entries.append((const char *)(&entry),sizeof(entry));
+    uint32_t prev=0;
+    for(int j=0;j<list.size();j++) {
+      uint32_t delta=list.at(j)-prev;
+      prev=list.at(j);
+      while(delta>=0x80) {
+	lists.append((char)((delta&0x7F)|0x80));
+	delta>>=7;
+      }
+      lists.append((char)delta);
+    }
+  }
+
+  memset(&hdr,0,sizeof(hdr));
+  memcpy(hdr.magic,TRIGRAMINDEX_MAGIC,sizeof(hdr.magic));
+  hdr.version=TRIGRAMINDEX_VERSION;
+  hdr.blocks=d_blocks.size();
+  hdr.trigrams=trigrams.size();
+  hdr.start=d_start;
+  hdr.covered=d_covered;
+
+  //
+  // Write to a temporary file first, so that a reader never sees
+  // a partial index.
+  //
+  QFile file(tmp_pathname);
+  if(!file.open(QIODevice::WriteOnly|QIODevice::Truncate)) {
+    *err_msg=file.errorString();
+    return false;
+  }
+  int64_t blocks_size=sizeof(int64_t)*d_blocks.size();
+  if((file.write((const char *)(&hdr),sizeof(hdr))!=sizeof(hdr))||
+     (file.write((const char *)d_blocks.constData(),blocks_size)!=
+      blocks_size)||
+     (file.write(entries)!=entries.size())||
+     (file.write(lists)!=lists.size())) {
+    *err_msg=file.errorString();
+    file.close();
+    QFile::remove(tmp_pathname);
+    return false;
+  }
+  file.close();
+  if(rename(tmp_pathname.toUtf8(),pathname.toUtf8())!=0) {
+    *err_msg=strerror(errno);
+    QFile::remove(tmp_pathname);
+    return false;
+  }
+
+  return true;
+}
+
+
+bool TrigramIndex::load(const QString &pathname,QString *err_msg)
+{
+  TrigramIndexHeader hdr;
+
+  QFile file(pathname);
+  if(!file.open(QIODevice::ReadOnly)) {
+    *err_msg=file.errorString();
+    return false;
+  }
+  QByteArray data=file.readAll();
+  file.close();
+  if(data.size()<(int)sizeof(hdr)) {
+    *err_msg="truncated index header";
+    return false;
+  }
+  memcpy(&hdr,data.constData(),sizeof(hdr));
+  if((strncmp(hdr.magic,TRIGRAMINDEX_MAGIC,sizeof(hdr.magic))!=0)||
+     (hdr.version!=TRIGRAMINDEX_VERSION)) {
+    *err_msg="unrecognized index format";
+    return false;
+  }
+  if((int64_t)data.size()<((int64_t)sizeof(hdr)+
+			   (int64_t)sizeof(int64_t)*hdr.blocks+
+			   (int64_t)sizeof(TrigramIndexEntry)*hdr.trigrams)) {
+    *err_msg="truncated index";
+    return false;
+  }
+  d_data=data;
+  d_start=hdr.start;
+  d_covered=hdr.covered;
+  d_size=data.size();
+  d_stopped=true;
+  d_blocks.resize(hdr.blocks);
+  memcpy(d_blocks.data(),data.constData()+sizeof(hdr),
+	 sizeof(int64_t)*hdr.blocks);
+  d_postings.clear();
+
+  return true;
+}
+
+
+QList<QPair<int64_t,int64_t> > TrigramIndex::candidates(
+			 const QByteArray &pattern,int64_t file_size) const
+{
+  QList<QPair<int64_t,int64_t> > ret;
+  QList<uint32_t> trigrams;
+
+  if((pattern.size()<3)||d_blocks.isEmpty()) {
+    ret.push_back(QPair<int64_t,int64_t>(0,file_size));
+    return ret;
+  }
+
+  //
+  // Intersect the posting lists, shortest first
+  //
+  for(int i=0;(i+2)<pattern.size();i++) {
+    if(!trigrams.contains(__trigram(pattern.constData()+i))) {
+      trigrams.push_back(__trigram(pattern.constData()+i));
+    }
+  }
+  QList<QVector<uint32_t> > lists;
+  for(int i=0;i<trigrams.size();i++) {
+    lists.push_back(Postings(trigrams.at(i)));
+  }
+  std::sort(lists.begin(),lists.end(),__list_size_less_than);
+  QVector<uint32_t> blocks=lists.first();
+  for(int i=1;(i<lists.size())&&(!blocks.isEmpty());i++) {
+    QVector<uint32_t> common;
+    std::set_intersection(blocks.begin(),blocks.end(),
+			  lists.at(i).begin(),lists.at(i).end(),
+			  std::back_inserter(common));
+    blocks=common;
+  }
+
+  //
+  // Assemble the ranges to verify, including any not covered by the index
+  //
+  if(d_start>0) {
+    ret.push_back(QPair<int64_t,int64_t>(0,std::min(d_start,file_size)));
+  }
+  for(int i=0;i<blocks.size();i++) {
+    int64_t begin=d_blocks.at(blocks.at(i));
+    int64_t end=d_covered;
+    if((blocks.at(i)+1)<(uint32_t)d_blocks.size()) {
+      end=d_blocks.at(blocks.at(i)+1);
+    }
+    begin=std::min(begin,file_size);
+    end=std::min(end,file_size);
+    if((!ret.isEmpty())&&(ret.last().second==begin)) {
+      ret.last().second=end;
+    }
+    else {
+      ret.push_back(QPair<int64_t,int64_t>(begin,end));
+    }
+  }
+  if(d_covered<file_size) {
+    if((!ret.isEmpty())&&(ret.last().second==d_covered)) {
+      ret.last().second=file_size;
+    }
+    else {
+      ret.push_back(QPair<int64_t,int64_t>(d_covered,file_size));
+    }
+  }
+
+  return ret;
+}
+
+
+QString TrigramIndex::sidecarPathname(const QString &pathname)
+{
+  const char *suffixes[]={".gz",".xz",".zst",".lwa",NULL};
+  QString ret=pathname;
+
+  for(int i=0;suffixes[i]!=NULL;i++) {
+    if(ret.endsWith(suffixes[i])) {
+      ret=ret.left(ret.length()-strlen(suffixes[i]));
+      break;
+    }
+  }
+  return ret+TRIGRAMINDEX_SUFFIX;
+}
+
+
+void TrigramIndex::Coarsen()
+{
+  //
+  // Merge each pair of adjacent blocks into one
+  //
+  QVector<int64_t> blocks;
+  for(int i=0;i<d_blocks.size();i+=2) {
+    blocks.push_back(d_blocks.at(i));
+  }
+  d_size-=sizeof(int64_t)*(d_blocks.size()-blocks.size());
+  d_blocks=blocks;
+  d_block_size*=2;
+
+  for(QHash<uint32_t,QVector<uint32_t> >::iterator it=d_postings.begin();
+      it!=d_postings.end();it++) {
+    QVector<uint32_t> &list=it.value();
+    int n=0;
+    for(int i=0;i<list.size();i++) {
+      uint32_t block=list.at(i)>>1;
+      if((n==0)||(list.at(n-1)!=block)) {
+	list[n++]=block;
+      }
+    }
+    d_size-=sizeof(uint32_t)*(list.size()-n);
+    list.resize(n);
+  }
+}
+
+
+void TrigramIndex::Shrink()
+{
+  //
+  // Keep within the size limit by making the blocks coarser. Once they
+  // can get no coarser, stop indexing altogether.
+  //
+  while((d_size>d_max_size)&&(!d_stopped)) {
+    if(d_blocks.size()>1) {
+      Coarsen();
+    }
+    else {
+      d_stopped=true;
+    }
+  }
+}
+
+
+QVector<uint32_t> TrigramIndex::Postings(uint32_t trigram) const
+{
+  QVector<uint32_t> ret;
+  TrigramIndexEntry entry;
+
+  if(d_data.isEmpty()) {
+    return d_postings.value(trigram);
+  }
+
+  //
+  // Binary search of the saved entry table
+  //
+  const TrigramIndexHeader *hdr=(const TrigramIndexHeader *)d_data.constData();
+  const char *entries=d_data.constData()+sizeof(TrigramIndexHeader)+
+    sizeof(int64_t)*hdr->blocks;
+  const char *lists=entries+sizeof(TrigramIndexEntry)*hdr->trigrams;
+  const char *lists_end=d_data.constData()+d_data.size();
+  int64_t lo=0;
+  int64_t hi=hdr->trigrams;
+  while(lo<hi) {
+    int64_t mid=lo+(hi-lo)/2;
+    memcpy(&entry,entries+sizeof(entry)*mid,sizeof(entry));
+    if(entry.trigram<trigram) {
+      lo=mid+1;
+    }
+    else {
+      hi=mid;
+    }
+  }
+  if(lo>=hdr->trigrams) {
+    return ret;
+  }
+  memcpy(&entry,entries+sizeof(entry)*lo,sizeof(entry));
+  if(entry.trigram!=trigram) {
+    return ret;
+  }
+  const char *p=lists+entry.offset;
+  uint32_t block=0;
+  for(uint32_t i=0;(i<entry.postings)&&(p<lists_end);i++) {
+    uint32_t delta=0;
+    int shift=0;
+    while((p<lists_end)&&((*p&0x80)!=0)) {
+      delta|=(uint32_t)(*p&0x7F)<<shift;
+      shift+=7;
+      p++;
+    }
+    if(p<lists_end) {
+      delta|=(uint32_t)(*p)<<shift;
+      p++;
+    }
+    block+=delta;
+    ret.push_back(block);
+  }
+
+  return ret;
+}
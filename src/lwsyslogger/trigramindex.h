@@ -0,0 +1,106 @@
+// trigramindex.h
+//
+// Trigram inverted index of the lines in a logfile.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+
+#include <stdint.h>
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+//
+// The logfile is divided into blocks of whole lines, and each (ASCII case
+// folded) trigram maps to the list of blocks containing it. A search
+// need verify only the blocks common to all the trigrams of its pattern.
+//
+// The index may not cover the whole file; bytes before 'start' (written
+// before the index was begun) and from 'covered' on must be scanned in
+// full. It is saved as a TrigramIndexHeader, then 'blocks' int64_t block
+// starting offsets, then 'trigrams' TrigramIndexEntry records sorted by
+// trigram, then the posting lists as varint-encoded block number deltas.
+// All in host byte order.
+//
+#define TRIGRAMINDEX_MAGIC "LWTRIGR"
+#define TRIGRAMINDEX_VERSION 1
+#define TRIGRAMINDEX_SUFFIX ".tri"
+
+//
+// Defaults
+//
+#define TRIGRAMINDEX_DEFAULT_MAX_SIZE 16777216
+#define TRIGRAMINDEX_INITIAL_BLOCK_SIZE 4096
+
+struct TrigramIndexHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t blocks;
+  uint32_t trigrams;
+  uint32_t reserved;
+  int64_t start;
+  int64_t covered;
+};
+
+struct TrigramIndexEntry
+{
+  uint32_t trigram;
+  uint32_t postings;         // Number of blocks in the list
+  uint64_t offset;           // Of the list, from the start of the lists
+};
+
+class TrigramIndex
+{
+ public:
+  TrigramIndex(int64_t start=0,int64_t max_size=TRIGRAMINDEX_DEFAULT_MAX_SIZE);
+  int64_t start() const;
+  int64_t covered() const;
+  int64_t blockSize() const;
+  int64_t size() const;
+  int64_t maxSize() const;
+  void setMaxSize(int64_t max_size);
+  bool addLines(int64_t offset,const QByteArray &data);
+  bool save(const QString &pathname,QString *err_msg) const;
+  bool load(const QString &pathname,QString *err_msg);
+  QList<QPair<int64_t,int64_t> > candidates(const QByteArray &pattern,
+					    int64_t file_size) const;
+  static QString sidecarPathname(const QString &pathname);
+
+ private:
+  void Coarsen();
+  void Shrink();
+  QVector<uint32_t> Postings(uint32_t trigram) const;
+  int64_t d_start;
+  int64_t d_covered;
+  int64_t d_max_size;
+  int64_t d_block_size;
+  int64_t d_size;
+  bool d_stopped;
+  QVector<int64_t> d_blocks;
+  QHash<uint32_t,QVector<uint32_t> > d_postings;
+  QByteArray d_data;
+};
+
+
+#endif  // TRIGRAMINDEX_H
@@ -0,0 +1,134 @@
+// trigramindexer.cpp
+//
+// Build trigram indexes for a processor in a background thread.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include "message.h"
+#include "trigramindexer.h"
+
+//
+// One thread is shared by all processors, so that indexing never
+// competes with message reception for more than one core.
+//
+static QThread *__trigramindexer_thread=NULL;
+
+TrigramIndexer::TrigramIndexer(int64_t max_size)
+  : QObject()
+{
+  d_max_size=max_size;
+  moveToThread(TrigramIndexer::indexerThread());
+}
+
+
+TrigramIndexer::~TrigramIndexer()
+{
+  for(QHash<QString,TrigramIndex *>::const_iterator it=d_indexes.begin();
+      it!=d_indexes.end();it++) {
+    delete it.value();
+  }
+}
+
+
+QThread *TrigramIndexer::indexerThread()
+{
+  if(__trigramindexer_thread==NULL) {
+    __trigramindexer_thread=new QThread();
+    __trigramindexer_thread->setObjectName("TrigramIndexer");
+    __trigramindexer_thread->start(QThread::LowPriority);
+  }
+  return __trigramindexer_thread;
+}
+
+
+void TrigramIndexer::shutdown()
+{
+  if(__trigramindexer_thread!=NULL) {
+    __trigramindexer_thread->quit();
+    __trigramindexer_thread->wait();
+    delete __trigramindexer_thread;
+    __trigramindexer_thread=NULL;
+  }
+}
+
+
+void TrigramIndexer::addLines(const QString &pathname,qint64 start,
+			      qint64 offset,const QByteArray &data)
+{
+  TrigramIndex *index=d_indexes.value(pathname);
+
+  if(index==NULL) {
+    index=new TrigramIndex(start,d_max_size);
+    d_indexes[pathname]=index;
+    Rebalance();
+  }
+  index->addLines(offset,data);
+}
+
+
+void TrigramIndexer::seal(const QString &pathname,const QString &new_pathname)
+{
+  QString err_msg;
+
+  TrigramIndex *index=d_indexes.value(pathname);
+  if(index==NULL) {
+    return;
+  }
+  d_indexes.remove(pathname);
+  Rebalance();
+  if(!index->save(TrigramIndex::sidecarPathname(new_pathname),&err_msg)) {
+    emit maintenanceMessage(Message::SeverityWarning,
+	       QString::asprintf("failed to write index for \"%s\" [%s]",
+				 new_pathname.toUtf8().constData(),
+				 err_msg.toUtf8().constData()));
+  }
+  delete index;
+}
+
+
+void TrigramIndexer::sync()
+{
+  //
+  // Does nothing; used to wait for previously queued jobs to complete
+  //
+}
+
+
+void TrigramIndexer::drain()
+{
+  //
+  // As sync(), but for callers that can't afford to block
+  //
+  emit drained();
+}
+
+
+void TrigramIndexer::Rebalance()
+{
+  //
+  // The size limit is for the processor as a whole, so share it evenly
+  // among the logfiles currently being indexed.
+  //
+  if(d_indexes.isEmpty()) {
+    return;
+  }
+  int64_t share=d_max_size/d_indexes.size();
+  for(QHash<QString,TrigramIndex *>::const_iterator it=d_indexes.begin();
+      it!=d_indexes.end();it++) {
+    it.value()->setMaxSize(share);
+  }
+}
@@ -0,0 +1,59 @@
+// trigramindexer.h
+//
+// Build trigram indexes for a processor in a background thread.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef TRIGRAMINDEXER_H
+#define TRIGRAMINDEXER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QThread>
+
+#include "trigramindex.h"
+
+class TrigramIndexer : public QObject
+{
+  Q_OBJECT
+ public:
+  TrigramIndexer(int64_t max_size);
+  ~TrigramIndexer();
+  static QThread *indexerThread();
+  static void shutdown();
+
+ public slots:
+  void addLines(const QString &pathname,qint64 start,qint64 offset,
+		const QByteArray &data);
+  void seal(const QString &pathname,const QString &new_pathname);
+  void sync();
+  void drain();
+
+ signals:
+  void drained();
+  void maintenanceMessage(int severity,const QString &msg);
+
+ private:
+  void Rebalance();
+  int64_t d_max_size;
+  QHash<QString,TrigramIndex *> d_indexes;
+};
+
+
+#endif  // TRIGRAMINDEXER_H
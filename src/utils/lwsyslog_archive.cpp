@@ -0,0 +1,446 @@
+// lwsyslog_archive.cpp
+//
+// Convert, print and aggregate columnar logfile archives.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFileInfo>
+
+#include "../lwsyslogger/archivewriter.h"
+#include "cmdswitch.h"
+#include "lwsyslog_archive.h"
+
+MainObject::MainObject(QObject *parent)
+  : QObject(parent)
+{
+  QStringList paths;
+  Mode mode=MainObject::ModeNone;
+  bool ok=false;
+  bool ret=true;
+
+  d_from=0;
+  d_to=LLONG_MAX;
+  d_count_keys=0;
+  d_level=-1;
+  d_remove=false;
+  d_time_key_start=0;
+  d_time_key_end=0;
+
+  CmdSwitch *cmd=
+    new CmdSwitch("lwsyslog-archive",VERSION,LWSYSLOG_ARCHIVE_USAGE);
+  for(int i=0;i<cmd->keys();i++) {
+    if(cmd->key(i)=="--convert") {
+      mode=MainObject::ModeConvert;
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--cat") {
+      mode=MainObject::ModeCat;
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--info") {
+      mode=MainObject::ModeInfo;
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--count-by") {
+      mode=MainObject::ModeCount;
+      QStringList f0=cmd->value(i).split(",",Qt::SkipEmptyParts);
+      for(int j=0;j<f0.size();j++) {
+	QString key=f0.at(j).trimmed().toLower();
+	if(key=="host") {
+	  d_count_keys|=LWSYSLOG_ARCHIVE_KEY_HOST;
+	}
+	else if(key=="app") {
+	  d_count_keys|=LWSYSLOG_ARCHIVE_KEY_APP;
+	}
+	else if(key=="hour") {
+	  d_count_keys|=LWSYSLOG_ARCHIVE_KEY_HOUR;
+	}
+	else if(key=="day") {
+	  d_count_keys|=LWSYSLOG_ARCHIVE_KEY_DAY;
+	}
+	else {
+	  fprintf(stderr,"lwsyslog-archive: invalid --count-by key \"%s\"\n",
+		  f0.at(j).toUtf8().constData());
+	  exit(1);
+	}
+      }
+      if((d_count_keys&LWSYSLOG_ARCHIVE_KEY_HOUR)&&
+	 (d_count_keys&LWSYSLOG_ARCHIVE_KEY_DAY)) {
+	fprintf(stderr,
+		"lwsyslog-archive: --count-by takes only one of hour and day\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--level") {
+      d_level=cmd->value(i).toInt(&ok);
+      if((!ok)||(d_level<1)||(d_level>19)) {
+	fprintf(stderr,"lwsyslog-archive: invalid --level value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--remove") {
+      d_remove=true;
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--from") {
+      d_from=ParseDateTime(cmd->value(i),&ok);
+      if(!ok) {
+	fprintf(stderr,"lwsyslog-archive: invalid --from value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--to") {
+      d_to=ParseDateTime(cmd->value(i),&ok);
+      if(!ok) {
+	fprintf(stderr,"lwsyslog-archive: invalid --to value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--host") {
+      d_host=cmd->value(i).toUtf8();
+      cmd->setProcessed(i,true);
+    }
+    if((!cmd->processed(i))&&(cmd->key(i).left(1)!="-")) {
+      paths.push_back(cmd->key(i));
+      cmd->setProcessed(i,true);
+    }
+    if(!cmd->processed(i)) {
+      fprintf(stderr,"lwsyslog-archive: unrecognized option \"%s\"\n",
+	      cmd->key(i).toUtf8().constData());
+      exit(1);
+    }
+  }
+  if(mode==MainObject::ModeNone) {
+    fprintf(stderr,"lwsyslog-archive: one of --convert, --cat, --count-by "
+	    "or --info must be given\n");
+    exit(1);
+  }
+  if(paths.isEmpty()) {
+    fprintf(stderr,"lwsyslog-archive: no files given\n");
+    exit(1);
+  }
+  if(d_to<d_from) {
+    fprintf(stderr,"lwsyslog-archive: --to is earlier than --from\n");
+    exit(1);
+  }
+
+  for(int i=0;i<paths.size();i++) {
+    if(mode==MainObject::ModeConvert) {
+      ret=Convert(paths.at(i))&&ret;
+      continue;
+    }
+    QString err_msg;
+    ArchiveReader *reader=new ArchiveReader(paths.at(i));
+    if(!reader->open(&err_msg)) {
+      fprintf(stderr,"lwsyslog-archive: unable to open \"%s\" [%s]\n",
+	      paths.at(i).toUtf8().constData(),err_msg.toUtf8().constData());
+      delete reader;
+      ret=false;
+      continue;
+    }
+    switch(mode) {
+    case MainObject::ModeCat:
+      ret=Cat(reader)&&ret;
+      break;
+
+    case MainObject::ModeCount:
+      ret=Count(reader)&&ret;
+      break;
+
+    case MainObject::ModeInfo:
+      Info(reader);
+      break;
+
+    case MainObject::ModeNone:
+    case MainObject::ModeConvert:
+      break;
+    }
+    delete reader;
+  }
+
+  //
+  // Counts are totalled across all of the given archives
+  //
+  if(mode==MainObject::ModeCount) {
+    QList<QByteArray> keys=d_counts.keys();
+    std::sort(keys.begin(),keys.end());
+    for(int i=0;i<keys.size();i++) {
+      printf("%s\t%ld\n",keys.at(i).constData(),d_counts.value(keys.at(i)));
+    }
+  }
+  fflush(stdout);
+
+  exit(ret?0:1);
+}
+
+
+bool MainObject::Convert(const QString &pathname)
+{
+  QString err_msg;
+  struct stat statbuf;
+
+  if(pathname.endsWith(ARCHIVE_SUFFIX)) {
+    fprintf(stderr,"lwsyslog-archive: \"%s\" is already an archive\n",
+	    pathname.toUtf8().constData());
+    return false;
+  }
+  QString new_pathname=pathname+ARCHIVE_SUFFIX;
+  QString tmp_pathname=new_pathname+".tmp";
+  if(!ArchiveWriter::convertTextFile(pathname,tmp_pathname,d_level,
+				     &err_msg)) {
+    fprintf(stderr,"lwsyslog-archive: unable to convert \"%s\" [%s]\n",
+	    pathname.toUtf8().constData(),err_msg.toUtf8().constData());
+    return false;
+  }
+
+  //
+  // Carry over the modification time, which lwsyslogger(8) uses for
+  // expiring compressed files.
+  //
+  memset(&statbuf,0,sizeof(statbuf));
+  if(stat(pathname.toUtf8(),&statbuf)==0) {
+    struct timespec times[2];
+    times[0]=statbuf.st_atim;
+    times[1]=statbuf.st_mtim;
+    utimensat(AT_FDCWD,tmp_pathname.toUtf8(),times,0);
+  }
+  if(rename(tmp_pathname.toUtf8(),new_pathname.toUtf8())!=0) {
+    fprintf(stderr,"lwsyslog-archive: unable to convert \"%s\" [%s]\n",
+	    pathname.toUtf8().constData(),strerror(errno));
+    unlink(tmp_pathname.toUtf8());
+    return false;
+  }
+  if(d_remove) {
+    unlink(pathname.toUtf8());
+  }
+
+  return true;
+}
+
+
+bool MainObject::Cat(ArchiveReader *reader)
+{
+  ArchiveBlock block;
+  QString err_msg;
+  uint32_t host_id=0;
+
+  if(!d_host.isEmpty()) {
+    if((host_id=reader->nameId(d_host))==0) {
+      return true;  // Host never appears
+    }
+  }
+  for(int i=0;i<reader->blocks();i++) {
+    if(!InRange(reader->blockEntry(i))) {
+      continue;
+    }
+    if(!reader->readBlock(i,ARCHIVE_ALL_COLUMNS,&block,&err_msg)) {
+      fprintf(stderr,"lwsyslog-archive: \"%s\": %s\n",
+	      reader->pathname().toUtf8().constData(),
+	      err_msg.toUtf8().constData());
+      return false;
+    }
+    for(int j=0;j<block.timestamps.size();j++) {
+      if((block.timestamps.at(j)>=d_from)&&(block.timestamps.at(j)<=d_to)&&
+	 ((host_id==0)||(block.hosts.at(j)==host_id))) {
+	QByteArray line=ArchiveReader::textLine(reader->record(block,j))+"\n";
+	fwrite(line.constData(),1,line.size(),stdout);
+      }
+    }
+  }
+
+  return true;
+}
+
+
+bool MainObject::Count(ArchiveReader *reader)
+{
+  ArchiveBlock block;
+  QString err_msg;
+  uint32_t host_id=0;
+
+  //
+  // Read only the columns that the keys and filters need; in particular,
+  // the message bodies are never decompressed.
+  //
+  uint32_t columns=ARCHIVE_COLUMN_MASK(ARCHIVE_COLUMN_TIMESTAMP);
+  if((!d_host.isEmpty())||(d_count_keys&LWSYSLOG_ARCHIVE_KEY_HOST)) {
+    columns|=ARCHIVE_COLUMN_MASK(ARCHIVE_COLUMN_HOST);
+  }
+  if(d_count_keys&LWSYSLOG_ARCHIVE_KEY_APP) {
+    columns|=ARCHIVE_COLUMN_MASK(ARCHIVE_COLUMN_APP);
+  }
+  if(!d_host.isEmpty()) {
+    if((host_id=reader->nameId(d_host))==0) {
+      return true;  // Host never appears
+    }
+  }
+  for(int i=0;i<reader->blocks();i++) {
+    if(!InRange(reader->blockEntry(i))) {
+      continue;
+    }
+    if(!reader->readBlock(i,columns,&block,&err_msg)) {
+      fprintf(stderr,"lwsyslog-archive: \"%s\": %s\n",
+	      reader->pathname().toUtf8().constData(),
+	      err_msg.toUtf8().constData());
+      return false;
+    }
+    for(int j=0;j<block.timestamps.size();j++) {
+      if((block.timestamps.at(j)<d_from)||(block.timestamps.at(j)>d_to)||
+	 ((host_id!=0)&&(block.hosts.at(j)!=host_id))) {
+	continue;
+      }
+      QByteArray key;
+      if(d_count_keys&LWSYSLOG_ARCHIVE_KEY_HOUR) {
+	key+=TimeKey(block.timestamps.at(j),true)+"\t";
+      }
+      if(d_count_keys&LWSYSLOG_ARCHIVE_KEY_DAY) {
+	key+=TimeKey(block.timestamps.at(j),false)+"\t";
+      }
+      if(d_count_keys&LWSYSLOG_ARCHIVE_KEY_HOST) {
+	key+=reader->name(block.hosts.at(j))+"\t";
+      }
+      if(d_count_keys&LWSYSLOG_ARCHIVE_KEY_APP) {
+	key+=reader->name(block.apps.at(j))+"\t";
+      }
+      key.chop(1);
+      d_counts[key]++;
+    }
+  }
+
+  return true;
+}
+
+
+void MainObject::Info(ArchiveReader *reader) const
+{
+  int64_t min_timestamp=LLONG_MAX;
+  int64_t max_timestamp=0;
+
+  for(int i=0;i<reader->blocks();i++) {
+    ArchiveDirectoryEntry entry=reader->blockEntry(i);
+    if(entry.min_timestamp<min_timestamp) {
+      min_timestamp=entry.min_timestamp;
+    }
+    if(entry.max_timestamp>max_timestamp) {
+      max_timestamp=entry.max_timestamp;
+    }
+  }
+  printf("%s: %ld record(s) in %d block(s), %ld byte(s)",
+	 reader->pathname().toUtf8().constData(),reader->records(),
+	 reader->blocks(),QFileInfo(reader->pathname()).size());
+  if(reader->blocks()>0) {
+    printf(", %s to %s",
+	   QDateTime::fromMSecsSinceEpoch(min_timestamp/1000).
+	   toString("yyyy-MM-ddThh:mm:ss").toUtf8().constData(),
+	   QDateTime::fromMSecsSinceEpoch(max_timestamp/1000).
+	   toString("yyyy-MM-ddThh:mm:ss").toUtf8().constData());
+  }
+  printf("\n");
+}
+
+
+bool MainObject::InRange(const ArchiveDirectoryEntry &entry) const
+{
+  return (entry.max_timestamp>=d_from)&&(entry.min_timestamp<=d_to);
+}
+
+
+QByteArray MainObject::TimeKey(int64_t timestamp,bool hour)
+{
+  struct tm tm;
+  char str[32];
+
+  //
+  // Consecutive records nearly always fall into the same hour or day, so
+  // only format a new key when leaving the current one.
+  //
+  time_t t=timestamp/1000000;
+  if((t>=d_time_key_start)&&(t<d_time_key_end)) {
+    return d_time_key;
+  }
+  localtime_r(&t,&tm);
+  if(hour) {
+    d_time_key_start=t-60*tm.tm_min-tm.tm_sec;
+    d_time_key_end=d_time_key_start+3600;
+    strftime(str,sizeof(str),"%Y-%m-%dT%H",&tm);
+  }
+  else {
+    strftime(str,sizeof(str),"%Y-%m-%d",&tm);
+    tm.tm_hour=0;
+    tm.tm_min=0;
+    tm.tm_sec=0;
+    tm.tm_isdst=-1;
+    d_time_key_start=mktime(&tm);
+    tm.tm_mday++;
+    tm.tm_isdst=-1;
+    d_time_key_end=mktime(&tm);
+  }
+  d_time_key=str;
+
+  return d_time_key;
+}
+
+
+int64_t MainObject::ParseDateTime(const QString &str,bool *ok) const
+{
+  QDateTime dt;
+  QStringList formats;
+  formats.push_back("yyyy-MM-ddThh:mm:ss");
+  formats.push_back("yyyy-MM-dd hh:mm:ss");
+  formats.push_back("yyyy-MM-ddThh:mm");
+  formats.push_back("yyyy-MM-dd hh:mm");
+  formats.push_back("yyyy-MM-dd");
+
+  for(int i=0;i<formats.size();i++) {
+    dt=QDateTime::fromString(str,formats.at(i));
+    if(dt.isValid()) {
+      *ok=true;
+      return 1000*dt.toMSecsSinceEpoch();
+    }
+  }
+  *ok=false;
+
+  return 0;
+}
+
+
+int main(int argc,char *argv[])
+{
+  QCoreApplication a(argc,argv);
+
+  new MainObject();
+
+  return a.exec();
+}
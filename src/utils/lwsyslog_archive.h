@@ -0,0 +1,72 @@
+// lwsyslog_archive.h
+//
+// Convert, print and aggregate columnar logfile archives.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef LWSYSLOG_ARCHIVE_H
+#define LWSYSLOG_ARCHIVE_H
+
+#include <stdint.h>
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+#include "../lwsyslogger/archivereader.h"
+
+//
+// Global Definitions
+//
+#define LWSYSLOG_ARCHIVE_USAGE "--convert [--level=<num>] [--remove] <logfile> [...]\n  --cat [--from=<datetime>] [--to=<datetime>] [--host=<hostname>] <archive> [...]\n  --count-by=<host|app|hour|day>[,...] [--from=<datetime>] [--to=<datetime>] [--host=<hostname>] <archive> [...]\n  --info <archive> [...]\n\n"
+
+#define LWSYSLOG_ARCHIVE_KEY_HOST 0x01
+#define LWSYSLOG_ARCHIVE_KEY_APP 0x02
+#define LWSYSLOG_ARCHIVE_KEY_HOUR 0x04
+#define LWSYSLOG_ARCHIVE_KEY_DAY 0x08
+
+class MainObject : public QObject
+{
+  Q_OBJECT
+ public:
+  enum Mode {ModeNone=0,ModeConvert=1,ModeCat=2,ModeCount=3,ModeInfo=4};
+  MainObject(QObject *parent=0);
+
+ private:
+  bool Convert(const QString &pathname);
+  bool Cat(ArchiveReader *reader);
+  bool Count(ArchiveReader *reader);
+  void Info(ArchiveReader *reader) const;
+  bool InRange(const ArchiveDirectoryEntry &entry) const;
+  QByteArray TimeKey(int64_t timestamp,bool hour);
+  int64_t ParseDateTime(const QString &str,bool *ok) const;
+  int64_t d_from;
+  int64_t d_to;
+  QByteArray d_host;
+  uint32_t d_count_keys;
+  int d_level;
+  bool d_remove;
+  QHash<QByteArray,int64_t> d_counts;
+  time_t d_time_key_start;
+  time_t d_time_key_end;
+  QByteArray d_time_key;
+};
+
+
+#endif  // LWSYSLOG_ARCHIVE_H
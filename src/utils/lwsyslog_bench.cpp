@@ -0,0 +1,562 @@
+// lwsyslog_bench.cpp
+//
+// Headless syslog load generator
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <errno.h>
+#include <inttypes.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/un.h>
+
+#include <QCoreApplication>
+
+#include "cmdswitch.h"
+#include "lwsyslog_bench.h"
+
+MainObject::MainObject(QObject *parent)
+  : QObject(parent)
+{
+  QString transport="udp";
+  QString format="3164";
+  bool count_set=false;
+  bool ok=false;
+  int hostnames=LWSYSLOG_BENCH_DEFAULT_HOSTNAMES;
+  QString err_msg;
+
+  d_address=LWSYSLOG_BENCH_DEFAULT_ADDRESS;
+  d_port=LWSYSLOG_BENCH_DEFAULT_PORT;
+  d_socket_path=LWSYSLOG_BENCH_DEFAULT_SOCKET;
+  d_rate=0.0;
+  d_count=LWSYSLOG_BENCH_DEFAULT_COUNT;
+  d_duration=0.0;
+  d_payload_min=LWSYSLOG_BENCH_DEFAULT_PAYLOAD_SIZE;
+  d_payload_max=LWSYSLOG_BENCH_DEFAULT_PAYLOAD_SIZE;
+  d_duplicate_ratio=0.0;
+  d_batch_size=LWSYSLOG_BENCH_DEFAULT_BATCH_SIZE;
+  d_random_state=((uint64_t)time(NULL)<<20)^getpid();
+  d_sock=-1;
+  d_timestamp_second=0;
+  d_sequence=0;
+  d_sent=0;
+  d_sent_bytes=0;
+  d_duplicates=0;
+  d_send_errors=0;
+
+  CmdSwitch *cmd=
+    new CmdSwitch("lwsyslog-bench",VERSION,LWSYSLOG_BENCH_USAGE);
+  for(int i=0;i<cmd->keys();i++) {
+    if(cmd->key(i)=="--transport") {
+      transport=cmd->value(i).toLower();
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--address") {
+      d_address=cmd->value(i);
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--port") {
+      unsigned port=cmd->value(i).toUInt(&ok);
+      if((!ok)||(port==0)||(port>0xFFFF)) {
+	fprintf(stderr,"lwsyslog-bench: invalid --port value\n");
+	exit(1);
+      }
+      d_port=port;
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--socket") {
+      d_socket_path=cmd->value(i);
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--format") {
+      format=cmd->value(i);
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--rate") {
+      d_rate=cmd->value(i).toDouble(&ok);
+      if((!ok)||(d_rate<0.0)) {
+	fprintf(stderr,"lwsyslog-bench: invalid --rate value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--count") {
+      d_count=cmd->value(i).toULongLong(&ok);
+      if(!ok) {
+	fprintf(stderr,"lwsyslog-bench: invalid --count value\n");
+	exit(1);
+      }
+      count_set=true;
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--duration") {
+      d_duration=cmd->value(i).toDouble(&ok);
+      if((!ok)||(d_duration<=0.0)) {
+	fprintf(stderr,"lwsyslog-bench: invalid --duration value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--hostnames") {
+      hostnames=cmd->value(i).toInt(&ok);
+      if((!ok)||(hostnames<1)) {
+	fprintf(stderr,"lwsyslog-bench: invalid --hostnames value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--payload-size") {
+      QStringList f0=cmd->value(i).split("-");
+      d_payload_min=f0.at(0).toInt(&ok);
+      d_payload_max=d_payload_min;
+      if(ok&&(f0.size()==2)) {
+	d_payload_max=f0.at(1).toInt(&ok);
+      }
+      if((!ok)||(f0.size()>2)||
+	 (d_payload_min<LWSYSLOG_BENCH_MIN_PAYLOAD_SIZE)||
+	 (d_payload_max<d_payload_min)||
+	 (d_payload_max>LWSYSLOG_BENCH_MAX_PAYLOAD_SIZE)) {
+	fprintf(stderr,"lwsyslog-bench: invalid --payload-size value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--duplicate-ratio") {
+      d_duplicate_ratio=cmd->value(i).toDouble(&ok);
+      if((!ok)||(d_duplicate_ratio<0.0)||(d_duplicate_ratio>=1.0)) {
+	fprintf(stderr,"lwsyslog-bench: invalid --duplicate-ratio value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--batch-size") {
+      d_batch_size=cmd->value(i).toInt(&ok);
+      if((!ok)||(d_batch_size<1)||
+	 (d_batch_size>LWSYSLOG_BENCH_MAX_BATCH_SIZE)) {
+	fprintf(stderr,"lwsyslog-bench: invalid --batch-size value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--seed") {
+      d_random_state=cmd->value(i).toULongLong(&ok);
+      if(!ok) {
+	fprintf(stderr,"lwsyslog-bench: invalid --seed value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+    if(!cmd->processed(i)) {
+      fprintf(stderr,"lwsyslog-bench: unrecognized switch \"%s\"\n",
+	      cmd->key(i).toUtf8().constData());
+      exit(1);
+    }
+  }
+
+  //
+  // Validate Arguments
+  //
+  if(transport=="udp") {
+    d_transport=MainObject::Udp;
+  }
+  else {
+    if(transport=="tcp") {
+      d_transport=MainObject::Tcp;
+    }
+    else {
+      if(transport=="unix") {
+	d_transport=MainObject::Unix;
+      }
+      else {
+	fprintf(stderr,"lwsyslog-bench: unknown transport \"%s\"\n",
+		transport.toUtf8().constData());
+	exit(1);
+      }
+    }
+  }
+  if(format=="3164") {
+    d_format=MainObject::Rfc3164;
+  }
+  else {
+    if(format=="5424") {
+      d_format=MainObject::Rfc5424;
+    }
+    else {
+      fprintf(stderr,"lwsyslog-bench: unknown format \"%s\"\n",
+	      format.toUtf8().constData());
+      exit(1);
+    }
+  }
+  if((d_duration>0.0)&&(!count_set)) {
+    d_count=0;  // Run until the duration expires
+  }
+  if(d_random_state==0) {
+    d_random_state=1;  // Xorshift never leaves the zero state
+  }
+
+  //
+  // Synthetic Message Components
+  //
+  for(int i=0;i<hostnames;i++) {
+    d_hostnames.push_back(QString::asprintf("bench%04d",i+1).toUtf8());
+  }
+  static const char filler_chars[]="abcdefghijklmnopqrstuvwxyz ";
+  d_filler.resize(d_payload_max);
+  for(int i=0;i<d_filler.size();i++) {
+    d_filler[i]=filler_chars[Random()%(sizeof(filler_chars)-1)];
+  }
+  if(d_format==MainObject::Rfc3164) {
+    d_header_tail=
+      QString::asprintf(" lwsyslog-bench[%u]: ",getpid()).toUtf8();
+  }
+  else {
+    d_header_tail=
+      QString::asprintf(" lwsyslog-bench %u - - ",getpid()).toUtf8();
+  }
+  d_msgvec.resize(d_batch_size);
+  d_iovec.resize(d_batch_size);
+
+  if(!OpenSocket(&err_msg)) {
+    fprintf(stderr,"lwsyslog-bench: unable to connect [%s]\n",
+	    err_msg.toUtf8().constData());
+    exit(1);
+  }
+  Run();
+  ::close(d_sock);
+
+  exit(d_sent>0?0:1);
+}
+
+
+bool MainObject::OpenSocket(QString *err_msg)
+{
+  if(d_transport==MainObject::Unix) {
+    struct sockaddr_un sa;
+    QByteArray path=d_socket_path.toUtf8();
+    if(path.size()>=(int)sizeof(sa.sun_path)) {
+      *err_msg="socket path too long";
+      return false;
+    }
+    memset(&sa,0,sizeof(sa));
+    sa.sun_family=AF_UNIX;
+    strncpy(sa.sun_path,path.constData(),sizeof(sa.sun_path)-1);
+    if((d_sock=socket(AF_UNIX,SOCK_DGRAM,0))<0) {
+      *err_msg=strerror(errno);
+      return false;
+    }
+    if(::connect(d_sock,(struct sockaddr *)(&sa),sizeof(sa))<0) {
+      *err_msg=strerror(errno);
+      ::close(d_sock);
+      d_sock=-1;
+      return false;
+    }
+    return true;
+  }
+
+  struct addrinfo hints;
+  struct addrinfo *res=NULL;
+  memset(&hints,0,sizeof(hints));
+  hints.ai_family=AF_UNSPEC;
+  hints.ai_socktype=(d_transport==MainObject::Tcp)?SOCK_STREAM:SOCK_DGRAM;
+  int err=getaddrinfo(d_address.toUtf8().constData(),
+		      QString::asprintf("%u",d_port).toUtf8().constData(),
+		      &hints,&res);
+  if(err!=0) {
+    *err_msg=gai_strerror(err);
+    return false;
+  }
+  for(struct addrinfo *ai=res;ai!=NULL;ai=ai->ai_next) {
+    if((d_sock=socket(ai->ai_family,ai->ai_socktype,ai->ai_protocol))<0) {
+      *err_msg=strerror(errno);
+      continue;
+    }
+    if(::connect(d_sock,ai->ai_addr,ai->ai_addrlen)==0) {
+      freeaddrinfo(res);
+      return true;
+    }
+    *err_msg=strerror(errno);
+    ::close(d_sock);
+    d_sock=-1;
+  }
+  freeaddrinfo(res);
+
+  return false;
+}
+
+
+void MainObject::Run()
+{
+  QList<QByteArray> msgs;
+  uint64_t queued=0;
+  int64_t start=MonotonicNsec();
+  int64_t end=0;
+  int batch_size=d_batch_size;
+
+  if(d_duration>0.0) {
+    end=start+(int64_t)(d_duration*1000000000.0);
+  }
+  if(d_rate>0.0) {
+    //
+    // Keep each burst to no more than about 10 mS worth of traffic, so
+    // that the receiver sees something close to the requested rate
+    // rather than a series of full-size spikes.
+    //
+    int burst=d_rate/100.0;
+    if(burst<1) {
+      burst=1;
+    }
+    if(burst<batch_size) {
+      batch_size=burst;
+    }
+  }
+
+  while((d_count==0)||(queued<d_count)) {
+    int64_t now=MonotonicNsec();
+    if((end>0)&&(now>=end)) {
+      break;
+    }
+    if(d_rate>0.0) {
+      int64_t due=start+(int64_t)((double)queued*1000000000.0/d_rate);
+      if(due>now) {
+	struct timespec ts;
+	ts.tv_sec=(due-now)/1000000000;
+	ts.tv_nsec=(due-now)%1000000000;
+	nanosleep(&ts,NULL);
+      }
+    }
+    UpdateTimestamp();
+    msgs.clear();
+    for(int i=0;i<batch_size;i++) {
+      if((d_count>0)&&(queued>=d_count)) {
+	break;
+      }
+      msgs.push_back(NextMessage());
+      queued++;
+    }
+    if(!SendBatch(msgs)) {
+      break;
+    }
+  }
+  Report(MonotonicNsec()-start);
+}
+
+
+void MainObject::UpdateTimestamp()
+{
+  static const char *months[]={"Jan","Feb","Mar","Apr","May","Jun",
+			       "Jul","Aug","Sep","Oct","Nov","Dec"};
+  struct timespec ts;
+  struct tm tm;
+  char str[64];
+
+  clock_gettime(CLOCK_REALTIME,&ts);
+  if(d_format==MainObject::Rfc3164) {
+    //
+    // One-second resolution, so only rebuild when the second changes.
+    // The month names are spelled out here rather than with strftime(3),
+    // as RFC 3164 requires English abbreviations regardless of locale.
+    //
+    if(ts.tv_sec==d_timestamp_second) {
+      return;
+    }
+    localtime_r(&ts.tv_sec,&tm);
+    snprintf(str,64,"<%d>%s %2d %02d:%02d:%02d",LOG_USER|LOG_INFO,
+	     months[tm.tm_mon],tm.tm_mday,tm.tm_hour,tm.tm_min,tm.tm_sec);
+  }
+  else {
+    gmtime_r(&ts.tv_sec,&tm);
+    snprintf(str,64,"<%d>1 %04d-%02d-%02dT%02d:%02d:%02d.%06ldZ",
+	     LOG_USER|LOG_INFO,tm.tm_year+1900,tm.tm_mon+1,tm.tm_mday,
+	     tm.tm_hour,tm.tm_min,tm.tm_sec,ts.tv_nsec/1000);
+  }
+  d_timestamp_second=ts.tv_sec;
+  d_timestamp=str;
+}
+
+
+QByteArray MainObject::NextMessage()
+{
+  //
+  // A duplicate is a verbatim repeat of the previous message, which is
+  // what a processor's duplicate suppression looks for.
+  //
+  if((!d_last_message.isEmpty())&&(d_duplicate_ratio>0.0)&&
+     ((double)(Random()>>11)/9007199254740992.0<d_duplicate_ratio)) {
+    d_duplicates++;
+    return d_last_message;
+  }
+
+  const QByteArray &hostname=d_hostnames.at(Random()%d_hostnames.size());
+  int len=d_payload_min;
+  if(d_payload_max>d_payload_min) {
+    len+=Random()%(d_payload_max-d_payload_min+1);
+  }
+
+  //
+  // Every original message carries a sequence number at the start of
+  // its payload, so that losses can be accounted for at the far end.
+  // It counts toward the payload size.
+  //
+  QByteArray seq="seq="+QByteArray::number((qulonglong)++d_sequence);
+  QByteArray msg;
+  msg.reserve(d_timestamp.size()+hostname.size()+d_header_tail.size()+
+	      seq.size()+len+2);
+  msg+=d_timestamp;
+  msg+=" ";
+  msg+=hostname;
+  msg+=d_header_tail;
+  msg+=seq;
+  if(len>seq.size()) {
+    msg+=" ";
+    msg.append(d_filler.constData(),len-seq.size()-1);
+  }
+  d_last_message=msg;
+
+  return msg;
+}
+
+
+bool MainObject::SendBatch(const QList<QByteArray> &msgs)
+{
+  if(d_transport==MainObject::Tcp) {
+    //
+    // Non-transparent framing [RFC 6587 Section 3.4.2]
+    //
+    QByteArray data;
+    for(int i=0;i<msgs.size();i++) {
+      data+=msgs.at(i);
+      data+="\n";
+    }
+    int offset=0;
+    while(offset<data.size()) {
+      ssize_t n=send(d_sock,data.constData()+offset,data.size()-offset,
+		     MSG_NOSIGNAL);
+      if(n<0) {
+	if(errno==EINTR) {
+	  continue;
+	}
+	fprintf(stderr,"lwsyslog-bench: send failed [%s]\n",strerror(errno));
+	d_send_errors++;
+	return false;
+      }
+      offset+=n;
+    }
+    d_sent+=msgs.size();
+    d_sent_bytes+=data.size();
+    return true;
+  }
+
+  int count=msgs.size();
+  for(int i=0;i<count;i++) {
+    d_iovec[i].iov_base=(void *)msgs.at(i).constData();
+    d_iovec[i].iov_len=msgs.at(i).size();
+    memset(&d_msgvec[i],0,sizeof(struct mmsghdr));
+    d_msgvec[i].msg_hdr.msg_iov=&d_iovec[i];
+    d_msgvec[i].msg_hdr.msg_iovlen=1;
+  }
+  int offset=0;
+  while(offset<count) {
+    int n=sendmmsg(d_sock,&d_msgvec[offset],count-offset,0);
+    if(n<0) {
+      if(errno==EINTR) {
+	continue;
+      }
+      if((errno==EBADF)||(errno==ENOTCONN)||(errno==ENOTSOCK)) {
+	fprintf(stderr,"lwsyslog-bench: send failed [%s]\n",strerror(errno));
+	return false;
+      }
+
+      //
+      // Typically ECONNREFUSED, reported for an earlier datagram
+      // that found no listener. Count it and carry on.
+      //
+      d_send_errors++;
+      offset++;
+      continue;
+    }
+    for(int i=0;i<n;i++) {
+      d_sent_bytes+=d_msgvec[offset+i].msg_len;
+    }
+    d_sent+=n;
+    offset+=n;
+  }
+
+  return true;
+}
+
+
+void MainObject::Report(int64_t elapsed_nsec) const
+{
+  static const char *transports[]={"UDP","TCP","Unix"};
+  double secs=(double)elapsed_nsec/1000000000.0;
+
+  if(secs<=0.0) {
+    secs=1e-9;
+  }
+  printf("transport: %s, format: RFC %s, hostnames: %d, payload: %d-%d bytes\n",
+	 transports[d_transport],(d_format==MainObject::Rfc3164)?"3164":"5424",
+	 d_hostnames.size(),d_payload_min,d_payload_max);
+  printf("sent %" PRIu64 " messages (%" PRIu64 " bytes) in %.3f seconds\n",
+	 d_sent,d_sent_bytes,secs);
+  printf("achieved rate: %.0f msgs/sec (%.2f MB/sec)\n",
+	 (double)d_sent/secs,(double)d_sent_bytes/secs/1000000.0);
+  if(d_rate>0.0) {
+    printf("target rate: %.0f msgs/sec\n",d_rate);
+  }
+  printf("duplicates: %" PRIu64 ", send errors: %" PRIu64 "\n",
+	 d_duplicates,d_send_errors);
+}
+
+
+uint64_t MainObject::Random()
+{
+  //
+  // Xorshift64*; repeatable for a given --seed and far cheaper than
+  // anything that would show up in the send loop.
+  //
+  d_random_state^=d_random_state>>12;
+  d_random_state^=d_random_state<<25;
+  d_random_state^=d_random_state>>27;
+
+  return d_random_state*2685821657736338717ULL;
+}
+
+
+int64_t MainObject::MonotonicNsec()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+
+  return (int64_t)ts.tv_sec*1000000000+ts.tv_nsec;
+}
+
+
+int main(int argc,char *argv[])
+{
+  QCoreApplication a(argc,argv);
+
+  new MainObject();
+
+  return a.exec();
+}
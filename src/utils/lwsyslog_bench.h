@@ -0,0 +1,100 @@
+// lwsyslog_bench.h
+//
+// Headless syslog load generator
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef LWSYSLOG_BENCH_H
+#define LWSYSLOG_BENCH_H
+
+#include <stdint.h>
+#include <time.h>
+#include <sys/socket.h>
+
+#include <vector>
+
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+
+//
+// Global Definitions
+//
+#define LWSYSLOG_BENCH_USAGE "[--transport=udp|tcp|unix] [--address=<addr>] [--port=<port>] [--socket=<path>] [--format=3164|5424] [--rate=<msgs/sec>] [--count=<msgs>] [--duration=<secs>] [--hostnames=<num>] [--payload-size=<min>[-<max>]] [--duplicate-ratio=<ratio>] [--batch-size=<msgs>] [--seed=<num>]\n\n"
+
+//
+// Defaults
+//
+#define LWSYSLOG_BENCH_DEFAULT_ADDRESS "127.0.0.1"
+#define LWSYSLOG_BENCH_DEFAULT_PORT 514
+#define LWSYSLOG_BENCH_DEFAULT_SOCKET "/dev/log"
+#define LWSYSLOG_BENCH_DEFAULT_COUNT 100000
+#define LWSYSLOG_BENCH_DEFAULT_HOSTNAMES 1
+#define LWSYSLOG_BENCH_DEFAULT_PAYLOAD_SIZE 64
+#define LWSYSLOG_BENCH_DEFAULT_BATCH_SIZE 64
+#define LWSYSLOG_BENCH_MAX_BATCH_SIZE 1024
+#define LWSYSLOG_BENCH_MAX_PAYLOAD_SIZE 60000
+#define LWSYSLOG_BENCH_MIN_PAYLOAD_SIZE 24  // "seq=" plus 20 digits
+
+class MainObject : public QObject
+{
+  Q_OBJECT
+ public:
+  enum Transport {Udp=0,Tcp=1,Unix=2};
+  enum Format {Rfc3164=0,Rfc5424=1};
+  MainObject(QObject *parent=0);
+
+ private:
+  bool OpenSocket(QString *err_msg);
+  void Run();
+  void UpdateTimestamp();
+  QByteArray NextMessage();
+  int SendBatch(const QList<QByteArray> &msgs);
+  void Report(int64_t elapsed_nsec) const;
+  uint64_t Random();
+  static int64_t MonotonicNsec();
+  Transport d_transport;
+  QString d_address;
+  uint16_t d_port;
+  QString d_socket_path;
+  Format d_format;
+  double d_rate;
+  uint64_t d_count;
+  double d_duration;
+  QList<QByteArray> d_hostnames;
+  int d_payload_min;
+  int d_payload_max;
+  double d_duplicate_ratio;
+  int d_batch_size;
+  uint64_t d_random_state;
+  int d_sock;
+  QByteArray d_filler;
+  QByteArray d_header_tail;
+  QByteArray d_timestamp;
+  time_t d_timestamp_second;
+  QByteArray d_last_message;
+  uint64_t d_sequence;
+  uint64_t d_sent;
+  uint64_t d_sent_bytes;
+  uint64_t d_duplicates;
+  uint64_t d_send_errors;
+  std::vector<struct mmsghdr> d_msgvec;
+  std::vector<struct iovec> d_iovec;
+};
+
+
+#endif  // LWSYSLOG_BENCH_H
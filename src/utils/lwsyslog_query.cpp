@@ -0,0 +1,1143 @@
+// lwsyslog_query.cpp
+//
+// Time range, host and level queries against an lwsyslogger LogRoot
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QThread>
+#include <QThreadPool>
+
+#include "cmdswitch.h"
+#include "lwsyslog_query.h"
+
+static const char *__facility_names[]=
+  {"KERN","USER","MAIL","DAEMON","AUTH","SYSLOG","LPR","NEWS",
+   "UUCP","CRON","AUTHPRIV","FTP","NTP","AUDIT","ALERT","CLOCK",
+   "LOCAL0","LOCAL1","LOCAL2","LOCAL3","LOCAL4","LOCAL5","LOCAL6","LOCAL7"};
+#define LWSYSLOG_QUERY_FACILITIES 24
+
+static const char *__severity_names[]=
+  {"EMERG","ALERT","CRIT","ERR","WARNING","NOTICE","INFO","DEBUG"};
+#define LWSYSLOG_QUERY_SEVERITIES 8
+
+static const char *__month_names[]=
+  {"Jan","Feb","Mar","Apr","May","Jun","Jul","Aug","Sep","Oct","Nov","Dec"};
+
+static bool __hit_less_than(const QueryHit &lhs,const QueryHit &rhs)
+{
+  return lhs.timestamp<rhs.timestamp;
+}
+
+
+static bool __digits(const char *data,int len,int *value)
+{
+  *value=0;
+  for(int i=0;i<len;i++) {
+    if(!isdigit(data[i])) {
+      return false;
+    }
+    *value=10*(*value)+data[i]-'0';
+  }
+  return true;
+}
+
+
+static int64_t __line_start(const char *data,int64_t pos)
+{
+  while((pos>0)&&(data[pos-1]!='\n')) {
+    pos--;
+  }
+  return pos;
+}
+
+
+static int64_t __next_line(const char *data,int64_t len,int64_t pos)
+{
+  const char *nl=(const char *)memchr(data+pos,'\n',len-pos);
+
+  if(nl==NULL) {
+    return len;
+  }
+  return nl-data+1;
+}
+
+
+QueryFile::QueryFile(const QString &pathname,Kind kind)
+{
+  d_pathname=pathname;
+  d_kind=kind;
+  d_fd=-1;
+  d_data=NULL;
+  d_size=0;
+  d_year=0;
+  d_month=0;
+  d_host_implied=false;
+  d_created=0;
+}
+
+
+QueryFile::~QueryFile()
+{
+  unmap();
+}
+
+
+QString QueryFile::pathname() const
+{
+  return d_pathname;
+}
+
+
+QueryFile::Kind QueryFile::kind() const
+{
+  return d_kind;
+}
+
+
+const char *QueryFile::data() const
+{
+  return d_data;
+}
+
+
+int64_t QueryFile::size() const
+{
+  return d_size;
+}
+
+
+bool QueryFile::map(QString *err_msg)
+{
+  struct stat st;
+
+  if((d_fd=open(d_pathname.toUtf8(),O_RDONLY))<0) {
+    *err_msg=strerror(errno);
+    return false;
+  }
+  if(fstat(d_fd,&st)!=0) {
+    *err_msg=strerror(errno);
+    unmap();
+    return false;
+  }
+  d_size=st.st_size;
+  setModified(st.st_mtime);
+  if(d_size>0) {
+    void *data=mmap(NULL,d_size,PROT_READ,MAP_SHARED,d_fd,0);
+    if(data==MAP_FAILED) {
+      *err_msg=strerror(errno);
+      unmap();
+      return false;
+    }
+    d_data=(char *)data;
+  }
+
+  return true;
+}
+
+
+void QueryFile::unmap()
+{
+  if(d_data!=NULL) {
+    munmap(d_data,d_size);
+    d_data=NULL;
+  }
+  if(d_fd>=0) {
+    close(d_fd);
+    d_fd=-1;
+  }
+}
+
+
+int QueryFile::year() const
+{
+  return d_year;
+}
+
+
+int QueryFile::month() const
+{
+  return d_month;
+}
+
+
+void QueryFile::setModified(time_t mtime)
+{
+  struct tm tm;
+
+  localtime_r(&mtime,&tm);
+  d_year=tm.tm_year+1900;
+  d_month=tm.tm_mon+1;
+}
+
+
+bool QueryFile::hostImplied() const
+{
+  return d_host_implied;
+}
+
+
+void QueryFile::setHostImplied(bool state)
+{
+  d_host_implied=state;
+}
+
+
+bool QueryFile::loadIndex(QString *err_msg)
+{
+  StoreFileHeader hdr;
+  StoreIndexEntry entry;
+  QString pathname=d_pathname;
+
+  pathname.replace(pathname.length()-strlen(STORE_SEGMENT_SUFFIX),
+		   strlen(STORE_SEGMENT_SUFFIX),STORE_INDEX_SUFFIX);
+  QFile file(pathname);
+  if(!file.open(QIODevice::ReadOnly)) {
+    *err_msg=file.errorString();
+    return false;
+  }
+  QByteArray data=file.readAll();
+  file.close();
+  if((data.size()<(int)sizeof(hdr))) {
+    *err_msg="truncated index header";
+    return false;
+  }
+  memcpy(&hdr,data.constData(),sizeof(hdr));
+  if((strncmp(hdr.magic,STORE_INDEX_MAGIC,sizeof(hdr.magic))!=0)||
+     (hdr.version!=STORE_FORMAT_VERSION)) {
+    *err_msg="unrecognized index format";
+    return false;
+  }
+  d_created=hdr.created;
+  d_host_names.clear();
+  d_buckets.clear();
+
+  //
+  // A partial entry at the end belongs to a segment still being written,
+  // and is picked up on the next load.
+  //
+  int pos=sizeof(hdr);
+  while((pos+(int)sizeof(entry))<=data.size()) {
+    memcpy(&entry,data.constData()+pos,sizeof(entry));
+    if((pos+(int)sizeof(entry)+entry.length)>data.size()) {
+      break;
+    }
+    switch(entry.type) {
+    case STORE_INDEX_BUCKET:
+      d_buckets.push_back(QPair<int64_t,int64_t>(entry.timestamp,
+						 entry.offset));
+      break;
+
+    case STORE_INDEX_HOST:
+      d_host_names[entry.host_id]=
+	QByteArray(data.constData()+pos+sizeof(entry),entry.length);
+      break;
+    }
+    pos+=sizeof(entry)+entry.length;
+  }
+
+  return true;
+}
+
+
+int64_t QueryFile::created() const
+{
+  return d_created;
+}
+
+
+uint32_t QueryFile::hostId(const QByteArray &hostname) const
+{
+  for(QHash<uint32_t,QByteArray>::const_iterator it=d_host_names.begin();
+      it!=d_host_names.end();it++) {
+    if(it.value()==hostname) {
+      return it.key();
+    }
+  }
+  return 0;
+}
+
+
+QByteArray QueryFile::hostName(uint32_t host_id) const
+{
+  return d_host_names.value(host_id,"-");
+}
+
+
+QList<QPair<int64_t,int64_t> > QueryFile::buckets() const
+{
+  return d_buckets;
+}
+
+
+QueryTask::QueryTask(QueryFile *file,int64_t begin,int64_t end,
+		     const QueryFilter *filter)
+  : QRunnable()
+{
+  d_file=file;
+  d_begin=begin;
+  d_end=end;
+  d_filter=filter;
+  setAutoDelete(false);
+}
+
+
+void QueryTask::run()
+{
+  if(d_file->kind()==QueryFile::KindSegment) {
+    QueryTask::scanSegment(d_file->data()+d_begin,d_end-d_begin,
+			   d_file,d_filter,&d_hits);
+  }
+  else {
+    QueryTask::scanText(d_file->data()+d_begin,d_end-d_begin,
+			d_file,d_filter,&d_hits);
+  }
+}
+
+
+const std::vector<QueryHit> &QueryTask::hits() const
+{
+  return d_hits;
+}
+
+
+int64_t QueryTask::scanText(const char *data,int64_t len,
+			    const QueryFile *file,const QueryFilter *filter,
+			    std::vector<QueryHit> *hits)
+{
+  int64_t pos=0;
+  int64_t timestamp=0;
+
+  while(pos<len) {
+    const char *nl=(const char *)memchr(data+pos,'\n',len-pos);
+    if(nl==NULL) {
+      break;  // Incomplete line
+    }
+    int64_t end=nl-data;
+    int n=QueryTask::textTimestamp(data+pos,end-pos,file,&timestamp);
+    if((n>0)&&(timestamp>=filter->from)&&(timestamp<=filter->to)) {
+      bool matched=filter->host.isEmpty()||file->hostImplied();
+      if(!matched) {
+	int64_t host=pos+n;
+	while((host<end)&&(data[host]==' ')) {
+	  host++;
+	}
+	matched=((end-host)>=filter->host.size())&&
+	  (memcmp(data+host,filter->host.constData(),filter->host.size())==0)&&
+	  (((host+filter->host.size())==end)||
+	   (data[host+filter->host.size()]==' '));
+      }
+      if(matched&&(!filter->token.isEmpty())) {
+	matched=QueryTask::containsToken(data+pos,end-pos,filter->token);
+      }
+      if(matched) {
+	QueryHit hit;
+	hit.timestamp=timestamp;
+	hit.line=QByteArray(data+pos,end-pos);
+	hits->push_back(hit);
+      }
+    }
+    pos=end+1;
+  }
+
+  return pos;
+}
+
+
+int64_t QueryTask::scanSegment(const char *data,int64_t len,
+			       const QueryFile *file,const QueryFilter *filter,
+			       std::vector<QueryHit> *hits)
+{
+  StoreRecordHeader hdr;
+  int64_t pos=0;
+  uint32_t host_id=0;
+
+  if(!filter->host.isEmpty()) {
+    host_id=file->hostId(filter->host);
+  }
+  while((pos+(int64_t)sizeof(hdr))<=len) {
+    memcpy(&hdr,data+pos,sizeof(hdr));
+    int64_t next=pos+sizeof(hdr)+hdr.length;
+    if(next>len) {
+      break;  // Incomplete record
+    }
+    if((hdr.timestamp>=filter->from)&&(hdr.timestamp<=filter->to)&&
+       (filter->host.isEmpty()||((host_id!=0)&&(hdr.host_id==host_id)))&&
+       (hdr.facility<LWSYSLOG_QUERY_FACILITIES)&&
+       ((filter->facility_mask&(1u<<hdr.facility))!=0)&&
+       (hdr.severity<LWSYSLOG_QUERY_SEVERITIES)&&
+       ((filter->severity_mask&(1u<<hdr.severity))!=0)&&
+       (hdr.msg_offset<=hdr.length)) {
+      const char *msg=data+pos+sizeof(hdr)+hdr.msg_offset;
+      int msg_len=hdr.length-hdr.msg_offset;
+      if((msg_len>=3)&&(memcmp(msg,"\xEF\xBB\xBF",3)==0)) {
+	msg+=3;
+	msg_len-=3;
+      }
+      if((!filter->token.isEmpty())&&
+	 (!QueryTask::containsToken(msg,msg_len,filter->token))) {
+	pos=next;
+	continue;
+      }
+      QueryHit hit;
+      hit.timestamp=hdr.timestamp;
+      hit.line=QDateTime::fromMSecsSinceEpoch(hdr.timestamp/1000).
+	toString("yyyy-MM-ddThh:mm:ss.zzz").toUtf8()+" "+
+	file->hostName(hdr.host_id)+" "+
+	__facility_names[hdr.facility]+"."+__severity_names[hdr.severity]+" "+
+	QByteArray(msg,msg_len);
+      hits->push_back(hit);
+    }
+    pos=next;
+  }
+
+  return pos;
+}
+
+
+bool QueryTask::containsToken(const char *data,int64_t len,
+			      const QByteArray &token)
+{
+  //
+  // A token is a run of letters, digits, underscores or non-ASCII bytes,
+  // as split out by lwsyslogger for its Bloom filters, and is matched
+  // case-insensitively.
+  //
+  int64_t start=-1;
+  for(int64_t i=0;i<=len;i++) {
+    uint8_t c=(i<len)?data[i]:0;
+    if(isalnum(c)||(c=='_')||(c>=0x80)) {
+      if(start<0) {
+	start=i;
+      }
+    }
+    else {
+      if((start>=0)&&((i-start)==token.size())&&
+	 (strncasecmp(data+start,token.constData(),token.size())==0)) {
+	return true;
+      }
+      start=-1;
+    }
+  }
+
+  return false;
+}
+
+
+int QueryTask::textTimestamp(const char *data,int64_t len,
+			     const QueryFile *file,int64_t *usec)
+{
+  struct tm tm;
+  int ret=0;
+
+  //
+  // Accepts the timestamps written by the "%T" (RFC-5424) and "%t" (BSD)
+  // template wildcards. BSD timestamps carry no year, so take it from the
+  // file's modification time.
+  //
+  memset(&tm,0,sizeof(tm));
+  if((len>=19)&&(data[4]=='-')&&(data[7]=='-')&&
+     ((data[10]=='T')||(data[10]==' '))&&(data[13]==':')&&(data[16]==':')) {
+    if((!__digits(data,4,&tm.tm_year))||(!__digits(data+5,2,&tm.tm_mon))||
+       (!__digits(data+8,2,&tm.tm_mday))||(!__digits(data+11,2,&tm.tm_hour))||
+       (!__digits(data+14,2,&tm.tm_min))||(!__digits(data+17,2,&tm.tm_sec))) {
+      return 0;
+    }
+    tm.tm_year-=1900;
+    tm.tm_mon-=1;
+    ret=19;
+  }
+  else {
+    if((len<15)||(data[3]!=' ')||(data[6]!=' ')||(data[9]!=':')||
+       (data[12]!=':')) {
+      return 0;
+    }
+    tm.tm_mon=-1;
+    for(int i=0;i<12;i++) {
+      if(strncmp(data,__month_names[i],3)==0) {
+	tm.tm_mon=i;
+	break;
+      }
+    }
+    if((tm.tm_mon<0)||
+       (!__digits(data+4+(data[4]==' '),2-(data[4]==' '),&tm.tm_mday))||
+       (!__digits(data+7,2,&tm.tm_hour))||(!__digits(data+10,2,&tm.tm_min))||
+       (!__digits(data+13,2,&tm.tm_sec))) {
+      return 0;
+    }
+    tm.tm_year=file->year()-1900;
+    if((tm.tm_mon+1)>file->month()) {
+      tm.tm_year--;  // From before the new year
+    }
+    ret=15;
+  }
+  tm.tm_isdst=-1;
+  time_t t=mktime(&tm);
+  if(t==(time_t)-1) {
+    return 0;
+  }
+  *usec=1000000*(int64_t)t;
+
+  return ret;
+}
+
+
+MainObject::MainObject(QObject *parent)
+  : QObject(parent)
+{
+  QStringList paths;
+  bool follow=false;
+  bool ok=false;
+  int threads=QThread::idealThreadCount();
+
+  d_logroot=LWSYSLOG_QUERY_DEFAULT_LOGROOT;
+  d_filter.from=0;
+  d_filter.to=LLONG_MAX;
+  d_filter.level_filter=false;
+  d_filter.facility_mask=0xFFFFFFFF;
+  d_filter.severity_mask=0xFFFFFFFF;
+  d_skipped_files=0;
+  d_following=false;
+
+  CmdSwitch *cmd=
+    new CmdSwitch("lwsyslog-query",VERSION,LWSYSLOG_QUERY_USAGE);
+  for(int i=0;i<cmd->keys();i++) {
+    if(cmd->key(i)=="--logroot") {
+      d_logroot=cmd->value(i);
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--from") {
+      d_filter.from=ParseDateTime(cmd->value(i),&ok);
+      if(!ok) {
+	fprintf(stderr,"lwsyslog-query: invalid --from value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--to") {
+      d_filter.to=ParseDateTime(cmd->value(i),&ok);
+      if(!ok) {
+	fprintf(stderr,"lwsyslog-query: invalid --to value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--host") {
+      d_filter.host=cmd->value(i).toUtf8();
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--token") {
+      d_filter.token=cmd->value(i).toUtf8().toLower();
+      if(d_filter.token.isEmpty()||
+	 (!QueryTask::containsToken(d_filter.token.constData(),
+				    d_filter.token.size(),d_filter.token))) {
+	fprintf(stderr,"lwsyslog-query: invalid --token value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--facility") {
+      d_filter.facility_mask=ParseFacilities(cmd->value(i),&ok);
+      if(!ok) {
+	fprintf(stderr,"lwsyslog-query: invalid --facility value\n");
+	exit(1);
+      }
+      d_filter.level_filter=true;
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--severity") {
+      d_filter.severity_mask=ParseSeverities(cmd->value(i),&ok);
+      if(!ok) {
+	fprintf(stderr,"lwsyslog-query: invalid --severity value\n");
+	exit(1);
+      }
+      d_filter.level_filter=true;
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--threads") {
+      threads=cmd->value(i).toInt(&ok);
+      if((!ok)||(threads<1)) {
+	fprintf(stderr,"lwsyslog-query: invalid --threads value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--follow") {
+      follow=true;
+      cmd->setProcessed(i,true);
+    }
+    if((!cmd->processed(i))&&(cmd->key(i).left(1)!="-")) {
+      paths.push_back(cmd->key(i));
+      cmd->setProcessed(i,true);
+    }
+    if(!cmd->processed(i)) {
+      fprintf(stderr,"lwsyslog-query: unrecognized option \"%s\"\n",
+	      cmd->key(i).toUtf8().constData());
+      exit(1);
+    }
+  }
+  if(d_filter.to<d_filter.from) {
+    fprintf(stderr,"lwsyslog-query: --to is earlier than --from\n");
+    exit(1);
+  }
+  if(follow&&(d_filter.to!=LLONG_MAX)) {
+    fprintf(stderr,"lwsyslog-query: --follow and --to are mutually exclusive\n");
+    exit(1);
+  }
+  if(paths.isEmpty()) {
+    paths.push_back(d_logroot);
+  }
+  d_search_paths=paths;
+
+  //
+  // Find the candidate ranges in each file
+  //
+  for(int i=0;i<paths.size();i++) {
+    FindFiles(paths.at(i));
+  }
+  if(d_skipped_files>0) {
+    fprintf(stderr,
+	    "lwsyslog-query: skipped %d logfile(s) lacking facility/severity data\n",
+	    d_skipped_files);
+  }
+
+  //
+  // Scan them
+  //
+  QThreadPool *pool=new QThreadPool(this);
+  pool->setMaxThreadCount(threads);
+  for(int i=0;i<d_tasks.size();i++) {
+    pool->start(d_tasks.at(i));
+  }
+  pool->waitForDone();
+  std::vector<QueryHit> hits;
+  for(int i=0;i<d_tasks.size();i++) {
+    hits.insert(hits.end(),d_tasks.at(i)->hits().begin(),
+		d_tasks.at(i)->hits().end());
+    delete d_tasks.at(i);
+  }
+  d_tasks.clear();
+  Print(&hits);
+  for(int i=0;i<d_files.size();i++) {
+    d_files.at(i)->unmap();
+  }
+
+  if(!follow) {
+    exit(0);
+  }
+
+  //
+  // Follow Mode
+  //
+  d_following=true;
+  d_follow_timer=new QTimer(this);
+  connect(d_follow_timer,SIGNAL(timeout()),this,SLOT(followData()));
+  d_follow_timer->start(LWSYSLOG_QUERY_FOLLOW_INTERVAL);
+}
+
+
+void MainObject::followData()
+{
+  struct stat st;
+  QString err_msg;
+  std::vector<QueryHit> hits;
+
+  //
+  // Pick up newly created files (new segments, new hosts, rotated copies)
+  //
+  for(int i=0;i<d_search_paths.size();i++) {
+    FindFiles(d_search_paths.at(i));
+  }
+
+  for(int i=0;i<d_files.size();i++) {
+    QueryFile *file=d_files.at(i);
+    QString pathname=file->pathname();
+    if(stat(pathname.toUtf8(),&st)!=0) {
+      continue;  // Rotated away, pruned below
+    }
+    file->setModified(st.st_mtime);
+    int64_t offset=d_follow_offsets.value(pathname);
+    if((st.st_ino!=d_follow_inodes.value(pathname))||(st.st_size<offset)) {
+      offset=0;  // Replaced or truncated by log rotation
+      d_follow_inodes[pathname]=st.st_ino;
+    }
+    if((file->kind()==QueryFile::KindSegment)&&
+       (offset<(int64_t)sizeof(StoreFileHeader))) {
+      offset=sizeof(StoreFileHeader);
+    }
+    if(st.st_size<=offset) {
+      d_follow_offsets[pathname]=offset;
+      continue;
+    }
+    QFile f(pathname);
+    if((!f.open(QIODevice::ReadOnly))||(!f.seek(offset))) {
+      continue;
+    }
+    QByteArray data=f.read(st.st_size-offset);
+    f.close();
+    if(file->kind()==QueryFile::KindSegment) {
+      file->loadIndex(&err_msg);  // For newly interned hostnames
+      offset+=QueryTask::scanSegment(data.constData(),data.size(),
+				     file,&d_filter,&hits);
+    }
+    else {
+      offset+=QueryTask::scanText(data.constData(),data.size(),
+				  file,&d_filter,&hits);
+    }
+    d_follow_offsets[pathname]=offset;
+  }
+  Print(&hits);
+
+  //
+  // Stop watching rotated copies, which have now been read to the end,
+  // and forget files that no longer exist. Files that are later recreated
+  // under the same name are picked up again by FindFiles().
+  //
+  for(int i=d_files.size()-1;i>=0;i--) {
+    QString pathname=d_files.at(i)->pathname();
+    if(d_follow_rotated.contains(pathname)||
+       (stat(pathname.toUtf8(),&st)!=0)) {
+      delete d_files.at(i);
+      d_files.removeAt(i);
+    }
+  }
+  d_follow_rotated.clear();
+  QStringList pathnames=d_follow_offsets.keys();
+  for(int i=0;i<pathnames.size();i++) {
+    if(stat(pathnames.at(i).toUtf8(),&st)!=0) {
+      d_follow_offsets.remove(pathnames.at(i));
+      d_follow_inodes.remove(pathnames.at(i));
+    }
+  }
+}
+
+
+void MainObject::FindFiles(const QString &path)
+{
+  QFileInfo info(path);
+
+  if(info.isDir()) {
+    QDirIterator it(path,QDir::Files,QDirIterator::Subdirectories);
+    while(it.hasNext()) {
+      AddFile(it.next());
+    }
+  }
+  else {
+    if(d_following) {
+      if(info.exists()) {
+	AddFile(path);
+      }
+      return;
+    }
+    if(!info.exists()) {
+      fprintf(stderr,"lwsyslog-query: no such file or directory \"%s\"\n",
+	      path.toUtf8().constData());
+      exit(1);
+    }
+    AddFile(path);
+  }
+}
+
+
+bool MainObject::AddFile(const QString &pathname)
+{
+  QString err_msg;
+  QueryFile::Kind kind=QueryFile::KindText;
+  struct stat st;
+
+  if(d_follow_offsets.contains(pathname)||
+     pathname.endsWith(STORE_INDEX_SUFFIX)||
+     pathname.endsWith(BLOOMFILTER_SUFFIX)||
+     pathname.endsWith(TRIGRAMINDEX_SUFFIX)||
+     pathname.endsWith(".tmp")) {
+    return false;
+  }
+  if((!d_following)&&
+     ((!d_filter.host.isEmpty())||(!d_filter.token.isEmpty()))&&
+     (!pathname.endsWith(STORE_SEGMENT_SUFFIX))) {
+    //
+    // Rotated logfiles may have a Bloom filter of the hostnames (and
+    // optionally the message tokens) in them
+    //
+    BloomFilter *filter=new BloomFilter();
+    bool absent=false;
+    if(filter->load(BloomFilter::sidecarPathname(pathname),&err_msg)) {
+      absent=((!d_filter.host.isEmpty())&&
+	      (!filter->mayContain(BloomFilter::hostKey(d_filter.host))))||
+	((d_filter.token.size()>=BLOOMFILTER_MIN_TOKEN_LENGTH)&&
+	 filter->hasTokens()&&
+	 (!filter->mayContain(BloomFilter::tokenKey(d_filter.token))));
+    }
+    delete filter;
+    if(absent) {
+      d_follow_offsets[pathname]=0;  // So as not to be picked up by --follow
+      return false;
+    }
+  }
+  if(pathname.endsWith(ARCHIVE_SUFFIX)) {
+    if(d_following) {
+      return false;
+    }
+    fprintf(stderr,
+	    "lwsyslog-query: skipping archive \"%s\", use lwsyslog-archive\n",
+	    pathname.toUtf8().constData());
+    return false;
+  }
+  if(pathname.endsWith(".gz")||pathname.endsWith(".xz")||
+     pathname.endsWith(".zst")) {
+    if(d_following) {
+      return false;
+    }
+    fprintf(stderr,"lwsyslog-query: skipping compressed logfile \"%s\"\n",
+	    pathname.toUtf8().constData());
+    return false;
+  }
+  if(pathname.endsWith(STORE_SEGMENT_SUFFIX)) {
+    kind=QueryFile::KindSegment;
+  }
+  else {
+    if(d_filter.level_filter) {
+      if(!d_following) {
+	d_skipped_files++;
+      }
+      return false;
+    }
+  }
+  if(stat(pathname.toUtf8(),&st)!=0) {
+    return false;
+  }
+
+  QueryFile *file=new QueryFile(pathname,kind);
+
+  //
+  // FileByHostname names each file after the (mangled) hostname,
+  // with the rotation date appended to older ones.
+  //
+  if((kind==QueryFile::KindText)&&(!d_filter.host.isEmpty())) {
+    QString host=QString::fromUtf8(d_filter.host).replace("-","_");
+    QRegularExpression exp("^"+QRegularExpression::escape(host)+
+			   "(-\\d{4}-\\d{2}-\\d{2}.*)?$");
+    file->setHostImplied(exp.match(QFileInfo(pathname).fileName()).
+			 hasMatch());
+  }
+
+  //
+  // Files that appear while following are read from the start, unless
+  // they are just an already known file renamed by log rotation.
+  //
+  d_files.push_back(file);
+  if(d_following) {
+    d_follow_offsets[pathname]=0;
+    QString old_pathname=d_follow_inodes.key(st.st_ino);
+    if(!old_pathname.isEmpty()) {
+      //
+      // Read the rest of the rotated copy once, then drop it
+      //
+      d_follow_offsets[pathname]=d_follow_offsets.value(old_pathname);
+      d_follow_rotated.push_back(pathname);
+    }
+    d_follow_inodes[pathname]=st.st_ino;
+    return true;
+  }
+  d_follow_inodes[pathname]=st.st_ino;
+  if(!file->map(&err_msg)) {
+    fprintf(stderr,"lwsyslog-query: unable to open \"%s\" [%s]\n",
+	    pathname.toUtf8().constData(),err_msg.toUtf8().constData());
+    d_follow_offsets[pathname]=st.st_size;
+    return false;
+  }
+  d_follow_offsets[pathname]=file->size();
+  if(kind==QueryFile::KindSegment) {
+    PlanSegment(file);
+  }
+  else {
+    PlanText(file);
+  }
+
+  return true;
+}
+
+
+void MainObject::PlanText(QueryFile *file)
+{
+  int64_t begin=0;
+  int64_t end=file->size();
+
+  if(d_filter.from>0) {
+    begin=TextOffset(file,
+		     d_filter.from-1000000ll*LWSYSLOG_QUERY_TEXT_SLACK);
+  }
+  if(d_filter.to!=LLONG_MAX) {
+    end=TextOffset(file,d_filter.to+1000000ll*(LWSYSLOG_QUERY_TEXT_SLACK+1));
+  }
+  while(begin<end) {
+    int64_t chunk_end=end;
+    if((end-begin)>LWSYSLOG_QUERY_CHUNK_SIZE) {
+      chunk_end=__next_line(file->data(),end,begin+LWSYSLOG_QUERY_CHUNK_SIZE);
+    }
+    d_tasks.push_back(new QueryTask(file,begin,chunk_end,&d_filter));
+    begin=chunk_end;
+  }
+}
+
+
+void MainObject::PlanSegment(QueryFile *file)
+{
+  QString err_msg;
+  int64_t begin=sizeof(StoreFileHeader);
+  int64_t end=file->size();
+  StoreFileHeader hdr;
+
+  if(file->size()<begin) {
+    return;
+  }
+  memcpy(&hdr,file->data(),sizeof(hdr));
+  if((strncmp(hdr.magic,STORE_SEGMENT_MAGIC,sizeof(hdr.magic))!=0)||
+     (hdr.version!=STORE_FORMAT_VERSION)) {
+    fprintf(stderr,"lwsyslog-query: \"%s\" is not a valid segment\n",
+	    file->pathname().toUtf8().constData());
+    return;
+  }
+  if(hdr.created>d_filter.to) {
+    return;
+  }
+
+  //
+  // Without an index, fall back to scanning the whole segment
+  //
+  QList<QPair<int64_t,int64_t> > buckets;
+  if(file->loadIndex(&err_msg)) {
+    if((!d_filter.host.isEmpty())&&(file->hostId(d_filter.host)==0)) {
+      return;
+    }
+    buckets=file->buckets();
+  }
+  else {
+    fprintf(stderr,"lwsyslog-query: unable to load index for \"%s\" [%s]\n",
+	    file->pathname().toUtf8().constData(),err_msg.toUtf8().constData());
+  }
+
+  //
+  // Buckets are in order of arrival, so the candidate range runs from
+  // the last one starting at or before 'from' up to the first one
+  // starting after 'to'.
+  //
+  for(int i=0;i<buckets.size();i++) {
+    if((buckets.at(i).first<=d_filter.from)&&
+       (buckets.at(i).second<=end)) {
+      begin=buckets.at(i).second;
+    }
+    if(buckets.at(i).first>d_filter.to) {
+      end=std::min(end,buckets.at(i).second);
+      break;
+    }
+  }
+
+  //
+  // Split the range at bucket boundaries, which are also record
+  // boundaries, into chunks of roughly equal size.
+  //
+  int64_t chunk_begin=begin;
+  for(int i=0;i<buckets.size();i++) {
+    int64_t offset=buckets.at(i).second;
+    if((offset>chunk_begin)&&(offset<end)&&
+       ((offset-chunk_begin)>=LWSYSLOG_QUERY_CHUNK_SIZE)) {
+      d_tasks.push_back(new QueryTask(file,chunk_begin,offset,&d_filter));
+      chunk_begin=offset;
+    }
+  }
+  if(chunk_begin<end) {
+    d_tasks.push_back(new QueryTask(file,chunk_begin,end,&d_filter));
+  }
+}
+
+
+void MainObject::Print(std::vector<QueryHit> *hits) const
+{
+  std::stable_sort(hits->begin(),hits->end(),__hit_less_than);
+  for(unsigned i=0;i<hits->size();i++) {
+    fwrite(hits->at(i).line.constData(),1,hits->at(i).line.size(),stdout);
+    fputc('\n',stdout);
+  }
+  fflush(stdout);
+}
+
+
+int64_t MainObject::TextOffset(const QueryFile *file,int64_t target) const
+{
+  const char *data=file->data();
+  int64_t lo=0;
+  int64_t hi=file->size();
+  int64_t timestamp=0;
+
+  //
+  // Find the start of the first line stamped at or after 'target'.
+  // Lines without a recognizable timestamp (continuations, etc) are
+  // skipped over when probing.
+  //
+  while(lo<hi) {
+    int64_t mid=lo+(hi-lo)/2;
+    int64_t line=mid;
+    if(__line_start(data,mid)!=mid) {
+      line=__next_line(data,file->size(),mid);
+    }
+    while((line<hi)&&
+	  (QueryTask::textTimestamp(data+line,file->size()-line,file,
+				    &timestamp)==0)) {
+      line=__next_line(data,file->size(),line);
+    }
+    if((line<hi)&&(timestamp<target)) {
+      lo=__next_line(data,file->size(),line);
+    }
+    else {
+      hi=mid;
+    }
+  }
+
+  return __line_start(data,std::min(lo,hi));
+}
+
+
+int64_t MainObject::ParseDateTime(const QString &str,bool *ok) const
+{
+  QDateTime dt;
+  QStringList formats;
+  formats.push_back("yyyy-MM-ddThh:mm:ss");
+  formats.push_back("yyyy-MM-dd hh:mm:ss");
+  formats.push_back("yyyy-MM-ddThh:mm");
+  formats.push_back("yyyy-MM-dd hh:mm");
+  formats.push_back("yyyy-MM-dd");
+
+  for(int i=0;i<formats.size();i++) {
+    dt=QDateTime::fromString(str,formats.at(i));
+    if(dt.isValid()) {
+      *ok=true;
+      return 1000*dt.toMSecsSinceEpoch();
+    }
+  }
+
+  //
+  // A bare time of day refers to today
+  //
+  QTime time=QTime::fromString(str,"hh:mm:ss");
+  if(!time.isValid()) {
+    time=QTime::fromString(str,"hh:mm");
+  }
+  if(time.isValid()) {
+    *ok=true;
+    return 1000*QDateTime(QDate::currentDate(),time).toMSecsSinceEpoch();
+  }
+  *ok=false;
+
+  return 0;
+}
+
+
+uint32_t MainObject::ParseFacilities(const QString &str,bool *ok) const
+{
+  uint32_t ret=0;
+  QStringList f0=str.split(",",Qt::SkipEmptyParts);
+
+  for(int i=0;i<f0.size();i++) {
+    QString name=f0.at(i).trimmed().toUpper();
+    int facility=name.toInt(ok);
+    if(!(*ok)) {
+      facility=-1;
+      for(int j=0;j<LWSYSLOG_QUERY_FACILITIES;j++) {
+	if(name==__facility_names[j]) {
+	  facility=j;
+	}
+      }
+    }
+    if((facility<0)||(facility>=LWSYSLOG_QUERY_FACILITIES)) {
+      *ok=false;
+      return 0;
+    }
+    ret|=1u<<facility;
+  }
+  *ok=ret!=0;
+
+  return ret;
+}
+
+
+uint32_t MainObject::ParseSeverities(const QString &str,bool *ok) const
+{
+  uint32_t ret=0;
+  QStringList f0=str.split(",",Qt::SkipEmptyParts);
+
+  //
+  // A trailing '+' selects the given severity and all more severe ones
+  //
+  for(int i=0;i<f0.size();i++) {
+    QString name=f0.at(i).trimmed().toUpper();
+    bool and_above=name.endsWith("+");
+    if(and_above) {
+      name=name.left(name.length()-1);
+    }
+    int severity=name.toInt(ok);
+    if(!(*ok)) {
+      severity=-1;
+      for(int j=0;j<LWSYSLOG_QUERY_SEVERITIES;j++) {
+	if(name==__severity_names[j]) {
+	  severity=j;
+	}
+      }
+    }
+    if((severity<0)||(severity>=LWSYSLOG_QUERY_SEVERITIES)) {
+      *ok=false;
+      return 0;
+    }
+    ret|=1u<<severity;
+    if(and_above) {
+      ret|=(1u<<severity)-1;
+    }
+  }
+  *ok=ret!=0;
+
+  return ret;
+}
+
+
+int main(int argc,char *argv[])
+{
+  QCoreApplication a(argc,argv);
+
+  new MainObject();
+
+  return a.exec();
+}
@@ -0,0 +1,179 @@
+// lwsyslog_query.h
+//
+// Time range, host and level queries against an lwsyslogger LogRoot
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef LWSYSLOG_QUERY_H
+#define LWSYSLOG_QUERY_H
+
+#include <stdint.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <vector>
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QRunnable>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+
+#include "../lwsyslogger/archiveformat.h"
+#include "../lwsyslogger/bloomfilter.h"
+#include "../lwsyslogger/storeformat.h"
+#include "../lwsyslogger/trigramindex.h"
+
+//
+// Global Definitions
+//
+#define LWSYSLOG_QUERY_USAGE "[--logroot=<dir>] [--from=<datetime>] [--to=<datetime>] [--host=<hostname>] [--token=<word>] [--facility=<facility-list>] [--severity=<severity-list>] [--threads=<num>] [--follow] [<path> ...]\n\n"
+
+//
+// Defaults
+//
+#define LWSYSLOG_QUERY_DEFAULT_LOGROOT "/var/log/lwsyslogger"
+#define LWSYSLOG_QUERY_CHUNK_SIZE 4194304
+#define LWSYSLOG_QUERY_FOLLOW_INTERVAL 500
+
+//
+// Text logfiles are in order of arrival, but their timestamps come from
+// the originating hosts, so allow for some disagreement when seeking.
+//
+#define LWSYSLOG_QUERY_TEXT_SLACK 300
+
+struct QueryHit
+{
+  int64_t timestamp;
+  QByteArray line;
+};
+
+struct QueryFilter
+{
+  int64_t from;             // uSecs since the epoch, inclusive
+  int64_t to;               // uSecs since the epoch, inclusive
+  QByteArray host;
+  QByteArray token;         // Lower case
+  bool level_filter;
+  uint32_t facility_mask;
+  uint32_t severity_mask;
+};
+
+class QueryFile
+{
+ public:
+  enum Kind {KindText=0,KindSegment=1};
+  QueryFile(const QString &pathname,Kind kind);
+  ~QueryFile();
+  QString pathname() const;
+  Kind kind() const;
+  const char *data() const;
+  int64_t size() const;
+  bool map(QString *err_msg);
+  void unmap();
+  int year() const;
+  int month() const;
+  void setModified(time_t mtime);
+  bool hostImplied() const;
+  void setHostImplied(bool state);
+  bool loadIndex(QString *err_msg);
+  int64_t created() const;
+  uint32_t hostId(const QByteArray &hostname) const;
+  QByteArray hostName(uint32_t host_id) const;
+  QList<QPair<int64_t,int64_t> > buckets() const;
+
+ private:
+  QString d_pathname;
+  Kind d_kind;
+  int d_fd;
+  char *d_data;
+  int64_t d_size;
+  int d_year;
+  int d_month;
+  bool d_host_implied;
+  int64_t d_created;
+  QHash<uint32_t,QByteArray> d_host_names;
+  QList<QPair<int64_t,int64_t> > d_buckets;
+};
+
+
+class QueryTask : public QRunnable
+{
+ public:
+  QueryTask(QueryFile *file,int64_t begin,int64_t end,
+	    const QueryFilter *filter);
+  void run();
+  const std::vector<QueryHit> &hits() const;
+  static int64_t scanText(const char *data,int64_t len,
+			  const QueryFile *file,const QueryFilter *filter,
+			  std::vector<QueryHit> *hits);
+  static int64_t scanSegment(const char *data,int64_t len,
+			     const QueryFile *file,const QueryFilter *filter,
+			     std::vector<QueryHit> *hits);
+  static int textTimestamp(const char *data,int64_t len,
+			   const QueryFile *file,int64_t *usec);
+  static bool containsToken(const char *data,int64_t len,
+			    const QByteArray &token);
+
+ private:
+  QueryFile *d_file;
+  int64_t d_begin;
+  int64_t d_end;
+  const QueryFilter *d_filter;
+  std::vector<QueryHit> d_hits;
+};
+
+
+class MainObject : public QObject
+{
+  Q_OBJECT
+ public:
+  MainObject(QObject *parent=0);
+
+ private slots:
+  void followData();
+
+ private:
+  void FindFiles(const QString &path);
+  bool AddFile(const QString &pathname);
+  void PlanText(QueryFile *file);
+  void PlanSegment(QueryFile *file);
+  void Print(std::vector<QueryHit> *hits) const;
+  int64_t TextOffset(const QueryFile *file,int64_t target) const;
+  int64_t ParseDateTime(const QString &str,bool *ok) const;
+  uint32_t ParseFacilities(const QString &str,bool *ok) const;
+  uint32_t ParseSeverities(const QString &str,bool *ok) const;
+  QString d_logroot;
+  QueryFilter d_filter;
+  QList<QueryFile *> d_files;
+  QList<QueryTask *> d_tasks;
+  QHash<QString,int64_t> d_follow_offsets;
+  QHash<QString,ino_t> d_follow_inodes;
+  QStringList d_follow_rotated;
+  QTimer *d_follow_timer;
+  QStringList d_search_paths;
+  int d_skipped_files;
+  bool d_following;
+};
+
+
+#endif  // LWSYSLOG_QUERY_H
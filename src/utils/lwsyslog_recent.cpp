@@ -0,0 +1,156 @@
+// lwsyslog_recent.cpp
+//
+// Show recent messages held in memory by lwsyslogger
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <QCoreApplication>
+#include <QLocalSocket>
+
+#include "../lwsyslogger/recentserver.h"
+#include "cmdswitch.h"
+#include "lwsyslog_recent.h"
+
+MainObject::MainObject(QObject *parent)
+  : QObject(parent)
+{
+  QString socket_path=LWSYSLOG_RECENT_DEFAULT_SOCKET;
+  QString hostname;
+  bool hosts=false;
+  int minutes=0;
+  int lines=0;
+  bool ok=false;
+
+  CmdSwitch *cmd=
+    new CmdSwitch("lwsyslog-recent",VERSION,LWSYSLOG_RECENT_USAGE);
+  for(int i=0;i<cmd->keys();i++) {
+    if(cmd->key(i)=="--socket") {
+      socket_path=cmd->value(i);
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--hosts") {
+      hosts=true;
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--minutes") {
+      minutes=cmd->value(i).toInt(&ok);
+      if((!ok)||(minutes<1)) {
+	fprintf(stderr,"lwsyslog-recent: invalid --minutes value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--lines") {
+      lines=cmd->value(i).toInt(&ok);
+      if((!ok)||(lines<1)) {
+	fprintf(stderr,"lwsyslog-recent: invalid --lines value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+    if((!cmd->processed(i))&&(cmd->key(i).left(1)!="-")) {
+      if(!hostname.isEmpty()) {
+	fprintf(stderr,"lwsyslog-recent: only one hostname may be given\n");
+	exit(1);
+      }
+      hostname=cmd->key(i);
+      cmd->setProcessed(i,true);
+    }
+    if(!cmd->processed(i)) {
+      fprintf(stderr,"lwsyslog-recent: unrecognized option \"%s\"\n",
+	      cmd->key(i).toUtf8().constData());
+      exit(1);
+    }
+  }
+  if(hosts==(!hostname.isEmpty())) {
+    fprintf(stderr,"lwsyslog-recent: give either a hostname or --hosts\n");
+    exit(1);
+  }
+  if(hostname.contains(" ")) {
+    fprintf(stderr,"lwsyslog-recent: invalid hostname\n");
+    exit(1);
+  }
+
+  QByteArray req;
+  if(hosts) {
+    req=RECENTSERVER_HOSTS;
+  }
+  else {
+    qlonglong since=0;
+    if(minutes>0) {
+      since=time(NULL)-60*(qlonglong)minutes;
+    }
+    req=QByteArray(RECENTSERVER_LINES)+" "+hostname.toUtf8()+" "+
+      QByteArray::number(since)+" "+QByteArray::number(lines);
+  }
+  QByteArray reply=Request(socket_path,req+"\n");
+  if(reply.startsWith(RECENTSERVER_ERROR)) {
+    fprintf(stderr,"lwsyslog-recent: request failed [%s]\n",
+	    reply.mid(strlen(RECENTSERVER_ERROR)).trimmed().constData());
+    exit(1);
+  }
+  fwrite(reply.constData(),1,reply.size(),stdout);
+
+  exit(0);
+}
+
+
+QByteArray MainObject::Request(const QString &socket_path,
+			       const QByteArray &req) const
+{
+  QByteArray ret;
+  QLocalSocket *sock=new QLocalSocket();
+
+  //
+  // The server answers a single request, then closes the connection
+  //
+  sock->connectToServer(socket_path);
+  if(!sock->waitForConnected(LWSYSLOG_RECENT_TIMEOUT)) {
+    fprintf(stderr,"lwsyslog-recent: unable to connect to \"%s\" [%s]\n",
+	    socket_path.toUtf8().constData(),
+	    sock->errorString().toUtf8().constData());
+    exit(1);
+  }
+  sock->write(req);
+  while(sock->waitForReadyRead(LWSYSLOG_RECENT_TIMEOUT)) {
+    ret+=sock->readAll();
+  }
+  ret+=sock->readAll();
+  if(sock->state()==QLocalSocket::ConnectedState) {
+    fprintf(stderr,"lwsyslog-recent: timed out waiting for \"%s\"\n",
+	    socket_path.toUtf8().constData());
+    exit(1);
+  }
+  delete sock;
+
+  return ret;
+}
+
+
+int main(int argc,char *argv[])
+{
+  QCoreApplication a(argc,argv);
+
+  new MainObject();
+
+  return a.exec();
+}
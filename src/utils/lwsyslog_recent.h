@@ -0,0 +1,50 @@
+// lwsyslog_recent.h
+//
+// Show recent messages held in memory by lwsyslogger
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef LWSYSLOG_RECENT_H
+#define LWSYSLOG_RECENT_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+
+//
+// Global Definitions
+//
+#define LWSYSLOG_RECENT_USAGE "[--socket=<path>] [--minutes=<num>] [--lines=<num>] <hostname> | --hosts\n\n"
+
+//
+// Defaults
+//
+#define LWSYSLOG_RECENT_DEFAULT_SOCKET "/run/lwsyslogger-recent"
+#define LWSYSLOG_RECENT_TIMEOUT 5000
+
+class MainObject : public QObject
+{
+  Q_OBJECT
+ public:
+  MainObject(QObject *parent=0);
+
+ private:
+  QByteArray Request(const QString &socket_path,const QByteArray &req) const;
+};
+
+
+#endif  // LWSYSLOG_RECENT_H
@@ -0,0 +1,367 @@
+// lwsyslog_search.cpp
+//
+// Substring search of logfiles, using their trigram indexes
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QThread>
+#include <QThreadPool>
+
+#include "../lwsyslogger/archiveformat.h"
+#include "../lwsyslogger/bloomfilter.h"
+#include "../lwsyslogger/storeformat.h"
+#include "../lwsyslogger/trigramindex.h"
+#include "cmdswitch.h"
+#include "lwsyslog_search.h"
+
+static inline char __fold(char c)
+{
+  return ((c>='A')&&(c<='Z'))?c+32:c;
+}
+
+
+SearchTask::SearchTask(const QString &pathname,const QByteArray &pattern,
+		       bool ignore_case)
+  : QRunnable()
+{
+  d_pathname=pathname;
+  d_pattern=pattern;
+  d_ignore_case=ignore_case;
+  if(d_ignore_case) {
+    for(int i=0;i<d_pattern.size();i++) {
+      d_pattern[i]=__fold(d_pattern.at(i));
+    }
+  }
+  d_indexed=false;
+  d_file_bytes=0;
+  d_scanned_bytes=0;
+  setAutoDelete(false);
+}
+
+
+void SearchTask::run()
+{
+  struct stat st;
+  QString err_msg;
+  QList<QPair<int64_t,int64_t> > ranges;
+
+  int fd=open(d_pathname.toUtf8(),O_RDONLY);
+  if(fd<0) {
+    d_error_string=strerror(errno);
+    return;
+  }
+  if(fstat(fd,&st)!=0) {
+    d_error_string=strerror(errno);
+    close(fd);
+    return;
+  }
+  d_file_bytes=st.st_size;
+  if(d_file_bytes==0) {
+    close(fd);
+    return;
+  }
+  void *data=mmap(NULL,d_file_bytes,PROT_READ,MAP_SHARED,fd,0);
+  close(fd);
+  if(data==MAP_FAILED) {
+    d_error_string=strerror(errno);
+    return;
+  }
+
+  //
+  // Rotated logfiles may have an index, which narrows the search down to
+  // the blocks containing every trigram of the pattern.
+  //
+  TrigramIndex *index=new TrigramIndex();
+  if(index->load(TrigramIndex::sidecarPathname(d_pathname),&err_msg)) {
+    d_indexed=true;
+    ranges=index->candidates(d_pattern,d_file_bytes);
+  }
+  else {
+    ranges.push_back(QPair<int64_t,int64_t>(0,d_file_bytes));
+  }
+  delete index;
+  for(int i=0;i<ranges.size();i++) {
+    Scan((const char *)data,ranges.at(i).first,ranges.at(i).second);
+  }
+  munmap(data,d_file_bytes);
+}
+
+
+QString SearchTask::pathname() const
+{
+  return d_pathname;
+}
+
+
+const QByteArray &SearchTask::output() const
+{
+  return d_output;
+}
+
+
+QString SearchTask::errorString() const
+{
+  return d_error_string;
+}
+
+
+bool SearchTask::indexed() const
+{
+  return d_indexed;
+}
+
+
+int64_t SearchTask::fileBytes() const
+{
+  return d_file_bytes;
+}
+
+
+int64_t SearchTask::scannedBytes() const
+{
+  return d_scanned_bytes;
+}
+
+
+void SearchTask::Scan(const char *data,int64_t begin,int64_t end)
+{
+  int64_t pos=begin;
+  const char *match=NULL;
+
+  d_scanned_bytes+=end-begin;
+  while((pos<end)&&((match=Find(data+pos,end-pos))!=NULL)) {
+    int64_t line_begin=match-data;
+    while((line_begin>begin)&&(data[line_begin-1]!='\n')) {
+      line_begin--;
+    }
+    const char *nl=(const char *)memchr(match,'\n',end-(match-data));
+    int64_t line_end=(nl==NULL)?end:(nl-data);
+    d_output+=d_pathname.toUtf8()+":"+
+      QByteArray(data+line_begin,line_end-line_begin)+"\n";
+    pos=line_end+1;
+  }
+}
+
+
+const char *SearchTask::Find(const char *data,int64_t len) const
+{
+  int64_t plen=d_pattern.size();
+  const char *pattern=d_pattern.constData();
+
+  if(!d_ignore_case) {
+    return (const char *)memmem(data,len,pattern,plen);
+  }
+  for(int64_t i=0;(i+plen)<=len;i++) {
+    if(__fold(data[i])==pattern[0]) {
+      int64_t j=1;
+      while((j<plen)&&(__fold(data[i+j])==pattern[j])) {
+	j++;
+      }
+      if(j==plen) {
+	return data+i;
+      }
+    }
+  }
+  return NULL;
+}
+
+
+MainObject::MainObject(QObject *parent)
+  : QObject(parent)
+{
+  QString logroot=LWSYSLOG_SEARCH_DEFAULT_LOGROOT;
+  QByteArray pattern;
+  QStringList paths;
+  QStringList pathnames;
+  bool ignore_case=false;
+  bool stats=false;
+  bool pattern_set=false;
+  bool ok=false;
+  int threads=QThread::idealThreadCount();
+
+  CmdSwitch *cmd=
+    new CmdSwitch("lwsyslog-search",VERSION,LWSYSLOG_SEARCH_USAGE);
+  for(int i=0;i<cmd->keys();i++) {
+    if(cmd->key(i)=="--logroot") {
+      logroot=cmd->value(i);
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--ignore-case") {
+      ignore_case=true;
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--threads") {
+      threads=cmd->value(i).toInt(&ok);
+      if((!ok)||(threads<1)) {
+	fprintf(stderr,"lwsyslog-search: invalid --threads value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--stats") {
+      stats=true;
+      cmd->setProcessed(i,true);
+    }
+    if((!cmd->processed(i))&&(cmd->key(i).left(1)!="-")) {
+      if(pattern_set) {
+	paths.push_back(cmd->key(i));
+      }
+      else {
+	pattern=cmd->key(i).toUtf8();
+	pattern_set=true;
+      }
+      cmd->setProcessed(i,true);
+    }
+    if(!cmd->processed(i)) {
+      fprintf(stderr,"lwsyslog-search: unrecognized option \"%s\"\n",
+	      cmd->key(i).toUtf8().constData());
+      exit(1);
+    }
+  }
+  if(pattern.isEmpty()) {
+    fprintf(stderr,"lwsyslog-search: no pattern given\n");
+    exit(1);
+  }
+  if(paths.isEmpty()) {
+    paths.push_back(logroot);
+  }
+  for(int i=0;i<paths.size();i++) {
+    FindFiles(paths.at(i),&pathnames);
+  }
+  pathnames.sort();
+
+  //
+  // Search each file in parallel, then print the results in file order
+  //
+  QList<SearchTask *> tasks;
+  QThreadPool *pool=new QThreadPool(this);
+  pool->setMaxThreadCount(threads);
+  for(int i=0;i<pathnames.size();i++) {
+    tasks.push_back(new SearchTask(pathnames.at(i),pattern,ignore_case));
+    pool->start(tasks.back());
+  }
+  pool->waitForDone();
+
+  int matched=0;
+  int indexed=0;
+  int64_t file_bytes=0;
+  int64_t scanned_bytes=0;
+  for(int i=0;i<tasks.size();i++) {
+    SearchTask *task=tasks.at(i);
+    if(!task->errorString().isEmpty()) {
+      fprintf(stderr,"lwsyslog-search: unable to read \"%s\" [%s]\n",
+	      task->pathname().toUtf8().constData(),
+	      task->errorString().toUtf8().constData());
+    }
+    fwrite(task->output().constData(),1,task->output().size(),stdout);
+    if(!task->output().isEmpty()) {
+      matched++;
+    }
+    if(task->indexed()) {
+      indexed++;
+    }
+    file_bytes+=task->fileBytes();
+    scanned_bytes+=task->scannedBytes();
+    delete task;
+  }
+  fflush(stdout);
+  if(stats) {
+    fprintf(stderr,
+	    "lwsyslog-search: %d file(s), %d indexed, %d matched; scanned %ld of %ld bytes\n",
+	    pathnames.size(),indexed,matched,scanned_bytes,file_bytes);
+  }
+
+  exit(matched>0?0:1);
+}
+
+
+void MainObject::FindFiles(const QString &path,QStringList *pathnames) const
+{
+  QFileInfo info(path);
+
+  if(info.isDir()) {
+    QDirIterator it(path,QDir::Files,QDirIterator::Subdirectories);
+    while(it.hasNext()) {
+      QString pathname=it.next();
+      if(IsSearchable(pathname)) {
+	pathnames->push_back(pathname);
+      }
+    }
+  }
+  else {
+    if(!info.exists()) {
+      fprintf(stderr,"lwsyslog-search: no such file or directory \"%s\"\n",
+	      path.toUtf8().constData());
+      exit(1);
+    }
+    if(IsSearchable(path)) {
+      pathnames->push_back(path);
+    }
+  }
+}
+
+
+bool MainObject::IsSearchable(const QString &pathname) const
+{
+  //
+  // Skip the sidecars and binary stores, and leave compressed files to
+  // zgrep and friends.
+  //
+  if(pathname.endsWith(BLOOMFILTER_SUFFIX)||
+     pathname.endsWith(TRIGRAMINDEX_SUFFIX)||
+     pathname.endsWith(STORE_SEGMENT_SUFFIX)||
+     pathname.endsWith(STORE_INDEX_SUFFIX)||
+     pathname.endsWith(".tmp")) {
+    return false;
+  }
+  if(pathname.endsWith(ARCHIVE_SUFFIX)) {
+    fprintf(stderr,
+	    "lwsyslog-search: skipping archive \"%s\", use lwsyslog-archive\n",
+	    pathname.toUtf8().constData());
+    return false;
+  }
+  if(pathname.endsWith(".gz")||pathname.endsWith(".xz")||
+     pathname.endsWith(".zst")) {
+    fprintf(stderr,"lwsyslog-search: skipping compressed logfile \"%s\"\n",
+	    pathname.toUtf8().constData());
+    return false;
+  }
+  return true;
+}
+
+
+int main(int argc,char *argv[])
+{
+  QCoreApplication a(argc,argv);
+
+  new MainObject();
+
+  return a.exec();
+}
@@ -0,0 +1,82 @@
+// lwsyslog_search.h
+//
+// Substring search of logfiles, using their trigram indexes
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef LWSYSLOG_SEARCH_H
+#define LWSYSLOG_SEARCH_H
+
+#include <stdint.h>
+
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+#include <QRunnable>
+#include <QString>
+#include <QStringList>
+
+//
+// Global Definitions
+//
+#define LWSYSLOG_SEARCH_USAGE "[--logroot=<dir>] [--ignore-case] [--threads=<num>] [--stats] <pattern> [<path> ...]\n\n"
+
+//
+// Defaults
+//
+#define LWSYSLOG_SEARCH_DEFAULT_LOGROOT "/var/log/lwsyslogger"
+
+class SearchTask : public QRunnable
+{
+ public:
+  SearchTask(const QString &pathname,const QByteArray &pattern,
+	     bool ignore_case);
+  void run();
+  QString pathname() const;
+  const QByteArray &output() const;
+  QString errorString() const;
+  bool indexed() const;
+  int64_t fileBytes() const;
+  int64_t scannedBytes() const;
+
+ private:
+  void Scan(const char *data,int64_t begin,int64_t end);
+  const char *Find(const char *data,int64_t len) const;
+  QString d_pathname;
+  QByteArray d_pattern;
+  bool d_ignore_case;
+  QByteArray d_output;
+  QString d_error_string;
+  bool d_indexed;
+  int64_t d_file_bytes;
+  int64_t d_scanned_bytes;
+};
+
+
+class MainObject : public QObject
+{
+  Q_OBJECT
+ public:
+  MainObject(QObject *parent=0);
+
+ private:
+  void FindFiles(const QString &path,QStringList *pathnames) const;
+  bool IsSearchable(const QString &pathname) const;
+};
+
+
+#endif  // LWSYSLOG_SEARCH_H
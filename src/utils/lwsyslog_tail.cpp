@@ -0,0 +1,201 @@
+// lwsyslog_tail.cpp
+//
+// Follow messages as they are received by lwsyslogger
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <QCoreApplication>
+#include <QHostAddress>
+#include <QLocalSocket>
+#include <QTcpSocket>
+
+#include "../lwsyslogger/livetailserver.h"
+#include "cmdswitch.h"
+#include "lwsyslog_tail.h"
+
+MainObject::MainObject(QObject *parent)
+  : QObject(parent)
+{
+  QString socket_path;
+  QString address=LWSYSLOG_TAIL_DEFAULT_ADDRESS;
+  unsigned port=0;
+  QStringList terms;
+  bool ok=false;
+
+  d_socket=NULL;
+  d_accepted=false;
+
+  CmdSwitch *cmd=new CmdSwitch("lwsyslog-tail",VERSION,LWSYSLOG_TAIL_USAGE);
+  for(int i=0;i<cmd->keys();i++) {
+    if(cmd->key(i)=="--socket") {
+      socket_path=cmd->value(i);
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--address") {
+      address=cmd->value(i);
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--port") {
+      port=cmd->value(i).toUInt(&ok);
+      if((!ok)||(port<1)||(port>0xFFFF)) {
+	fprintf(stderr,"lwsyslog-tail: invalid --port value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--facility") {
+      terms.push_back("facility="+Quote(cmd->value(i)));
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--severity") {
+      terms.push_back("severity="+Quote(cmd->value(i)));
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--host") {
+      terms.push_back("host="+Quote(cmd->value(i)));
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--match") {
+      terms.push_back("match="+Quote(cmd->value(i)));
+      cmd->setProcessed(i,true);
+    }
+    if(!cmd->processed(i)) {
+      fprintf(stderr,"lwsyslog-tail: unrecognized option \"%s\"\n",
+	      cmd->key(i).toUtf8().constData());
+      exit(1);
+    }
+  }
+  if((port>0)&&(!socket_path.isEmpty())) {
+    fprintf(stderr,
+	    "lwsyslog-tail: --socket and --port are mutually exclusive\n");
+    exit(1);
+  }
+  if(socket_path.isEmpty()) {
+    socket_path=LWSYSLOG_TAIL_DEFAULT_SOCKET;
+  }
+  d_filter=terms.join(" ");
+  if(d_filter.contains("\n")) {
+    fprintf(stderr,"lwsyslog-tail: filter values cannot contain newlines\n");
+    exit(1);
+  }
+
+  //
+  // Open the connection
+  //
+  if(port>0) {
+    QHostAddress addr;
+    if(!addr.setAddress(address)) {
+      fprintf(stderr,"lwsyslog-tail: invalid --address value\n");
+      exit(1);
+    }
+    QTcpSocket *sock=new QTcpSocket(this);
+    connect(sock,SIGNAL(connected()),this,SLOT(connectedData()));
+    connect(sock,SIGNAL(disconnected()),this,SLOT(disconnectedData()));
+    connect(sock,SIGNAL(error(QAbstractSocket::SocketError)),
+	    this,SLOT(disconnectedData()));
+    d_socket=sock;
+    connect(d_socket,SIGNAL(readyRead()),this,SLOT(readyReadData()));
+    sock->connectToHost(addr,port);
+  }
+  else {
+    QLocalSocket *sock=new QLocalSocket(this);
+    connect(sock,SIGNAL(connected()),this,SLOT(connectedData()));
+    connect(sock,SIGNAL(disconnected()),this,SLOT(disconnectedData()));
+    connect(sock,SIGNAL(error(QLocalSocket::LocalSocketError)),
+	    this,SLOT(disconnectedData()));
+    d_socket=sock;
+    connect(d_socket,SIGNAL(readyRead()),this,SLOT(readyReadData()));
+    sock->connectToServer(socket_path);
+  }
+}
+
+
+void MainObject::connectedData()
+{
+  d_socket->write((d_filter+"\n").toUtf8());
+}
+
+
+void MainObject::readyReadData()
+{
+  while(d_socket->canReadLine()) {
+    QByteArray line=d_socket->readLine();
+
+    //
+    // The first line is the server's reply to our filter, after which
+    // everything is message data except for lag notices.
+    //
+    if(!d_accepted) {
+      line=line.trimmed();
+      if(line==LIVETAILSERVER_OK) {
+	d_accepted=true;
+	continue;
+      }
+      if(line.startsWith(LIVETAILSERVER_ERROR)) {
+	fprintf(stderr,"lwsyslog-tail: filter rejected [%s]\n",
+		line.mid(strlen(LIVETAILSERVER_ERROR)).trimmed().constData());
+      }
+      else {
+	fprintf(stderr,"lwsyslog-tail: unexpected reply from server\n");
+      }
+      exit(1);
+    }
+    if(line.startsWith(LIVETAILSERVER_LAGGED " ")) {
+      fprintf(stderr,"lwsyslog-tail: fell behind, %s messages skipped\n",
+	      line.mid(strlen(LIVETAILSERVER_LAGGED)+1).trimmed().constData());
+      continue;
+    }
+    fwrite(line.constData(),1,line.size(),stdout);
+  }
+  fflush(stdout);
+}
+
+
+void MainObject::disconnectedData()
+{
+  if(!d_accepted) {
+    fprintf(stderr,"lwsyslog-tail: unable to connect [%s]\n",
+	    d_socket->errorString().toUtf8().constData());
+    exit(1);
+  }
+  fprintf(stderr,"lwsyslog-tail: server closed the connection\n");
+  exit(1);
+}
+
+
+QString MainObject::Quote(const QString &str)
+{
+  if(str.contains("\"")) {
+    fprintf(stderr,"lwsyslog-tail: filter values cannot contain '\"'\n");
+    exit(1);
+  }
+  return "\""+str+"\"";
+}
+
+
+int main(int argc,char *argv[])
+{
+  QCoreApplication a(argc,argv);
+
+  new MainObject();
+
+  return a.exec();
+}
@@ -0,0 +1,60 @@
+// lwsyslog_tail.h
+//
+// Follow messages as they are received by lwsyslogger
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef LWSYSLOG_TAIL_H
+#define LWSYSLOG_TAIL_H
+
+#include <stdint.h>
+
+#include <QIODevice>
+#include <QObject>
+#include <QString>
+
+//
+// Global Definitions
+//
+#define LWSYSLOG_TAIL_USAGE "[--socket=<path>] [--address=<addr> --port=<port>] [--facility=<list>] [--severity=<list>] [--host=<glob>] [--match=<string>]\n\n"
+
+//
+// Defaults
+//
+#define LWSYSLOG_TAIL_DEFAULT_SOCKET "/run/lwsyslogger-livetail"
+#define LWSYSLOG_TAIL_DEFAULT_ADDRESS "127.0.0.1"
+
+class MainObject : public QObject
+{
+  Q_OBJECT
+ public:
+  MainObject(QObject *parent=0);
+
+ private slots:
+  void connectedData();
+  void readyReadData();
+  void disconnectedData();
+
+ private:
+  static QString Quote(const QString &str);
+  QIODevice *d_socket;
+  QString d_filter;
+  bool d_accepted;
+};
+
+
+#endif  // LWSYSLOG_TAIL_H